@@ -0,0 +1,60 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <graph_segment/graph_segment.hpp>
+#include <lsd/lsd.hpp>
+#include <rclcpp/rclcpp.hpp>
+#include <segment_filter/segment_filter.hpp>
+#include <yabloc_common/latest_only_subscription.hpp>
+#include <yabloc_common/stage_stamp_publisher.hpp>
+#include <yabloc_common/thread_pool.hpp>
+#include <yabloc_common/trace_reporter.hpp>
+
+#include <sensor_msgs/msg/image.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace yabloc::fused_imgproc
+{
+// lsd, graph_segment and segment_filter in a single process. An undistorted image is decoded
+// once, lsd and graph_segment run on it concurrently, and their outputs are passed on to
+// segment_filter without publishing. The stages are the original nodes which are constructed
+// with standalone = false, so that their parameters, debug outputs and the other subscriptions
+// (camera_info, tf, twist, ground) are kept as they are.
+class FusedImgproc : public rclcpp::Node
+{
+public:
+  using Image = sensor_msgs::msg::Image;
+
+  explicit FusedImgproc(const rclcpp::NodeOptions & options = rclcpp::NodeOptions());
+
+  // They have to be spun by the same executor as this node
+  std::vector<rclcpp::Node::SharedPtr> stage_nodes() const;
+
+private:
+  // Both tasks are running at the same time, so the pool has two threads
+  common::ThreadPool thread_pool_{2};
+  common::TraceReporter trace_reporter_{this};
+  common::StageStampPublisher stage_stamp_{this, "fused_imgproc"};
+
+  std::shared_ptr<lsd::LineSegmentDetector> lsd_;
+  std::shared_ptr<graph_segment::GraphSegment> graph_segment_;
+  std::shared_ptr<segment_filter::SegmentFilter> segment_filter_;
+  common::LatestOnlySubscription<Image>::SharedPtr sub_image_;
+
+  void on_image(const Image & msg);
+};
+}  // namespace yabloc::fused_imgproc
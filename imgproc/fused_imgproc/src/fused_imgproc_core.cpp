@@ -0,0 +1,63 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "fused_imgproc/fused_imgproc.hpp"
+
+#include <yabloc_common/cv_decompress.hpp>
+#include <yabloc_common/trace.hpp>
+
+namespace yabloc::fused_imgproc
+{
+FusedImgproc::FusedImgproc(const rclcpp::NodeOptions & options) : Node("fused_imgproc", options)
+{
+  using std::placeholders::_1;
+
+  // The stages share the arguments of this node, e.g. remappings and parameters
+  rclcpp::NodeOptions stage_options = options;
+  stage_options.append_parameter_override("standalone", false);
+  lsd_ = std::make_shared<lsd::LineSegmentDetector>(stage_options);
+  graph_segment_ = std::make_shared<graph_segment::GraphSegment>(stage_options);
+  segment_filter_ = std::make_shared<segment_filter::SegmentFilter>(stage_options);
+
+  // Subscriber
+  sub_image_ = std::make_shared<common::LatestOnlySubscription<Image>>(
+    this, "src_image", 10, std::bind(&FusedImgproc::on_image, this, _1),
+    declare_parameter<bool>("latest_only", true));
+  stage_stamp_.set_drop_counter([this]() { return sub_image_->dropped_count(); });
+}
+
+std::vector<rclcpp::Node::SharedPtr> FusedImgproc::stage_nodes() const
+{
+  return {lsd_, graph_segment_, segment_filter_};
+}
+
+void FusedImgproc::on_image(const Image & msg)
+{
+  YABLOC_TRACE_SCOPE("fused_imgproc/on_image");
+  const auto start = stage_stamp_.start();
+  const rclcpp::Time stamp = msg.header.stamp;
+
+  // Both stages only read the image, so it is shared without copying
+  const cv::Mat image = common::decompress_to_cv_mat(msg);
+  auto line_segments = thread_pool_.submit([&]() { return lsd_->process(image, stamp); });
+  auto mask = thread_pool_.submit([&]() { return graph_segment_->process(image, stamp); });
+
+  // Wait for both before get() rethrows an exception, as they refer to the image on this stack
+  line_segments.wait();
+  mask.wait();
+  segment_filter_->execute(line_segments.get(), mask.get());
+
+  stage_stamp_.publish(stamp, start);
+}
+}  // namespace yabloc::fused_imgproc
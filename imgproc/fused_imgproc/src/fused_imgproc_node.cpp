@@ -0,0 +1,29 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "fused_imgproc/fused_imgproc.hpp"
+
+int main(int argc, char * argv[])
+{
+  rclcpp::init(argc, argv);
+  auto node = std::make_shared<yabloc::fused_imgproc::FusedImgproc>();
+
+  rclcpp::executors::SingleThreadedExecutor executor;
+  executor.add_node(node);
+  for (const auto & stage_node : node->stage_nodes()) executor.add_node(stage_node);
+  executor.spin();
+
+  rclcpp::shutdown();
+  return 0;
+}
@@ -13,14 +13,24 @@
 // limitations under the License.
 
 #pragma once
+#include "graph_segment/label_statistics.hpp"
+#include "graph_segment/road_mask_tracker.hpp"
 #include "graph_segment/similar_area_searcher.hpp"
 
 #include <opencv4/opencv2/ximgproc/segmentation.hpp>
 #include <rclcpp/rclcpp.hpp>
+#include <yabloc_common/camera_info_subscriber.hpp>
+#include <yabloc_common/latest_only_subscription.hpp>
+#include <yabloc_common/stage_stamp_publisher.hpp>
+#include <yabloc_common/static_tf_subscriber.hpp>
+#include <yabloc_common/trace_reporter.hpp>
 
+#include <geometry_msgs/msg/twist_with_covariance_stamped.hpp>
 #include <sensor_msgs/msg/image.hpp>
 #include <sensor_msgs/msg/point_cloud2.hpp>
 
+#include <optional>
+
 namespace yabloc::graph_segment
 {
 class GraphSegment : public rclcpp::Node
@@ -28,21 +38,45 @@ class GraphSegment : public rclcpp::Node
 public:
   using PointCloud2 = sensor_msgs::msg::PointCloud2;
   using Image = sensor_msgs::msg::Image;
-  GraphSegment();
+  using TwistCovStamped = geometry_msgs::msg::TwistWithCovarianceStamped;
+  explicit GraphSegment(const rclcpp::NodeOptions & options = rclcpp::NodeOptions());
+
+  // Segment the road in a decoded bgr8 image and return its mask in the same size as mask_image.
+  // fused_imgproc calls this directly instead of the subscription.
+  cv::Mat process(const cv::Mat & image, const rclcpp::Time & stamp);
 
 private:
+  const bool standalone_;
   const float target_height_ratio_;
   const int target_candidate_box_width_;
+  const int segmentation_interval_;
 
-  rclcpp::Subscription<Image>::SharedPtr sub_image_;
+  common::LatestOnlySubscription<Image>::SharedPtr sub_image_;
+  rclcpp::Subscription<TwistCovStamped>::SharedPtr sub_twist_;
   rclcpp::Publisher<Image>::SharedPtr pub_mask_image_;
   rclcpp::Publisher<Image>::SharedPtr pub_debug_image_;
   cv::Ptr<cv::ximgproc::segmentation::GraphSegmentation> segmentation_;
   std::unique_ptr<SimilarAreaSearcher> similar_area_searcher_{nullptr};
 
+  // Between segmentations, the mask is propagated by the ego-motion
+  std::unique_ptr<RoadMaskTracker> mask_tracker_{nullptr};
+  common::CameraInfoSubscriber info_;
+  common::StaticTfSubscriber tf_subscriber_;
+  std::optional<TwistCovStamped> latest_twist_{std::nullopt};
+  std::optional<rclcpp::Time> last_stamp_{std::nullopt};
+  int frame_count_{0};
+  common::TraceReporter trace_reporter_{this};
+  common::StageStampPublisher stage_stamp_{this, "graph_segment"};
+
   void on_image(const Image & msg);
 
-  int search_most_road_like_class(const cv::Mat & segmented) const;
+  cv::Mat segment_road(const cv::Mat & resized, cv::Mat & debug_image);
+
+  // Homography on the ground plane which maps the previous image onto the current image
+  std::optional<cv::Mat> ego_motion_homography(const cv::Size & size, const rclcpp::Time & stamp);
+
+  // The most road-like segment is the largest one which appears in this box
+  cv::Rect target_candidate_box(const cv::Size & size) const;
 
   void draw_and_publish_image(
     const cv::Mat & raw_image, const cv::Mat & debug_image, const rclcpp::Time & stamp);
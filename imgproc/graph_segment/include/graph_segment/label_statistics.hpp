@@ -0,0 +1,51 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <Eigen/Core>
+#include <opencv4/opencv2/core.hpp>
+
+#include <vector>
+
+namespace yabloc::graph_segment
+{
+// Per-label statistics of a segmented image stored in flat arrays indexed by the label.
+// graph segmentation gives consecutive labels from 0, so no hash map is needed.
+struct LabelStatistics
+{
+  explicit LabelStatistics(int bin = 10) : bin(bin) {}
+
+  const int bin;
+  std::vector<int> areas;
+  // 3 x bin histogram of each label in the same column-major layout as Histogram::data
+  std::vector<float> histograms;
+
+  int label_count() const { return static_cast<int>(areas.size()); }
+
+  // Normalized histogram, which is equivalent to Histogram::eval()
+  Eigen::MatrixXf eval_histogram(int label) const;
+};
+
+// Compute area and (optionally) color histogram of all labels in a single scan
+LabelStatistics compute_label_statistics(
+  const cv::Mat & segmented, const cv::Mat & bgr_image, bool with_histogram, int bin = 10);
+
+// Return the largest label among those which appear in target_box, or -1 if there is none
+int search_most_road_like_class(
+  const cv::Mat & segmented, const LabelStatistics & statistics, const cv::Rect & target_box);
+
+// Convert the label image into a byte image through a label -> byte lookup table
+cv::Mat apply_label_lut(const cv::Mat & segmented, const std::vector<uchar> & lut);
+cv::Mat apply_label_lut(const cv::Mat & segmented, const std::vector<cv::Vec3b> & lut);
+}  // namespace yabloc::graph_segment
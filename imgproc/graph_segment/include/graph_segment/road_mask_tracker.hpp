@@ -0,0 +1,57 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <opencv4/opencv2/core.hpp>
+
+#include <vector>
+
+namespace yabloc::graph_segment
+{
+// Propagate a road mask between graph segmentations.
+// The mask of the last keyframe is warped by the ground homography of the ego-motion, and then
+// corrected with a color model of the road which is updated on every frame.
+class RoadMaskTracker
+{
+public:
+  RoadMaskTracker(float learning_rate, float road_probability_threshold);
+
+  // Replace the mask and the color model with the result of the full segmentation
+  void reset(const cv::Mat & bgr_image, const cv::Mat & mask);
+
+  // Return the road mask of bgr_image. homography maps the previous image onto the current one.
+  cv::Mat track(const cv::Mat & bgr_image, const cv::Mat & homography);
+
+  bool is_initialized() const { return !mask_.empty(); }
+
+private:
+  // Joint BGR histogram with 8 bins per channel
+  static constexpr int BIN_SHIFT = 5;
+  static constexpr int BIN_COUNT = 1 << (3 * (8 - BIN_SHIFT));
+
+  const float learning_rate_;
+  const float road_probability_threshold_;
+
+  cv::Mat mask_;
+  std::vector<float> road_histogram_;
+  std::vector<float> background_histogram_;
+
+  static int color_index(const cv::Vec3b & bgr)
+  {
+    return (bgr[0] >> BIN_SHIFT) << 6 | (bgr[1] >> BIN_SHIFT) << 3 | (bgr[2] >> BIN_SHIFT);
+  }
+
+  void update_color_model(const cv::Mat & bgr_image, const cv::Mat & mask, float rate);
+};
+}  // namespace yabloc::graph_segment
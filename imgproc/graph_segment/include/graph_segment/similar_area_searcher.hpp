@@ -13,11 +13,13 @@
 // limitations under the License.
 
 #pragma once
+#include "graph_segment/label_statistics.hpp"
+
 #include <Eigen/Core>
 #include <opencv4/opencv2/core.hpp>
 #include <rclcpp/logger.hpp>
 
-#include <set>
+#include <vector>
 
 namespace yabloc::graph_segment
 {
@@ -30,8 +32,8 @@ public:
   {
   }
 
-  std::set<int> search(
-    const cv::Mat & rgb_image, const cv::Mat & segmented, int best_roadlike_class);
+  // statistics must be computed with histograms
+  std::vector<int> search(const LabelStatistics & statistics, int best_roadlike_class);
 
 private:
   const float similarity_score_threshold_;
@@ -15,24 +15,38 @@
 #include "graph_segment/graph_segment.hpp"
 #include "graph_segment/histogram.hpp"
 
+#include <Eigen/Geometry>
 #include <opencv4/opencv2/highgui.hpp>
 #include <opencv4/opencv2/imgproc.hpp>
 #include <yabloc_common/cv_decompress.hpp>
 #include <yabloc_common/pub_sub.hpp>
-#include <yabloc_common/timer.hpp>
+#include <yabloc_common/trace.hpp>
 
 namespace yabloc::graph_segment
 {
-GraphSegment::GraphSegment()
-: Node("graph_segment"),
+GraphSegment::GraphSegment(const rclcpp::NodeOptions & options)
+: Node("graph_segment", options),
+  standalone_(declare_parameter<bool>("standalone", true)),
   target_height_ratio_(declare_parameter<float>("target_height_ratio", 0.85)),
-  target_candidate_box_width_(declare_parameter<int>("target_candidate_box_width", 15))
+  target_candidate_box_width_(declare_parameter<int>("target_candidate_box_width", 15)),
+  segmentation_interval_(declare_parameter<int>("segmentation_interval", 1)),
+  info_(this),
+  tf_subscriber_(this->get_clock())
 {
   using std::placeholders::_1;
 
   // Subscriber
-  sub_image_ =
-    create_subscription<Image>("src_image", 10, std::bind(&GraphSegment::on_image, this, _1));
+  // Without standalone, the frames are given through process() by fused_imgproc.
+  // latest_only is off by default, since frames skipped here and not in the other branch leave
+  // segment_filter without a pair. undistort skips frames for both branches.
+  if (standalone_) {
+    sub_image_ = std::make_shared<common::LatestOnlySubscription<Image>>(
+      this, "src_image", 10, std::bind(&GraphSegment::on_image, this, _1),
+      declare_parameter<bool>("latest_only", false));
+    stage_stamp_.set_drop_counter([this]() { return sub_image_->dropped_count(); });
+  }
+  auto on_twist = [this](const TwistCovStamped & msg) -> void { latest_twist_ = msg; };
+  sub_twist_ = create_subscription<TwistCovStamped>("twist_cov", 10, std::move(on_twist));
 
   pub_mask_image_ = create_publisher<Image>("mask_image", 10);
   pub_debug_image_ = create_publisher<Image>("segmented_image", 10);
@@ -47,6 +61,13 @@ GraphSegment::GraphSegment()
     similar_area_searcher_ = std::make_unique<SimilarAreaSearcher>(
       declare_parameter<float>("similarity_score_threshold", 0.8));
   }
+
+  // road mask tracking module, which runs the segmentation only every segmentation_interval frames
+  if (segmentation_interval_ > 1) {
+    mask_tracker_ = std::make_unique<RoadMaskTracker>(
+      declare_parameter<float>("tracking_learning_rate", 0.2),
+      declare_parameter<float>("tracking_probability_threshold", 0.6));
+  }
 }
 
 cv::Vec3b random_hsv(int index)
@@ -55,83 +76,138 @@ cv::Vec3b random_hsv(int index)
   return cv::Vec3b(fmod(base, 1.2) * 255, 0.7 * 255, 0.5 * 255);
 };
 
-int GraphSegment::search_most_road_like_class(const cv::Mat & segmented) const
+cv::Rect GraphSegment::target_candidate_box(const cv::Size & size) const
 {
   const int W = target_candidate_box_width_;
   const float R = target_height_ratio_;
-  cv::Point2i target_px(segmented.cols * 0.5, segmented.rows * R);
-  cv::Rect2i rect(target_px + cv::Point2i(-W, -W), target_px + cv::Point2i(W, W));
-
-  std::unordered_map<int, int> areas;
-  std::unordered_set<int> candidates;
-  for (int h = 0; h < segmented.rows; h++) {
-    const int * seg_ptr = segmented.ptr<int>(h);
-    for (int w = 0; w < segmented.cols; w++) {
-      int key = seg_ptr[w];
-      if (areas.count(key) == 0) areas[key] = 0;
-      areas[key]++;
-      if (rect.contains(cv::Point2i{w, h})) candidates.insert(key);
-    }
-  }
-
-  // Search the largest area and its class
-  int max_area = 0;
-  int max_area_class = -1;
-  for (int c : candidates) {
-    if (areas.at(c) < max_area) continue;
-    max_area = areas.at(c);
-    max_area_class = c;
-  }
-  return max_area_class;
+  cv::Point2i target_px(size.width * 0.5, size.height * R);
+  return cv::Rect2i(target_px + cv::Point2i(-W, -W), target_px + cv::Point2i(W, W));
 }
 
 void GraphSegment::on_image(const Image & msg)
 {
-  cv::Mat image = common::decompress_to_cv_mat(msg);
+  YABLOC_TRACE_SCOPE("graph_segment/on_image");
+  process(common::decompress_to_cv_mat(msg), msg.header.stamp);
+}
+
+cv::Mat GraphSegment::process(const cv::Mat & image, const rclcpp::Time & stamp)
+{
+  YABLOC_TRACE_SCOPE("graph_segment/process");
+  const auto start = stage_stamp_.start();
   cv::Mat resized;
   cv::resize(image, resized, cv::Size(), 0.5, 0.5);
 
+  std::optional<cv::Mat> homography = std::nullopt;
+  const bool is_keyframe = (frame_count_++ % std::max(segmentation_interval_, 1)) == 0;
+  if (mask_tracker_ && mask_tracker_->is_initialized() && !is_keyframe) {
+    homography = ego_motion_homography(resized.size(), stamp);
+  }
+  last_stamp_ = stamp;
+
+  cv::Mat output_image;
+  cv::Mat debug_image;
+  if (homography.has_value()) {
+    YABLOC_TRACE_SCOPE("graph_segment/track");
+    output_image = mask_tracker_->track(resized, homography.value());
+    debug_image = cv::Mat::zeros(resized.size(), CV_8UC3);
+    debug_image.setTo(cv::Scalar(30, 255, 255), output_image);
+  } else {
+    output_image = segment_road(resized, debug_image);
+    if (mask_tracker_) mask_tracker_->reset(resized, output_image);
+  }
+
+  cv::cvtColor(debug_image, debug_image, cv::COLOR_HSV2BGR);
+  cv::resize(output_image, output_image, image.size(), 0, 0, cv::INTER_NEAREST);
+  cv::resize(debug_image, debug_image, image.size(), 0, 0, cv::INTER_NEAREST);
+
+  // When fused, the mask is handed over directly and published only for visualization
+  if (standalone_ || pub_mask_image_->get_subscription_count() > 0)
+    common::publish_image(*pub_mask_image_, output_image, stamp);
+
+  draw_and_publish_image(image, debug_image, stamp);
+  stage_stamp_.publish(stamp, start);
+  return output_image;
+}
+
+cv::Mat GraphSegment::segment_road(const cv::Mat & resized, cv::Mat & debug_image)
+{
+  YABLOC_TRACE_SCOPE("graph_segment/segment");
+
   // Execute graph-based segmentation
-  common::Timer timer;
   cv::Mat segmented;
   segmentation_->processImage(resized, segmented);
-  RCLCPP_INFO_STREAM(get_logger(), "segmentation time: " << timer);
-
-  //
-  int target_class = search_most_road_like_class(segmented);
-  //
-  std::set<int> road_keys = {target_class};
-  if (similar_area_searcher_) {
-    road_keys = similar_area_searcher_->search(resized, segmented, target_class);
+
+  const LabelStatistics statistics =
+    compute_label_statistics(segmented, resized, similar_area_searcher_ != nullptr);
+  const int target_class =
+    search_most_road_like_class(segmented, statistics, target_candidate_box(segmented.size()));
+
+  std::vector<int> road_keys = {target_class};
+  if (similar_area_searcher_ && target_class >= 0) {
+    road_keys = similar_area_searcher_->search(statistics, target_class);
   }
 
-  // Draw output image and debug image
-  // TODO: use ptr instead of at()
-  cv::Mat output_image = cv::Mat::zeros(resized.size(), CV_8UC1);
-  cv::Mat debug_image = cv::Mat::zeros(resized.size(), CV_8UC3);
-  for (int h = 0; h < resized.rows; h++) {
-    for (int w = 0; w < resized.cols; w++) {
-      cv::Point2i px(w, h);
-      int key = segmented.at<int>(px);
-      if (road_keys.count(key) > 0) {
-        output_image.at<uchar>(px) = 255;
-        if (key == target_class)
-          debug_image.at<cv::Vec3b>(px) = cv::Vec3b(30, 255, 255);
-        else
-          debug_image.at<cv::Vec3b>(px) = cv::Vec3b(10, 255, 255);
-      } else {
-        debug_image.at<cv::Vec3b>(px) = random_hsv(key);
-      }
-    }
+  // Draw output image and debug image through label lookup tables
+  std::vector<uchar> mask_lut(statistics.label_count(), 0);
+  std::vector<cv::Vec3b> debug_lut(statistics.label_count());
+  for (int key = 0; key < statistics.label_count(); key++) debug_lut[key] = random_hsv(key);
+  for (int key : road_keys) {
+    if (key < 0) continue;
+    mask_lut[key] = 255;
+    debug_lut[key] = (key == target_class) ? cv::Vec3b(30, 255, 255) : cv::Vec3b(10, 255, 255);
   }
-  cv::cvtColor(debug_image, debug_image, cv::COLOR_HSV2BGR);
-  cv::resize(output_image, output_image, image.size(), 0, 0, cv::INTER_NEAREST);
-  cv::resize(debug_image, debug_image, image.size(), 0, 0, cv::INTER_NEAREST);
 
-  common::publish_image(*pub_mask_image_, output_image, msg.header.stamp);
+  cv::Mat output_image = apply_label_lut(segmented, mask_lut);
+  debug_image = apply_label_lut(segmented, debug_lut);
+  return output_image;
+}
 
-  draw_and_publish_image(image, debug_image, msg.header.stamp);
-  RCLCPP_INFO_STREAM(get_logger(), "total processing time: " << timer);
+std::optional<cv::Mat> GraphSegment::ego_motion_homography(
+  const cv::Size & size, const rclcpp::Time & stamp)
+{
+  if (!last_stamp_.has_value() || !latest_twist_.has_value()) return std::nullopt;
+  if (info_.is_camera_info_nullopt()) return std::nullopt;
+
+  std::optional<Eigen::Affine3f> camera_extrinsic =
+    tf_subscriber_(info_.get_frame_id(), "base_link");
+  if (!camera_extrinsic.has_value()) return std::nullopt;
+
+  const float dt = (stamp - last_stamp_.value()).seconds();
+  if (dt <= 0 || dt > 1.0) return std::nullopt;
+
+  // Intrinsic at the resolution of segmentation
+  Eigen::Matrix3f K = info_.intrinsic();
+  K.topRows(2) *= static_cast<float>(size.width) / info_.size().x();
+  const Eigen::Matrix3f Kinv = K.inverse();
+
+  // Pose of the current base_link seen from the previous base_link
+  const auto & twist = latest_twist_->twist.twist;
+  const Eigen::Vector3f translation(twist.linear.x * dt, twist.linear.y * dt, 0);
+  const Eigen::Affine3f motion = Eigen::Translation3f(translation) *
+                                 Eigen::AngleAxisf(twist.angular.z * dt, Eigen::Vector3f::UnitZ());
+  const Eigen::Affine3f previous_to_current = motion.inverse();
+  const Eigen::Affine3f & T = camera_extrinsic.value();
+  const Eigen::Affine3f T_inv = T.inverse();
+
+  // Four pixels in the lower part of the image are moved along the ground plane (z = 0)
+  std::vector<cv::Point2f> src, dst;
+  for (float v_ratio : {0.75f, 0.95f}) {
+    for (float u_ratio : {0.25f, 0.75f}) {
+      const Eigen::Vector3f u3(u_ratio * size.width, v_ratio * size.height, 1);
+      const Eigen::Vector3f bearing = (T.rotation() * Kinv * u3).normalized();
+      if (bearing.z() > -0.01) return std::nullopt;
+
+      const float distance = -T.translation().z() / bearing.z();
+      const Eigen::Vector3f ground = T.translation() + bearing * distance;
+      const Eigen::Vector3f in_camera = T_inv * (previous_to_current * ground);
+      if (in_camera.z() < 0.1) return std::nullopt;
+
+      const Eigen::Vector3f projected = K * in_camera;
+      src.emplace_back(u3.x(), u3.y());
+      dst.emplace_back(projected.x() / projected.z(), projected.y() / projected.z());
+    }
+  }
+  return cv::getPerspectiveTransform(src, dst);
 }
 
 void GraphSegment::draw_and_publish_image(
@@ -0,0 +1,113 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "graph_segment/label_statistics.hpp"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+namespace yabloc::graph_segment
+{
+Eigen::MatrixXf LabelStatistics::eval_histogram(int label) const
+{
+  Eigen::Map<const Eigen::MatrixXf> data(histograms.data() + label * 3 * bin, 3, bin);
+  float sum = data.sum();
+  if (sum < 1e-6f) throw std::runtime_error("invalid division");
+  return data / sum;
+}
+
+LabelStatistics compute_label_statistics(
+  const cv::Mat & segmented, const cv::Mat & bgr_image, bool with_histogram, int bin)
+{
+  LabelStatistics statistics(bin);
+
+  // Bin index of each intensity, which is the same as Histogram::add()
+  std::array<int, 256> bin_lut;
+  for (int i = 0; i < 256; i++) {
+    bin_lut[i] = std::clamp(static_cast<int>(i * bin / 255.f), 0, bin - 1);
+  }
+
+  auto grow = [&](int label) -> void {
+    const int size = label + 1;
+    statistics.areas.resize(size, 0);
+    if (with_histogram) statistics.histograms.resize(size * 3 * bin, 0.f);
+  };
+
+  for (int h = 0; h < segmented.rows; h++) {
+    const int * seg_ptr = segmented.ptr<int>(h);
+    const cv::Vec3b * bgr_ptr = with_histogram ? bgr_image.ptr<cv::Vec3b>(h) : nullptr;
+    for (int w = 0; w < segmented.cols; w++) {
+      const int label = seg_ptr[w];
+      if (label >= statistics.label_count()) grow(label);
+
+      statistics.areas[label]++;
+
+      if (with_histogram) {
+        float * histogram = statistics.histograms.data() + label * 3 * bin;
+        for (int ch = 0; ch < 3; ++ch) histogram[bin_lut[bgr_ptr[w][ch]] * 3 + ch] += 1.0f;
+      }
+    }
+  }
+  return statistics;
+}
+
+int search_most_road_like_class(
+  const cv::Mat & segmented, const LabelStatistics & statistics, const cv::Rect & target_box)
+{
+  // Only the pixels inside the box have to be visited because the areas are already known
+  const cv::Rect box = target_box & cv::Rect(0, 0, segmented.cols, segmented.rows);
+
+  int max_area = 0;
+  int max_area_class = -1;
+  for (int h = box.y; h < box.br().y; h++) {
+    const int * seg_ptr = segmented.ptr<int>(h);
+    for (int w = box.x; w < box.br().x; w++) {
+      const int label = seg_ptr[w];
+      if (statistics.areas[label] < max_area) continue;
+      max_area = statistics.areas[label];
+      max_area_class = label;
+    }
+  }
+  return max_area_class;
+}
+
+template <typename T>
+cv::Mat apply_label_lut_impl(const cv::Mat & segmented, const std::vector<T> & lut)
+{
+  // cv::LUT() accepts only 8bit indices, so the 32bit labels are gathered through row pointers
+  cv::Mat output(segmented.size(), cv::DataType<T>::type);
+  const int cols = segmented.cols;
+  const T * const table = lut.data();
+
+  cv::parallel_for_(cv::Range(0, segmented.rows), [&](const cv::Range & range) {
+    for (int h = range.start; h < range.end; h++) {
+      const int * __restrict seg_ptr = segmented.ptr<int>(h);
+      T * __restrict out_ptr = output.ptr<T>(h);
+      for (int w = 0; w < cols; w++) out_ptr[w] = table[seg_ptr[w]];
+    }
+  });
+  return output;
+}
+
+cv::Mat apply_label_lut(const cv::Mat & segmented, const std::vector<uchar> & lut)
+{
+  return apply_label_lut_impl(segmented, lut);
+}
+
+cv::Mat apply_label_lut(const cv::Mat & segmented, const std::vector<cv::Vec3b> & lut)
+{
+  return apply_label_lut_impl(segmented, lut);
+}
+}  // namespace yabloc::graph_segment
@@ -0,0 +1,97 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "graph_segment/road_mask_tracker.hpp"
+
+#include <opencv4/opencv2/imgproc.hpp>
+
+namespace yabloc::graph_segment
+{
+RoadMaskTracker::RoadMaskTracker(float learning_rate, float road_probability_threshold)
+: learning_rate_(learning_rate), road_probability_threshold_(road_probability_threshold)
+{
+}
+
+void RoadMaskTracker::reset(const cv::Mat & bgr_image, const cv::Mat & mask)
+{
+  mask_ = mask.clone();
+  road_histogram_.assign(BIN_COUNT, 0.f);
+  background_histogram_.assign(BIN_COUNT, 0.f);
+  update_color_model(bgr_image, mask_, 1.0f);
+}
+
+void RoadMaskTracker::update_color_model(
+  const cv::Mat & bgr_image, const cv::Mat & mask, float rate)
+{
+  std::vector<float> road(BIN_COUNT, 0.f), background(BIN_COUNT, 0.f);
+  float road_sum = 0, background_sum = 0;
+  for (int h = 0; h < bgr_image.rows; h++) {
+    const cv::Vec3b * bgr_ptr = bgr_image.ptr<cv::Vec3b>(h);
+    const uchar * mask_ptr = mask.ptr<uchar>(h);
+    for (int w = 0; w < bgr_image.cols; w++) {
+      if (mask_ptr[w])
+        road[color_index(bgr_ptr[w])] += 1, road_sum += 1;
+      else
+        background[color_index(bgr_ptr[w])] += 1, background_sum += 1;
+    }
+  }
+
+  // Exponential moving average of the normalized histograms
+  for (int i = 0; i < BIN_COUNT; i++) {
+    if (road_sum > 0)
+      road_histogram_[i] = (1 - rate) * road_histogram_[i] + rate * road[i] / road_sum;
+    if (background_sum > 0) {
+      background_histogram_[i] =
+        (1 - rate) * background_histogram_[i] + rate * background[i] / background_sum;
+    }
+  }
+}
+
+cv::Mat RoadMaskTracker::track(const cv::Mat & bgr_image, const cv::Mat & homography)
+{
+  cv::Mat warped_mask;
+  cv::warpPerspective(
+    mask_, warped_mask, homography, bgr_image.size(), cv::INTER_NEAREST, cv::BORDER_CONSTANT, 0);
+
+  // Road probability of each color bin
+  std::vector<float> probability(BIN_COUNT);
+  for (int i = 0; i < BIN_COUNT; i++) {
+    const float denominator = road_histogram_[i] + background_histogram_[i];
+    probability[i] = denominator > 1e-6f ? road_histogram_[i] / denominator : 0.5f;
+  }
+
+  // Pixels at the border of the warped mask can become road if they look like road, and pixels
+  // inside it are dropped only if they look clearly unlike road (e.g. a vehicle cutting in)
+  cv::Mat dilated_mask;
+  cv::dilate(warped_mask, dilated_mask, cv::Mat::ones(5, 5, CV_8UC1));
+  const float low_threshold = 1.0f - road_probability_threshold_;
+
+  cv::Mat mask = cv::Mat::zeros(bgr_image.size(), CV_8UC1);
+  for (int h = 0; h < bgr_image.rows; h++) {
+    const cv::Vec3b * bgr_ptr = bgr_image.ptr<cv::Vec3b>(h);
+    const uchar * warped_ptr = warped_mask.ptr<uchar>(h);
+    const uchar * dilated_ptr = dilated_mask.ptr<uchar>(h);
+    uchar * mask_ptr = mask.ptr<uchar>(h);
+    for (int w = 0; w < bgr_image.cols; w++) {
+      if (!dilated_ptr[w]) continue;
+      const float p = probability[color_index(bgr_ptr[w])];
+      if (warped_ptr[w] ? p > low_threshold : p > road_probability_threshold_) mask_ptr[w] = 255;
+    }
+  }
+
+  update_color_model(bgr_image, mask, learning_rate_);
+  mask_ = mask;
+  return mask;
+}
+}  // namespace yabloc::graph_segment
@@ -18,79 +18,39 @@
 
 #include <rclcpp/logging.hpp>
 
-#include <queue>
+#include <algorithm>
+#include <sstream>
 
 namespace yabloc::graph_segment
 {
-struct KeyAndArea
+std::vector<int> SimilarAreaSearcher::search(
+  const LabelStatistics & statistics, int best_roadlike_class)
 {
-  KeyAndArea(int key, int count) : key(key), count(count) {}
-  int key;
-  int count;
-};
+  // Only the 11 largest areas are compared
+  std::vector<int> keys(statistics.label_count());
+  for (int i = 0; i < statistics.label_count(); i++) keys[i] = i;
+  const int candidate_count = std::min<int>(11, keys.size());
+  auto compare = [&](int a, int b) { return statistics.areas[a] > statistics.areas[b]; };
+  std::partial_sort(keys.begin(), keys.begin() + candidate_count, keys.end(), compare);
 
-std::set<int> SimilarAreaSearcher::search(
-  const cv::Mat & rgb_image, const cv::Mat & segmented, int best_roadlike_class)
-{
-  std::unordered_map<int, Histogram> histogram_map;
-  std::unordered_map<int, int> count_map;
-
-  for (int h = 0; h < rgb_image.rows; h++) {
-    const int * seg_ptr = segmented.ptr<int>(h);
-    const cv::Vec3b * rgb_ptr = rgb_image.ptr<cv::Vec3b>(h);
-
-    for (int w = 0; w < rgb_image.cols; w++) {
-      int key = seg_ptr[w];
-      cv::Vec3b rgb = rgb_ptr[w];
-      if (count_map.count(key) == 0) {
-        count_map[key] = 1;
-        histogram_map[key].add(rgb);
-      } else {
-        count_map[key]++;
-        histogram_map[key].add(rgb);
-      }
-    }
-  }
-
-  auto compare = [](KeyAndArea a, KeyAndArea b) { return a.count < b.count; };
-  std::priority_queue<KeyAndArea, std::vector<KeyAndArea>, decltype(compare)> key_queue{compare};
-  for (auto [key, count] : count_map) {
-    key_queue.push({key, count});
-  }
-
-  Eigen::MatrixXf ref_histogram = histogram_map.at(best_roadlike_class).eval();
+  Eigen::MatrixXf ref_histogram = statistics.eval_histogram(best_roadlike_class);
 
   std::stringstream debug_ss;
   debug_ss << "histogram equality ";
 
-  int index = 0;
-  std::set<int> acceptable_keys;
-  while (!key_queue.empty()) {
-    KeyAndArea key = key_queue.top();
-    key_queue.pop();
+  std::vector<int> acceptable_keys;
+  for (int i = 0; i < candidate_count; i++) {
+    const int key = keys[i];
+    if (statistics.areas[key] == 0) break;
 
-    Eigen::MatrixXf query = histogram_map.at(key.key).eval();
+    Eigen::MatrixXf query = statistics.eval_histogram(key);
     float score = Histogram::eval_histogram_intersection(ref_histogram, query);
     debug_ss << " " << score;
 
-    if (score > similarity_score_threshold_) acceptable_keys.insert(key.key);
-    if (++index > 10) break;
+    if (score > similarity_score_threshold_) acceptable_keys.push_back(key);
   }
   RCLCPP_INFO_STREAM(logger_, debug_ss.str());
 
-  // // DEBUG: Visualilze
-  // cv::Mat new_segmented = rgb_image.clone();
-  // for (int h = 0; h < rgb_image.rows; h++) {
-  //   const int * seg_ptr = segmented.ptr<int>(h);
-  //   cv::Vec3b * rgb_ptr = new_segmented.ptr<cv::Vec3b>(h);
-
-  //   for (int w = 0; w < rgb_image.cols; w++) {
-  //     int key = seg_ptr[w];
-  //     if (acceptable_keys.count(key)) rgb_ptr[w] = cv::Vec3b(0, 0, 255);
-  //     if (key == best_roadlike_class) rgb_ptr[w] = cv::Vec3b(0, 255, 255);
-  //   }
-  // }
-
   return acceptable_keys;
 }
 }  // namespace yabloc::graph_segment
\ No newline at end of file
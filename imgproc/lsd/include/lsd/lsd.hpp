@@ -13,21 +13,30 @@
 // limitations under the License.
 
 #pragma once
+#include "lsd/tiled_line_segment_detector.hpp"
+
 #include <eigen3/Eigen/Core>
 #include <eigen3/Eigen/Geometry>
 #include <opencv4/opencv2/core/eigen.hpp>
 #include <opencv4/opencv2/imgproc.hpp>
 #include <rclcpp/rclcpp.hpp>
+#include <yabloc_common/camera_info_subscriber.hpp>
+#include <yabloc_common/latest_only_subscription.hpp>
+#include <yabloc_common/stage_stamp_publisher.hpp>
+#include <yabloc_common/static_tf_subscriber.hpp>
+#include <yabloc_common/trace_reporter.hpp>
 
 #include <sensor_msgs/msg/camera_info.hpp>
 #include <sensor_msgs/msg/compressed_image.hpp>
 #include <sensor_msgs/msg/image.hpp>
 #include <sensor_msgs/msg/point_cloud2.hpp>
+#include <std_msgs/msg/float32_multi_array.hpp>
 
-#include <pcl/point_cloud.h>
-#include <pcl/point_types.h>
-
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <thread>
 
 namespace yabloc::lsd
 {
@@ -38,19 +47,70 @@ public:
   using CompressedImage = sensor_msgs::msg::CompressedImage;
   using Image = sensor_msgs::msg::Image;
   using PointCloud2 = sensor_msgs::msg::PointCloud2;
+  using Float32Array = std_msgs::msg::Float32MultiArray;
+
+  explicit LineSegmentDetector(const rclcpp::NodeOptions & options = rclcpp::NodeOptions());
+  ~LineSegmentDetector();
 
-  LineSegmentDetector();
+  // Detect line segments in a decoded image (mono8 or bgr8) and return them as
+  // line_segments_cloud. fused_imgproc calls this directly instead of the subscription.
+  PointCloud2 process(const cv::Mat & image, const rclcpp::Time & stamp);
 
 private:
-  rclcpp::Subscription<Image>::SharedPtr sub_image_;
+  // Elapsed time of each stage in milliseconds
+  struct Latency
+  {
+    float decode{0};
+    float detect{0};
+    float filter{0};
+    float publish{0};
+  };
+
+  struct DebugImageJob
+  {
+    cv::Mat gray_image;
+    cv::Mat lines;
+    rclcpp::Time stamp;
+  };
+
+  common::LatestOnlySubscription<Image>::SharedPtr sub_image_;
   rclcpp::Publisher<Image>::SharedPtr pub_image_with_line_segments_;
   rclcpp::Publisher<PointCloud2>::SharedPtr pub_cloud_;
+  rclcpp::Publisher<Float32Array>::SharedPtr pub_latency_;
 
-  cv::Ptr<cv::LineSegmentDetector> line_segment_detector_;
+  const bool standalone_;
+  const bool use_ground_roi_;
+  const int roi_margin_;
+  const int debug_image_interval_;
 
-  std::vector<cv::Mat> remove_too_outer_elements(
-    const cv::Mat & lines, const cv::Size & size) const;
+  // The debug image is drawn and published by another thread so that it never delays the cloud
+  int debug_frame_count_{0};
+  bool debug_thread_stopped_{false};
+  std::optional<DebugImageJob> debug_image_job_{std::nullopt};
+  std::mutex debug_mutex_;
+  std::condition_variable debug_condition_;
+  std::thread debug_thread_;
+
+  std::unique_ptr<TiledLineSegmentDetector> line_segment_detector_;
+  common::CameraInfoSubscriber info_;
+  common::StaticTfSubscriber tf_subscriber_;
+  std::optional<cv::Rect> ground_roi_{std::nullopt};
+  common::TraceReporter trace_reporter_{this};
+  common::StageStampPublisher stage_stamp_{this, "lsd"};
+
+  // Region below the horizon, which is derived from the camera extrinsic.
+  // Line segments above it are never projected onto the ground by segment_filter.
+  cv::Rect detection_roi(const cv::Size & size);
+  std::optional<cv::Rect> compute_ground_roi(const cv::Size & size);
+
+  std::vector<cv::Mat> remove_too_outer_elements(const cv::Mat & lines, const cv::Rect & roi) const;
   void on_image(const sensor_msgs::msg::Image & msg);
-  void execute(const cv::Mat & image, const rclcpp::Time & stamp);
+  PointCloud2 process(const cv::Mat & image, const rclcpp::Time & stamp, Latency & latency);
+  PointCloud2 execute(const cv::Mat & image, const rclcpp::Time & stamp, Latency & latency);
+
+  void request_debug_image(
+    const cv::Mat & gray_image, const cv::Mat & lines, const rclcpp::Time & stamp);
+  void debug_image_loop();
+  void publish_latency(const Latency & latency);
 };
 }  // namespace yabloc::lsd
\ No newline at end of file
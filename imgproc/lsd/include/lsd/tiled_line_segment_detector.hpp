@@ -0,0 +1,52 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <opencv4/opencv2/imgproc.hpp>
+
+#include <vector>
+
+namespace yabloc::lsd
+{
+// Run LSD only inside a region of interest. The region is split into horizontal bands which
+// overlap each other, and the bands are processed in parallel. Segments which are cut at a seam
+// are merged back into one segment.
+class TiledLineSegmentDetector
+{
+public:
+  TiledLineSegmentDetector(int tile_count, int tile_overlap);
+
+  // Returned lines are CV_32FC4 (x1, y1, x2, y2) in the coordinates of the whole image,
+  // which is the same as cv::LineSegmentDetector::detect() outputs
+  cv::Mat detect(const cv::Mat & gray_image, const cv::Rect & roi);
+
+private:
+  const int tile_count_;
+  const int tile_overlap_;
+  std::vector<cv::Ptr<cv::LineSegmentDetector>> detectors_;
+
+  struct Band
+  {
+    cv::Rect extended;
+    int core_top;
+    int core_bottom;
+  };
+  std::vector<Band> make_bands(const cv::Rect & roi) const;
+
+  // Join segments of adjacent bands which lie on the same line around the seam
+  std::vector<cv::Vec4f> merge_at_seams(
+    const std::vector<std::vector<cv::Vec4f>> & lines_per_band,
+    const std::vector<Band> & bands) const;
+};
+}  // namespace yabloc::lsd
@@ -16,72 +16,237 @@
 
 #include <opencv4/opencv2/imgproc.hpp>
 #include <yabloc_common/cv_decompress.hpp>
+#include <yabloc_common/line_segments_view.hpp>
 #include <yabloc_common/pub_sub.hpp>
 #include <yabloc_common/timer.hpp>
-
-#include <pcl_conversions/pcl_conversions.h>
+#include <yabloc_common/trace.hpp>
 
 namespace yabloc::lsd
 {
-LineSegmentDetector::LineSegmentDetector() : Node("line_detector")
+LineSegmentDetector::LineSegmentDetector(const rclcpp::NodeOptions & options)
+: Node("line_detector", options),
+  standalone_(declare_parameter<bool>("standalone", true)),
+  use_ground_roi_(declare_parameter<bool>("use_ground_roi", true)),
+  roi_margin_(declare_parameter<int>("roi_margin", 10)),
+  debug_image_interval_(declare_parameter<int>("debug_image_interval", 3)),
+  info_(this),
+  tf_subscriber_(this->get_clock())
 {
   using std::placeholders::_1;
 
   // Subscriber
-  auto cb_image = std::bind(&LineSegmentDetector::on_image, this, _1);
-  sub_image_ = create_subscription<Image>("src_image", 10, cb_image);
+  // Without standalone, the frames are given through process() by fused_imgproc.
+  // latest_only is off by default, since frames skipped here and not in the other branch leave
+  // segment_filter without a pair. undistort skips frames for both branches.
+  if (standalone_) {
+    auto cb_image = std::bind(&LineSegmentDetector::on_image, this, _1);
+    sub_image_ = std::make_shared<common::LatestOnlySubscription<Image>>(
+      this, "src_image", 10, cb_image, declare_parameter<bool>("latest_only", false));
+    stage_stamp_.set_drop_counter([this]() { return sub_image_->dropped_count(); });
+  }
 
   // Publisher
   pub_image_with_line_segments_ = create_publisher<Image>("image_with_line_segments", 10);
   pub_cloud_ = create_publisher<PointCloud2>("line_segments_cloud", 10);
+  pub_latency_ = create_publisher<Float32Array>("lsd_latency", 10);
+
+  // With tile_count > 1, the ROI is split into overlapping horizontal bands processed in parallel
+  const int tile_count = declare_parameter<int>("tile_count", 1);
+  const int tile_overlap = declare_parameter<int>("tile_overlap", 16);
+  line_segment_detector_ = std::make_unique<TiledLineSegmentDetector>(tile_count, tile_overlap);
+
+  debug_thread_ = std::thread(&LineSegmentDetector::debug_image_loop, this);
+}
+
+LineSegmentDetector::~LineSegmentDetector()
+{
+  {
+    std::lock_guard<std::mutex> lock(debug_mutex_);
+    debug_thread_stopped_ = true;
+  }
+  debug_condition_.notify_one();
+  debug_thread_.join();
+}
+
+cv::Rect LineSegmentDetector::detection_roi(const cv::Size & size)
+{
+  const cv::Rect whole(0, 0, size.width, size.height);
+  if (!use_ground_roi_) return whole;
+
+  // The ROI spans the whole width down to the bottom, so a size change invalidates it
+  const bool size_changed =
+    ground_roi_.has_value() && ground_roi_->br() != cv::Point(size.width, size.height);
+  if (!ground_roi_.has_value() || size_changed) {
+    ground_roi_ = compute_ground_roi(size);
+    if (!ground_roi_.has_value()) {
+      using namespace std::literals::chrono_literals;
+      RCLCPP_INFO_STREAM_THROTTLE(
+        get_logger(), *get_clock(), (1000ms).count(), "ground roi cannot be defined");
+      return whole;
+    }
+    RCLCPP_INFO_STREAM(get_logger(), "ground roi: " << ground_roi_.value());
+  }
+  return ground_roi_.value();
+}
+
+std::optional<cv::Rect> LineSegmentDetector::compute_ground_roi(const cv::Size & size)
+{
+  if (info_.is_camera_info_nullopt()) return std::nullopt;
+  const Eigen::Matrix3f Kinv = info_.intrinsic().inverse();
+
+  std::optional<Eigen::Affine3f> camera_extrinsic =
+    tf_subscriber_(info_.get_frame_id(), "base_link");
+  if (!camera_extrinsic.has_value()) return std::nullopt;
+  const Eigen::Quaternionf q(camera_extrinsic->rotation());
+
+  // Find the top-most row whose bearing hits the ground in the same way as segment_filter.
+  // The horizon can be tilted by the camera roll, so the both sides and the center are checked.
+  int horizon = size.height;
+  for (int u : {0, size.width / 2, size.width - 1}) {
+    for (int v = 0; v < horizon; ++v) {
+      const Eigen::Vector3f bearing = (q * Kinv * Eigen::Vector3f(u, v, 1)).normalized();
+      if (bearing.z() < -0.01) {
+        horizon = v;
+        break;
+      }
+    }
+  }
+  if (horizon >= size.height) return std::nullopt;
 
-  line_segment_detector_ = cv::createLineSegmentDetector(cv::LSD_REFINE_STD, 0.8, 0.6, 2.0, 22.5, 0, 0.7, 1024);
+  const int top = std::max(0, horizon - roi_margin_);
+  return cv::Rect(0, top, size.width, size.height - top);
 }
 
 void LineSegmentDetector::on_image(const sensor_msgs::msg::Image & msg)
 {
+  YABLOC_TRACE_SCOPE("lsd/on_image");
+  Latency latency;
+  common::Timer timer;
   cv::Mat image = common::decompress_to_cv_mat(msg);
-  execute(image, msg.header.stamp);
+  latency.decode = timer.micro_seconds() / 1000.f;
+
+  process(image, msg.header.stamp, latency);
+}
+
+LineSegmentDetector::PointCloud2 LineSegmentDetector::process(
+  const cv::Mat & image, const rclcpp::Time & stamp)
+{
+  Latency latency;
+  return process(image, stamp, latency);
+}
+
+LineSegmentDetector::PointCloud2 LineSegmentDetector::process(
+  const cv::Mat & image, const rclcpp::Time & stamp, Latency & latency)
+{
+  const auto start = stage_stamp_.start();
+  PointCloud2 cloud = execute(image, stamp, latency);
+  publish_latency(latency);
+  stage_stamp_.publish(stamp, start);
+  return cloud;
 }
 
-void LineSegmentDetector::execute(const cv::Mat & image, const rclcpp::Time & stamp)
+LineSegmentDetector::PointCloud2 LineSegmentDetector::execute(
+  const cv::Mat & image, const rclcpp::Time & stamp, Latency & latency)
 {
+  common::Timer timer;
+
+  // mono8 images, e.g. the luminance made by undistort, are used without any conversion
   cv::Mat gray_image;
-  cv::cvtColor(image, gray_image, cv::COLOR_BGR2GRAY);
+  if (image.channels() == 1)
+    gray_image = image;
+  else
+    cv::cvtColor(image, gray_image, cv::COLOR_BGR2GRAY);
+  latency.decode += timer.micro_seconds() / 1000.f;
+
+  const cv::Rect roi = detection_roi(gray_image.size());
 
+  timer.reset();
   cv::Mat lines;
   {
-    common::Timer timer;
-    line_segment_detector_->detect(gray_image, lines);
-    line_segment_detector_->drawSegments(gray_image, lines);
-    RCLCPP_INFO_STREAM(this->get_logger(), "lsd: " << timer);
+    YABLOC_TRACE_SCOPE("lsd/detect");
+    lines = line_segment_detector_->detect(gray_image, roi);
   }
+  latency.detect = timer.micro_seconds() / 1000.f;
+
+  timer.reset();
+  std::vector<common::LineSegmentRecord> line_segments;
+  for (const cv::Mat & xy_xy : remove_too_outer_elements(lines, roi)) {
+    line_segments.push_back(
+      {xy_xy.at<float>(0), xy_xy.at<float>(1), 0, xy_xy.at<float>(2), xy_xy.at<float>(3), 0, 0});
+  }
+  PointCloud2 cloud = common::to_line_segments_msg(line_segments);
+  cloud.header.stamp = stamp;
+  cloud.header.frame_id = "map";
+  latency.filter = timer.micro_seconds() / 1000.f;
+
+  timer.reset();
+  // When fused, the cloud is handed over directly and published only for visualization
+  if (standalone_ || pub_cloud_->get_subscription_count() > 0) pub_cloud_->publish(cloud);
+  request_debug_image(gray_image, lines, stamp);
+  latency.publish = timer.micro_seconds() / 1000.f;
+  return cloud;
+}
+
+void LineSegmentDetector::request_debug_image(
+  const cv::Mat & gray_image, const cv::Mat & lines, const rclcpp::Time & stamp)
+{
+  if (pub_image_with_line_segments_->get_subscription_count() == 0) return;
+  if (debug_frame_count_++ % std::max(debug_image_interval_, 1) != 0) return;
 
-  common::publish_image(*pub_image_with_line_segments_, gray_image, stamp);
+  {
+    // If the previous request has not been taken yet, it is replaced with the latest one
+    std::lock_guard<std::mutex> lock(debug_mutex_);
+    debug_image_job_ = DebugImageJob{gray_image, lines, stamp};
+  }
+  debug_condition_.notify_one();
+}
 
-  pcl::PointCloud<pcl::PointNormal> line_cloud;
-  std::vector<cv::Mat> filtered_lines = remove_too_outer_elements(lines, image.size());
+void LineSegmentDetector::debug_image_loop()
+{
+  while (true) {
+    DebugImageJob job;
+    {
+      std::unique_lock<std::mutex> lock(debug_mutex_);
+      debug_condition_.wait(
+        lock, [this]() { return debug_thread_stopped_ || debug_image_job_.has_value(); });
+      if (debug_thread_stopped_) return;
+      job = std::move(debug_image_job_.value());
+      debug_image_job_ = std::nullopt;
+    }
 
-  for (const cv::Mat & xy_xy : filtered_lines) {
-    Eigen::Vector3f xy1, xy2;
-    xy1 << xy_xy.at<float>(0), xy_xy.at<float>(1), 0;
-    xy2 << xy_xy.at<float>(2), xy_xy.at<float>(3), 0;
-    pcl::PointNormal pn;
-    pn.getVector3fMap() = xy1;
-    pn.getNormalVector3fMap() = xy2;
-    line_cloud.push_back(pn);
+    YABLOC_TRACE_SCOPE("lsd/debug_image");
+    cv::Mat image_with_lines;
+    cv::cvtColor(job.gray_image, image_with_lines, cv::COLOR_GRAY2BGR);
+    for (int i = 0; i < job.lines.rows; i++) {
+      const cv::Vec4f & line = job.lines.at<cv::Vec4f>(i);
+      cv::line(
+        image_with_lines, cv::Point2f(line[0], line[1]), cv::Point2f(line[2], line[3]),
+        cv::Scalar(0, 0, 255), 1);
+    }
+    common::publish_image(*pub_image_with_line_segments_, image_with_lines, job.stamp);
   }
-  common::publish_cloud(*pub_cloud_, line_cloud, stamp);
+}
+
+void LineSegmentDetector::publish_latency(const Latency & latency)
+{
+  Float32Array array;
+  array.layout.dim.resize(1);
+  array.layout.dim.front().label = "decode,detect,filter,publish[ms]";
+  array.layout.dim.front().size = 4;
+  array.layout.dim.front().stride = 4;
+  array.data = {latency.decode, latency.detect, latency.filter, latency.publish};
+  pub_latency_->publish(array);
 }
 
 std::vector<cv::Mat> LineSegmentDetector::remove_too_outer_elements(
-  const cv::Mat & lines, const cv::Size & size) const
+  const cv::Mat & lines, const cv::Rect & roi) const
 {
+  // Segments along the ROI border are artifacts of cropping as well as the image border
   std::vector<cv::Rect2i> rect_vector;
-  rect_vector.emplace_back(0, 0, size.width, 3);
-  rect_vector.emplace_back(0, size.height - 3, size.width, 3);
-  rect_vector.emplace_back(0, 0, 3, size.height);
-  rect_vector.emplace_back(size.width - 3, 0, 3, size.height);
+  rect_vector.emplace_back(roi.x, roi.y, roi.width, 3);
+  rect_vector.emplace_back(roi.x, roi.br().y - 3, roi.width, 3);
+  rect_vector.emplace_back(roi.x, roi.y, 3, roi.height);
+  rect_vector.emplace_back(roi.br().x - 3, roi.y, 3, roi.height);
 
   std::vector<cv::Mat> filtered_lines;
   for (int i = 0; i < lines.rows; i++) {
@@ -0,0 +1,162 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "lsd/tiled_line_segment_detector.hpp"
+
+#include <opencv4/opencv2/core/utility.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <optional>
+
+namespace yabloc::lsd
+{
+namespace
+{
+// Tolerances to regard two pieces as one segment that was cut at a seam
+constexpr float MERGE_COS_TOLERANCE = 0.9986f;  // cos(3deg)
+constexpr float MERGE_DISTANCE_TOLERANCE = 2.0f;
+constexpr float MERGE_GAP_TOLERANCE = 4.0f;
+// Bands thinner than this are not worth to be split
+constexpr int MIN_BAND_HEIGHT = 32;
+
+std::optional<cv::Vec4f> try_merge(const cv::Vec4f & a, const cv::Vec4f & b)
+{
+  const cv::Point2f a1(a[0], a[1]), a2(a[2], a[3]);
+  const cv::Point2f b1(b[0], b[1]), b2(b[2], b[3]);
+
+  const float length_a = cv::norm(a2 - a1);
+  const float length_b = cv::norm(b2 - b1);
+  if (length_a < 1e-3f || length_b < 1e-3f) return std::nullopt;
+
+  const cv::Point2f d = (a2 - a1) / length_a;
+  if (std::abs(d.dot((b2 - b1) / length_b)) < MERGE_COS_TOLERANCE) return std::nullopt;
+
+  const cv::Point2f n(-d.y, d.x);
+  if (std::abs(n.dot(b1 - a1)) > MERGE_DISTANCE_TOLERANCE) return std::nullopt;
+  if (std::abs(n.dot(b2 - a1)) > MERGE_DISTANCE_TOLERANCE) return std::nullopt;
+
+  // Position of each end point along a
+  const float t[4] = {0.f, length_a, d.dot(b1 - a1), d.dot(b2 - a1)};
+  const cv::Point2f p[4] = {a1, a2, b1, b2};
+  const float gap = std::max(std::min(t[2], t[3]) - length_a, -std::max(t[2], t[3]));
+  if (gap > MERGE_GAP_TOLERANCE) return std::nullopt;
+
+  const int first = std::min_element(t, t + 4) - t;
+  const int last = std::max_element(t, t + 4) - t;
+  return cv::Vec4f(p[first].x, p[first].y, p[last].x, p[last].y);
+}
+}  // namespace
+
+TiledLineSegmentDetector::TiledLineSegmentDetector(int tile_count, int tile_overlap)
+: tile_count_(std::max(1, tile_count)), tile_overlap_(std::max(0, tile_overlap))
+{
+  // LSD keeps intermediate buffers inside, so each band has its own detector
+  for (int i = 0; i < tile_count_; ++i) {
+    detectors_.push_back(
+      cv::createLineSegmentDetector(cv::LSD_REFINE_STD, 0.8, 0.6, 2.0, 22.5, 0, 0.7, 1024));
+  }
+}
+
+std::vector<TiledLineSegmentDetector::Band> TiledLineSegmentDetector::make_bands(
+  const cv::Rect & roi) const
+{
+  const int band_count = std::clamp(roi.height / MIN_BAND_HEIGHT, 1, tile_count_);
+  const int core_height = (roi.height + band_count - 1) / band_count;
+
+  std::vector<Band> bands;
+  for (int i = 0; i < band_count; ++i) {
+    Band band;
+    band.core_top = roi.y + i * core_height;
+    band.core_bottom = std::min(band.core_top + core_height, roi.br().y);
+    if (band.core_top >= band.core_bottom) break;
+
+    const int top = std::max(roi.y, band.core_top - tile_overlap_);
+    const int bottom = std::min(roi.br().y, band.core_bottom + tile_overlap_);
+    band.extended = cv::Rect(roi.x, top, roi.width, bottom - top);
+    bands.push_back(band);
+  }
+  return bands;
+}
+
+cv::Mat TiledLineSegmentDetector::detect(const cv::Mat & gray_image, const cv::Rect & roi)
+{
+  const cv::Rect clipped_roi = roi & cv::Rect(0, 0, gray_image.cols, gray_image.rows);
+  if (clipped_roi.empty()) return cv::Mat();
+
+  const std::vector<Band> bands = make_bands(clipped_roi);
+  std::vector<std::vector<cv::Vec4f>> lines_per_band(bands.size());
+
+  cv::parallel_for_(cv::Range(0, bands.size()), [&](const cv::Range & range) {
+    for (int i = range.start; i < range.end; ++i) {
+      const Band & band = bands.at(i);
+      std::vector<cv::Vec4f> lines;
+      detectors_.at(i)->detect(gray_image(band.extended), lines);
+
+      for (cv::Vec4f & line : lines) {
+        line[0] += band.extended.x, line[2] += band.extended.x;
+        line[1] += band.extended.y, line[3] += band.extended.y;
+        // A segment inside the overlap is detected by both bands. Keep the one owning its middle.
+        const float middle_y = 0.5f * (line[1] + line[3]);
+        if (middle_y < band.core_top || middle_y >= band.core_bottom) continue;
+        lines_per_band.at(i).push_back(line);
+      }
+    }
+  });
+
+  std::vector<cv::Vec4f> merged_lines = merge_at_seams(lines_per_band, bands);
+  return cv::Mat(merged_lines, true);
+}
+
+std::vector<cv::Vec4f> TiledLineSegmentDetector::merge_at_seams(
+  const std::vector<std::vector<cv::Vec4f>> & lines_per_band, const std::vector<Band> & bands) const
+{
+  if (lines_per_band.empty()) return {};
+
+  std::vector<cv::Vec4f> merged_lines = lines_per_band.front();
+  // Indices of merged_lines which reach the lower seam of the previous band
+  std::vector<size_t> previous_indices(merged_lines.size());
+  for (size_t i = 0; i < previous_indices.size(); ++i) previous_indices[i] = i;
+
+  for (size_t band_index = 1; band_index < bands.size(); ++band_index) {
+    const float seam = bands.at(band_index).core_top;
+    const float reach = tile_overlap_ + MERGE_GAP_TOLERANCE;
+
+    std::vector<size_t> current_indices;
+    for (const cv::Vec4f & line : lines_per_band.at(band_index)) {
+      std::optional<size_t> merged_index = std::nullopt;
+      if (std::min(line[1], line[3]) <= seam + reach) {
+        for (size_t index : previous_indices) {
+          const cv::Vec4f & candidate = merged_lines.at(index);
+          if (std::max(candidate[1], candidate[3]) < seam - reach) continue;
+          if (auto merged = try_merge(candidate, line)) {
+            merged_lines.at(index) = merged.value();
+            merged_index = index;
+            break;
+          }
+        }
+      }
+
+      if (!merged_index.has_value()) {
+        merged_index = merged_lines.size();
+        merged_lines.push_back(line);
+      }
+      current_indices.push_back(merged_index.value());
+    }
+    previous_indices = std::move(current_indices);
+  }
+  return merged_lines;
+}
+
+}  // namespace yabloc::lsd
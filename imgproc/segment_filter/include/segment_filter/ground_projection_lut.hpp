@@ -0,0 +1,62 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include <optional>
+#include <vector>
+
+namespace yabloc::segment_filter
+{
+// Pixel to ground lookup table of one camera.
+// The ground is the plane which passes through the base_link origin with the given normal.
+// Ground points are sampled on a grid of `step` pixels (it can be smaller than 1) and are
+// bilinearly interpolated. Cells touching the horizon are projected exactly instead.
+class GroundProjectionLut
+{
+public:
+  explicit GroundProjectionLut(float step);
+
+  void build(
+    const Eigen::Matrix3f & K, const Eigen::Vector2i & size, const Eigen::Affine3f & extrinsic,
+    const Eigen::Vector3f & ground_normal = Eigen::Vector3f::UnitZ());
+
+  // Return true if build() was called with the same arguments
+  bool is_built_for(
+    const Eigen::Matrix3f & K, const Eigen::Vector2i & size, const Eigen::Affine3f & extrinsic,
+    const Eigen::Vector3f & ground_normal) const;
+
+  // u is (x, y, *) in pixel
+  std::optional<Eigen::Vector3f> project(const Eigen::Vector3f & u) const;
+
+  // Exact projection without the table
+  std::optional<Eigen::Vector3f> project_exactly(const Eigen::Vector3f & u) const;
+
+private:
+  const float step_;
+  int cols_{0};
+  int rows_{0};
+
+  Eigen::Matrix3f K_;
+  Eigen::Matrix3f Kinv_;
+  Eigen::Vector2i size_{0, 0};
+  Eigen::Affine3f extrinsic_;
+  Eigen::Vector3f ground_normal_;
+
+  std::vector<Eigen::Vector3f> table_;
+  std::vector<bool> valid_;
+};
+}  // namespace yabloc::segment_filter
@@ -0,0 +1,34 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <opencv4/opencv2/core.hpp>
+#include <yabloc_common/line_segments_view.hpp>
+
+#include <vector>
+
+namespace yabloc::segment_filter
+{
+// Both functions return a flag for each segment, which is true if the segment passes over the
+// mask (pixel value > 1). A segment is given by its end points, xyz and normal_xyz.
+
+// Draw all segments into a 16bit label image and AND it with the mask
+std::vector<bool> filt_by_mask_raster(
+  const cv::Mat & mask, const common::LineSegmentsView & edges);
+
+// Walk each segment on the 8bit mask with the same 4-connected Bresenham as cv::line(LINE_4)
+// and stop at the first masked pixel. Nothing is allocated except the result.
+std::vector<bool> filt_by_mask_direct(
+  const cv::Mat & mask, const common::LineSegmentsView & edges);
+}  // namespace yabloc::segment_filter
@@ -13,12 +13,19 @@
 // limitations under the License.
 
 #pragma once
+#include "segment_filter/ground_projection_lut.hpp"
+
 #include <opencv4/opencv2/core.hpp>
 #include <rclcpp/rclcpp.hpp>
 #include <yabloc_common/camera_info_subscriber.hpp>
+#include <yabloc_common/ground_plane.hpp>
+#include <yabloc_common/line_segments_view.hpp>
+#include <yabloc_common/stage_stamp_publisher.hpp>
 #include <yabloc_common/static_tf_subscriber.hpp>
 #include <yabloc_common/synchro_subscriber.hpp>
+#include <yabloc_common/trace_reporter.hpp>
 
+#include <geometry_msgs/msg/pose_stamped.hpp>
 #include <sensor_msgs/msg/camera_info.hpp>
 #include <sensor_msgs/msg/image.hpp>
 #include <sensor_msgs/msg/point_cloud2.hpp>
@@ -27,6 +34,11 @@
 #include <pcl/point_cloud.h>
 #include <pcl/point_types.h>
 
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
 namespace yabloc::segment_filter
 {
 class SegmentFilter : public rclcpp::Node
@@ -34,38 +46,66 @@ class SegmentFilter : public rclcpp::Node
 public:
   using PointCloud2 = sensor_msgs::msg::PointCloud2;
   using Image = sensor_msgs::msg::Image;
+  using PoseStamped = geometry_msgs::msg::PoseStamped;
+  using Float32Array = std_msgs::msg::Float32MultiArray;
+
+  explicit SegmentFilter(const rclcpp::NodeOptions & options = rclcpp::NodeOptions());
 
-  SegmentFilter();
+  // Project line segments of a frame onto the ground and label them by the road mask.
+  // fused_imgproc calls this directly instead of the synchronized subscription.
+  void execute(const PointCloud2 & line_segments_msg, const cv::Mat & mask_image);
 
 private:
   using ProjectFunc = std::function<std::optional<Eigen::Vector3f>(const Eigen::Vector3f &)>;
+  const bool standalone_;
   const int image_size_;
   const float max_range_;
   const float min_segment_length_;
   const float max_segment_distance_;
   const float max_lateral_distance_;
+  const bool use_direct_mask_sampling_;
+  const float ground_tilt_threshold_;
 
   common::CameraInfoSubscriber info_;
-  common::SynchroSubscriber<PointCloud2, Image> synchro_subscriber_;
+  common::SynchroSubscriber<PointCloud2, Image>::SharedPtr synchro_subscriber_{nullptr};
   common::StaticTfSubscriber tf_subscriber_;
 
   rclcpp::Publisher<PointCloud2>::SharedPtr pub_projected_cloud_;
   rclcpp::Publisher<PointCloud2>::SharedPtr pub_debug_cloud_;
   rclcpp::Publisher<Image>::SharedPtr pub_image_;
+  rclcpp::Subscription<Float32Array>::SharedPtr sub_ground_plane_;
+  rclcpp::Subscription<PoseStamped>::SharedPtr sub_pose_;
 
   ProjectFunc project_func_ = nullptr;
+  std::optional<Eigen::Affine3f> camera_extrinsic_{std::nullopt};
+  std::string extrinsic_frame_id_;
+  std::unique_ptr<GroundProjectionLut> projection_lut_{nullptr};
+
+  // Ground tilt is considered only if these are subscribed
+  std::optional<common::GroundPlane> ground_plane_{std::nullopt};
+  std::optional<Eigen::Quaternionf> vehicle_orientation_{std::nullopt};
+  Eigen::Vector3f lut_ground_normal_ = Eigen::Vector3f::UnitZ();
+
+  common::TraceReporter trace_reporter_{this};
+  common::StageStampPublisher stage_stamp_{this, "segment_filter"};
 
   // Return true if success to define or already defined
+  // With the projection LUT, it is rebuilt whenever camera_info, the camera frame or the ground
+  // tilt changes.
   bool define_project_func();
 
+  Eigen::Vector3f ground_normal_in_base_link();
+
+  // Project the lines whose flag is true, or false if negative is true
   pcl::PointCloud<pcl::PointNormal> project_lines(
-    const pcl::PointCloud<pcl::PointNormal> & lines, const std::set<int> & indices,
+    const common::LineSegmentsView & lines, const std::vector<bool> & flags,
     bool negative = false) const;
 
-  std::set<int> filt_by_mask(const cv::Mat & mask, const pcl::PointCloud<pcl::PointNormal> & edges);
+  std::vector<bool> filt_by_mask(
+    const cv::Mat & mask, const common::LineSegmentsView & edges) const;
 
   cv::Point2i to_cv_point(const Eigen::Vector3f & v) const;
-  void execute(const PointCloud2 & msg1, const Image & msg2);
+  void on_synchro(const PointCloud2 & line_segments_msg, const Image & segment_msg);
 
   bool is_near_element(const pcl::PointNormal & pn, pcl::PointNormal & truncated_pn) const;
 };
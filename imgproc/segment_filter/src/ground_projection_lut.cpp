@@ -0,0 +1,101 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "segment_filter/ground_projection_lut.hpp"
+
+#include <cmath>
+
+namespace yabloc::segment_filter
+{
+// Projection is not linear in pixel and interpolation error grows with the distance.
+// Far cells are left to the exact projection.
+constexpr float MAX_INTERPOLATION_DISTANCE = 40.0f;
+
+GroundProjectionLut::GroundProjectionLut(float step) : step_(step) {}
+
+bool GroundProjectionLut::is_built_for(
+  const Eigen::Matrix3f & K, const Eigen::Vector2i & size, const Eigen::Affine3f & extrinsic,
+  const Eigen::Vector3f & ground_normal) const
+{
+  if (table_.empty()) return false;
+  if (size != size_) return false;
+  if (!K.isApprox(K_)) return false;
+  if (!extrinsic.matrix().isApprox(extrinsic_.matrix())) return false;
+  return ground_normal.isApprox(ground_normal_);
+}
+
+void GroundProjectionLut::build(
+  const Eigen::Matrix3f & K, const Eigen::Vector2i & size, const Eigen::Affine3f & extrinsic,
+  const Eigen::Vector3f & ground_normal)
+{
+  K_ = K;
+  Kinv_ = K.inverse();
+  size_ = size;
+  extrinsic_ = extrinsic;
+  ground_normal_ = ground_normal.normalized();
+
+  cols_ = static_cast<int>(std::ceil(size.x() / step_)) + 1;
+  rows_ = static_cast<int>(std::ceil(size.y() / step_)) + 1;
+  table_.assign(cols_ * rows_, Eigen::Vector3f::Zero());
+  valid_.assign(cols_ * rows_, false);
+
+  for (int j = 0; j < rows_; j++) {
+    for (int i = 0; i < cols_; i++) {
+      const Eigen::Vector3f u(i * step_, j * step_, 1);
+      std::optional<Eigen::Vector3f> opt = project_exactly(u);
+      if (!opt.has_value()) continue;
+      if (opt->topRows(2).norm() > MAX_INTERPOLATION_DISTANCE) continue;
+      table_[j * cols_ + i] = opt.value();
+      valid_[j * cols_ + i] = true;
+    }
+  }
+}
+
+std::optional<Eigen::Vector3f> GroundProjectionLut::project_exactly(
+  const Eigen::Vector3f & u) const
+{
+  const Eigen::Vector3f & t = extrinsic_.translation();
+  Eigen::Vector3f u3(u.x(), u.y(), 1);
+  Eigen::Vector3f u_bearing = (extrinsic_.rotation() * Kinv_ * u3).normalized();
+
+  // This is the same condition as u_bearing.z() < -0.01 when the ground is flat
+  const float cos_incidence = ground_normal_.dot(u_bearing);
+  if (cos_incidence > -0.01) return std::nullopt;
+  float u_distance = -ground_normal_.dot(t) / cos_incidence;
+  Eigen::Vector3f v = t + u_bearing * u_distance;
+  if (ground_normal_.isApprox(Eigen::Vector3f::UnitZ())) v.z() = 0;
+  return v;
+}
+
+std::optional<Eigen::Vector3f> GroundProjectionLut::project(const Eigen::Vector3f & u) const
+{
+  const float gx = u.x() / step_;
+  const float gy = u.y() / step_;
+  const int i = static_cast<int>(std::floor(gx));
+  const int j = static_cast<int>(std::floor(gy));
+  if (i < 0 || j < 0 || i + 1 >= cols_ || j + 1 >= rows_) return project_exactly(u);
+
+  const int i00 = j * cols_ + i;
+  const int i10 = i00 + 1;
+  const int i01 = i00 + cols_;
+  const int i11 = i01 + 1;
+  if (!valid_[i00] || !valid_[i10] || !valid_[i01] || !valid_[i11]) return project_exactly(u);
+
+  const float fx = gx - i;
+  const float fy = gy - j;
+  const Eigen::Vector3f top = (1 - fx) * table_[i00] + fx * table_[i10];
+  const Eigen::Vector3f bottom = (1 - fx) * table_[i01] + fx * table_[i11];
+  return (1 - fy) * top + fy * bottom;
+}
+}  // namespace yabloc::segment_filter
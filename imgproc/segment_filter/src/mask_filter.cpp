@@ -0,0 +1,96 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "segment_filter/mask_filter.hpp"
+
+#include <opencv4/opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <set>
+#include <stdexcept>
+
+namespace yabloc::segment_filter
+{
+std::set<ushort> get_unique_pixel_value(cv::Mat & image)
+{
+  // `image` is a set of ushort.
+  // The purpose is to find the unduplicated set of values contained in `image`.
+  // For example, if `image` is {0,1,2,0,1,2,3}, this function returns {0,1,2,3}.
+
+  if (image.depth() != CV_16U) throw std::runtime_error("image's depth must be ushort");
+
+  auto begin = image.begin<ushort>();
+  auto last = std::unique(begin, image.end<ushort>());
+  std::sort(begin, last);
+  last = std::unique(begin, last);
+  return std::set<ushort>(begin, last);
+}
+
+std::vector<bool> filt_by_mask_raster(
+  const cv::Mat & mask, const common::LineSegmentsView & edges)
+{
+  // Create line image and assign different color to each segment.
+  cv::Mat line_image = cv::Mat::zeros(mask.size(), CV_16UC1);
+  for (size_t i = 0; i < edges.size(); i++) {
+    Eigen::Vector3f p1 = edges.from(i);
+    Eigen::Vector3f p2 = edges.to(i);
+    cv::Scalar color = cv::Scalar::all(i + 1);
+    cv::line(
+      line_image, cv::Point2i(p1.x(), p1.y()), cv::Point2i(p2.x(), p2.y()), color, 1,
+      cv::LineTypes::LINE_4);
+  }
+
+  cv::Mat mask_image;
+  mask.convertTo(mask_image, CV_16UC1);
+  cv::threshold(mask_image, mask_image, 1, std::numeric_limits<ushort>::max(), cv::THRESH_BINARY);
+
+  // And operator
+  cv::Mat masked_line;
+  cv::bitwise_and(mask_image, line_image, masked_line);
+  std::set<ushort> pixel_values = get_unique_pixel_value(masked_line);
+
+  // Extract edges within masks
+  std::vector<bool> reliable_flags(edges.size(), false);
+  for (size_t i = 0; i < edges.size(); i++) {
+    if (pixel_values.count(i + 1) != 0) reliable_flags[i] = true;
+  }
+
+  return reliable_flags;
+}
+
+std::vector<bool> filt_by_mask_direct(
+  const cv::Mat & mask, const common::LineSegmentsView & edges)
+{
+  if (mask.type() != CV_8UC1) throw std::runtime_error("mask must be CV_8UC1");
+
+  std::vector<bool> reliable_flags(edges.size(), false);
+  for (size_t i = 0; i < edges.size(); i++) {
+    const Eigen::Vector3f from = edges.from(i);
+    const Eigen::Vector3f to = edges.to(i);
+    const cv::Point2i p1(from.x(), from.y());
+    const cv::Point2i p2(to.x(), to.y());
+
+    // LineIterator clips the segment to the image as cv::line() does
+    cv::LineIterator it(mask, p1, p2, 4);
+    for (int n = 0; n < it.count; n++, ++it) {
+      if (**it > 1) {
+        reliable_flags[i] = true;
+        break;
+      }
+    }
+  }
+  return reliable_flags;
+}
+}  // namespace yabloc::segment_filter
@@ -14,34 +14,64 @@
 
 #include "segment_filter/segment_filter.hpp"
 
+#include "segment_filter/mask_filter.hpp"
+
 #include <opencv4/opencv2/core.hpp>
 #include <opencv4/opencv2/imgproc.hpp>
 #include <yabloc_common/cv_decompress.hpp>
 #include <yabloc_common/pub_sub.hpp>
+#include <yabloc_common/timer.hpp>
+#include <yabloc_common/trace.hpp>
 
-#include <pcl_conversions/pcl_conversions.h>
+#include <algorithm>
+#include <cmath>
 
 namespace yabloc::segment_filter
 {
-SegmentFilter::SegmentFilter()
-: Node("segment_filter"),
+SegmentFilter::SegmentFilter(const rclcpp::NodeOptions & options)
+: Node("segment_filter", options),
+  standalone_(declare_parameter<bool>("standalone", true)),
   image_size_(declare_parameter<int>("image_size", 800)),
   max_range_(declare_parameter<float>("max_range", 20.f)),
   min_segment_length_(declare_parameter<float>("min_segment_length", -1)),
   max_segment_distance_(declare_parameter<float>("max_segment_distance", -1)),
   max_lateral_distance_(declare_parameter<float>("max_lateral_distance", -1)),
+  use_direct_mask_sampling_(declare_parameter<bool>("use_direct_mask_sampling", true)),
+  ground_tilt_threshold_(declare_parameter<float>("ground_tilt_threshold_deg", 0.5) * M_PI / 180.f),
   info_(this),
-  synchro_subscriber_(this, "line_segments_cloud", "mask_image"),
   tf_subscriber_(this->get_clock())
 {
   using std::placeholders::_1;
   using std::placeholders::_2;
-  auto cb = std::bind(&SegmentFilter::execute, this, _1, _2);
-  synchro_subscriber_.set_callback(std::move(cb));
+
+  // Without standalone, the frames are given through execute() by fused_imgproc
+  if (standalone_) {
+    synchro_subscriber_ = std::make_shared<common::SynchroSubscriber<PointCloud2, Image>>(
+      this, "line_segments_cloud", "mask_image");
+    synchro_subscriber_->set_callback(std::bind(&SegmentFilter::on_synchro, this, _1, _2));
+    stage_stamp_.set_drop_counter([this]() { return synchro_subscriber_->dropped_count(); });
+  }
 
   pub_projected_cloud_ = create_publisher<PointCloud2>("projected_line_segments_cloud", 10);
   pub_debug_cloud_ = create_publisher<PointCloud2>("debug/line_segments_cloud", 10);
   pub_image_ = create_publisher<Image>("projected_image", 10);
+
+  // projection lookup table module
+  if (declare_parameter<bool>("use_projection_lut", true)) {
+    projection_lut_ =
+      std::make_unique<GroundProjectionLut>(declare_parameter<float>("projection_lut_step", 1.0));
+  }
+
+  // The ground plane is given in the map frame, so the vehicle orientation is also needed
+  if (declare_parameter<bool>("use_ground_tilt", false)) {
+    auto on_ground = [this](const Float32Array & msg) -> void { ground_plane_ = msg; };
+    auto on_pose = [this](const PoseStamped & msg) -> void {
+      const auto & q = msg.pose.orientation;
+      vehicle_orientation_ = Eigen::Quaternionf(q.w, q.x, q.y, q.z);
+    };
+    sub_ground_plane_ = create_subscription<Float32Array>("ground", 10, std::move(on_ground));
+    sub_pose_ = create_subscription<PoseStamped>("pose", 10, std::move(on_pose));
+  }
 }
 
 cv::Point2i SegmentFilter::to_cv_point(const Eigen::Vector3f & v) const
@@ -52,21 +82,48 @@ cv::Point2i SegmentFilter::to_cv_point(const Eigen::Vector3f & v) const
   return pt;
 }
 
+Eigen::Vector3f SegmentFilter::ground_normal_in_base_link()
+{
+  if (!ground_plane_.has_value() || !vehicle_orientation_.has_value()) return lut_ground_normal_;
+
+  const Eigen::Vector3f normal =
+    (vehicle_orientation_->conjugate() * ground_plane_->normal).normalized();
+  // Small changes are ignored so that the table is not rebuilt on every frame
+  const float angle = std::acos(std::clamp(normal.dot(lut_ground_normal_), -1.f, 1.f));
+  if (angle > ground_tilt_threshold_) lut_ground_normal_ = normal;
+  return lut_ground_normal_;
+}
+
 bool SegmentFilter::define_project_func()
 {
-  if (project_func_) return true;
+  if (project_func_ && !projection_lut_) return true;
 
   if (info_.is_camera_info_nullopt()) return false;
   Eigen::Matrix3f Kinv = info_.intrinsic().inverse();
 
-  std::optional<Eigen::Affine3f> camera_extrinsic =
-    tf_subscriber_(info_.get_frame_id(), "base_link");
-  if (!camera_extrinsic.has_value()) return false;
+  // The extrinsic is static, so it is looked up again only when the camera frame changes
+  if (!camera_extrinsic_.has_value() || extrinsic_frame_id_ != info_.get_frame_id()) {
+    camera_extrinsic_ = tf_subscriber_(info_.get_frame_id(), "base_link");
+    if (!camera_extrinsic_.has_value()) return false;
+    extrinsic_frame_id_ = info_.get_frame_id();
+  }
+  const Eigen::Affine3f & camera_extrinsic = camera_extrinsic_.value();
+
+  if (projection_lut_) {
+    const Eigen::Matrix3f K = info_.intrinsic();
+    const Eigen::Vector3f normal = ground_normal_in_base_link();
+    if (!projection_lut_->is_built_for(K, info_.size(), camera_extrinsic, normal)) {
+      common::Timer timer;
+      projection_lut_->build(K, info_.size(), camera_extrinsic, normal);
+      RCLCPP_INFO_STREAM(get_logger(), "projection lut is built: " << timer);
+    }
+    project_func_ = [this](const Eigen::Vector3f & u) { return projection_lut_->project(u); };
+    return true;
+  }
 
-  const Eigen::Vector3f t = camera_extrinsic->translation();
-  const Eigen::Quaternionf q(camera_extrinsic->rotation());
+  const Eigen::Vector3f t = camera_extrinsic.translation();
+  const Eigen::Quaternionf q(camera_extrinsic.rotation());
 
-  // TODO: This will take into account ground tilt and camera vibration someday.
   project_func_ = [Kinv, q, t](const Eigen::Vector3f & u) -> std::optional<Eigen::Vector3f> {
     Eigen::Vector3f u3(u.x(), u.y(), 1);
     Eigen::Vector3f u_bearing = (q * Kinv * u3).normalized();
@@ -81,8 +138,15 @@ bool SegmentFilter::define_project_func()
   return true;
 }
 
-void SegmentFilter::execute(const PointCloud2 & line_segments_msg, const Image & segment_msg)
+void SegmentFilter::on_synchro(const PointCloud2 & line_segments_msg, const Image & segment_msg)
+{
+  execute(line_segments_msg, common::decompress_to_cv_mat(segment_msg));
+}
+
+void SegmentFilter::execute(const PointCloud2 & line_segments_msg, const cv::Mat & mask_image)
 {
+  YABLOC_TRACE_SCOPE("segment_filter/execute");
+  const auto start = stage_stamp_.start();
   if (!define_project_func()) {
     using namespace std::literals::chrono_literals;
     RCLCPP_INFO_STREAM_THROTTLE(
@@ -92,33 +156,39 @@ void SegmentFilter::execute(const PointCloud2 & line_segments_msg, const Image &
 
   const rclcpp::Time stamp = line_segments_msg.header.stamp;
 
-  pcl::PointCloud<pcl::PointNormal>::Ptr line_segments_cloud{new pcl::PointCloud<pcl::PointNormal>()};
-  cv::Mat mask_image = common::decompress_to_cv_mat(segment_msg);
-  pcl::fromROSMsg(line_segments_msg, *line_segments_cloud);
-
-  const std::set<int> indices = filt_by_mask(mask_image, *line_segments_cloud);
+  // The input is read in place, as it is converted into the projected one soon
+  const common::LineSegmentsView line_segments(line_segments_msg);
+  if (!line_segments.valid()) {
+    using namespace std::literals::chrono_literals;
+    RCLCPP_WARN_STREAM_THROTTLE(
+      get_logger(), *get_clock(), (1000ms).count(),
+      "Drop malformed line segments: " << line_segments.error());
+    return;
+  }
 
-  pcl::PointCloud<pcl::PointNormal> valid_edges = project_lines(*line_segments_cloud, indices);
-  pcl::PointCloud<pcl::PointNormal> invalid_edges = project_lines(*line_segments_cloud, indices, true);
+  std::vector<bool> flags;
+  pcl::PointCloud<pcl::PointNormal> valid_edges, invalid_edges;
+  {
+    YABLOC_TRACE_SCOPE("segment_filter/filt_and_project");
+    flags = filt_by_mask(mask_image, line_segments);
+    valid_edges = project_lines(line_segments, flags);
+    invalid_edges = project_lines(line_segments, flags, true);
+  }
 
   // Projected line segments
   {
-    pcl::PointCloud<pcl::PointXYZLNormal> combined_edges;
-    for (const auto & pn : valid_edges) {
-      pcl::PointXYZLNormal pln;
-      pln.getVector3fMap() = pn.getVector3fMap();
-      pln.getNormalVector3fMap() = pn.getNormalVector3fMap();
-      pln.label = 255;
-      combined_edges.push_back(pln);
-    }
-    for (const auto & pn : invalid_edges) {
-      pcl::PointXYZLNormal pln;
-      pln.getVector3fMap() = pn.getVector3fMap();
-      pln.getNormalVector3fMap() = pn.getNormalVector3fMap();
-      pln.label = 0;
-      combined_edges.push_back(pln);
-    }
-    common::publish_cloud(*pub_projected_cloud_, combined_edges, stamp);
+    std::vector<common::LineSegmentRecord> combined_edges;
+    combined_edges.reserve(valid_edges.size() + invalid_edges.size());
+    auto to_record = [](const pcl::PointNormal & pn, uint32_t label) {
+      return common::LineSegmentRecord{pn.x, pn.y, pn.z, pn.normal_x, pn.normal_y, pn.normal_z,
+                                       label};
+    };
+    for (const auto & pn : valid_edges) combined_edges.push_back(to_record(pn, 255));
+    for (const auto & pn : invalid_edges) combined_edges.push_back(to_record(pn, 0));
+    // The frame_id tells the corrector which camera the segments come from
+    common::publish_line_segments(
+      *pub_projected_cloud_, combined_edges, stamp, info_.get_frame_id());
+    stage_stamp_.publish(stamp, start);
   }
 
   // Image
@@ -139,17 +209,16 @@ void SegmentFilter::execute(const PointCloud2 & line_segments_msg, const Image &
 
   // Line segments for debug
   {
-    pcl::PointCloud<pcl::PointXYZLNormal> combined_debug_edges;
-    for (size_t index = 0; index < line_segments_cloud->size(); ++index) {
-      const pcl::PointNormal& pn = line_segments_cloud->at(index);
-      pcl::PointXYZLNormal pln;
-      pln.getVector3fMap() = pn.getVector3fMap();
-      pln.getNormalVector3fMap() = pn.getNormalVector3fMap();
-      if (indices.count(index) > 0) pln.label = 255;
-      else pln.label = 0;
-      combined_debug_edges.push_back(pln);
+    std::vector<common::LineSegmentRecord> combined_debug_edges;
+    combined_debug_edges.reserve(line_segments.size());
+    for (size_t index = 0; index < line_segments.size(); ++index) {
+      const Eigen::Vector3f from = line_segments.from(index);
+      const Eigen::Vector3f to = line_segments.to(index);
+      const uint32_t label = flags[index] ? 255 : 0;
+      combined_debug_edges.push_back(
+        {from.x(), from.y(), from.z(), to.x(), to.y(), to.z(), label});
     }
-    common::publish_cloud(*pub_debug_cloud_, combined_debug_edges, stamp);
+    common::publish_line_segments(*pub_debug_cloud_, combined_debug_edges, stamp);
   }
 }
 
@@ -176,37 +245,15 @@ bool SegmentFilter::is_near_element(
   return true;
 }
 
-std::set<ushort> get_unique_pixel_value(cv::Mat & image)
-{
-  // `image` is a set of ushort.
-  // The purpose is to find the unduplicated set of values contained in `image`.
-  // For example, if `image` is {0,1,2,0,1,2,3}, this function returns {0,1,2,3}.
-
-  if (image.depth() != CV_16U) throw std::runtime_error("image's depth must be ushort");
-
-  auto begin = image.begin<ushort>();
-  auto last = std::unique(begin, image.end<ushort>());
-  std::sort(begin, last);
-  last = std::unique(begin, last);
-  return std::set<ushort>(begin, last);
-}
-
 pcl::PointCloud<pcl::PointNormal> SegmentFilter::project_lines(
-  const pcl::PointCloud<pcl::PointNormal> & points, const std::set<int> & indices,
-  bool negative) const
+  const common::LineSegmentsView & points, const std::vector<bool> & flags, bool negative) const
 {
   pcl::PointCloud<pcl::PointNormal> projected_points;
-  for (int index = 0; index < points.size(); ++index) {
-    if (negative) {
-      if (indices.count(index) > 0) continue;
-    } else {
-      if (indices.count(index) == 0) continue;
-    }
-
-    pcl::PointNormal truncated_pn = points.at(index);
+  for (size_t index = 0; index < points.size(); ++index) {
+    if (flags[index] == negative) continue;
 
-    std::optional<Eigen::Vector3f> opt1 = project_func_(truncated_pn.getVector3fMap());
-    std::optional<Eigen::Vector3f> opt2 = project_func_(truncated_pn.getNormalVector3fMap());
+    std::optional<Eigen::Vector3f> opt1 = project_func_(points.from(index));
+    std::optional<Eigen::Vector3f> opt2 = project_func_(points.to(index));
     if (!opt1.has_value()) continue;
     if (!opt2.has_value()) continue;
 
@@ -239,40 +286,11 @@ pcl::PointCloud<pcl::PointNormal> SegmentFilter::project_lines(
   return projected_points;
 }
 
-std::set<int> SegmentFilter::filt_by_mask(
-  const cv::Mat & mask, const pcl::PointCloud<pcl::PointNormal> & edges)
+std::vector<bool> SegmentFilter::filt_by_mask(
+  const cv::Mat & mask, const common::LineSegmentsView & edges) const
 {
-  // Create line image and assign different color to each segment.
-  cv::Mat line_image = cv::Mat::zeros(mask.size(), CV_16UC1);
-  for (size_t i = 0; i < edges.size(); i++) {
-    auto & pn = edges.at(i);
-    Eigen::Vector3f p1 = pn.getVector3fMap();
-    Eigen::Vector3f p2 = pn.getNormalVector3fMap();
-    cv::Scalar color = cv::Scalar::all(i + 1);
-    cv::line(
-      line_image, cv::Point2i(p1.x(), p1.y()), cv::Point2i(p2.x(), p2.y()), color, 1,
-      cv::LineTypes::LINE_4);
-  }
-
-  cv::Mat mask_image;
-  mask.convertTo(mask_image, CV_16UC1);
-  cv::threshold(mask_image, mask_image, 1, std::numeric_limits<ushort>::max(), cv::THRESH_BINARY);
-
-  // TODO: Using boost::geometry is more intuitive.
-  // https://boostjp.github.io/tips/geometry.html#disjoint
-
-  // And operator
-  cv::Mat masked_line;
-  cv::bitwise_and(mask_image, line_image, masked_line);
-  std::set<ushort> pixel_values = get_unique_pixel_value(masked_line);
-
-  // Extract edges within masks
-  std::set<int> reliable_indices;
-  for (size_t i = 0; i < edges.size(); i++) {
-    if (pixel_values.count(i + 1) != 0) reliable_indices.insert(i);
-  }
-
-  return reliable_indices;
+  if (use_direct_mask_sampling_) return filt_by_mask_direct(mask, edges);
+  return filt_by_mask_raster(mask, edges);
 }
 
 }  // namespace yabloc::segment_filter
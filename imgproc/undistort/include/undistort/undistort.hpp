@@ -0,0 +1,73 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <opencv4/opencv2/core.hpp>
+#include <rclcpp/rclcpp.hpp>
+#include <yabloc_common/latest_only_subscription.hpp>
+#include <yabloc_common/stage_stamp_publisher.hpp>
+#include <yabloc_common/trace_reporter.hpp>
+
+#include <sensor_msgs/msg/camera_info.hpp>
+#include <sensor_msgs/msg/compressed_image.hpp>
+#include <sensor_msgs/msg/image.hpp>
+
+#include <optional>
+#include <string>
+
+namespace yabloc::undistort
+{
+class UndistortNode : public rclcpp::Node
+{
+public:
+  using CompressedImage = sensor_msgs::msg::CompressedImage;
+  using CameraInfo = sensor_msgs::msg::CameraInfo;
+  using Image = sensor_msgs::msg::Image;
+
+  explicit UndistortNode(const rclcpp::NodeOptions & options = rclcpp::NodeOptions());
+
+private:
+  const int OUTPUT_WIDTH;
+  const std::string OVERRIDE_FRAME_ID;
+  const bool USE_REDUCED_DECODE;
+
+  common::LatestOnlySubscription<CompressedImage>::SharedPtr sub_image_;
+  rclcpp::Subscription<CameraInfo>::SharedPtr sub_info_;
+  rclcpp::Publisher<Image>::SharedPtr pub_image_;
+  rclcpp::Publisher<Image>::SharedPtr pub_gray_image_;
+  rclcpp::Publisher<CameraInfo>::SharedPtr pub_info_;
+  std::optional<CameraInfo> info_{std::nullopt};
+  std::optional<CameraInfo> scaled_info_{std::nullopt};
+
+  int decode_scale_{1};
+  cv::Size remap_src_size_;
+  cv::Mat undistort_map_x, undistort_map_y;
+
+  common::TraceReporter trace_reporter_{this};
+  common::StageStampPublisher decode_stamp_{this, "decode"};
+  common::StageStampPublisher undistort_stamp_{this, "undistort"};
+
+  // The remap is built against the size of the decoded image. When the image is decoded at a
+  // reduced scale, the intrinsics are rescaled so that the output is identical in geometry.
+  void make_remap_lut(const cv::Size & src_size);
+
+  void on_image(const CompressedImage & msg);
+
+  void publish_image(
+    rclcpp::Publisher<Image> & publisher, const cv::Mat & image, const std::string & encoding,
+    const std_msgs::msg::Header & src_header);
+
+  void on_info(const CameraInfo & msg);
+};
+}  // namespace yabloc::undistort
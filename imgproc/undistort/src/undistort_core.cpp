@@ -0,0 +1,164 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "undistort/undistort.hpp"
+
+#include <opencv4/opencv2/calib3d.hpp>
+#include <opencv4/opencv2/imgproc.hpp>
+#include <yabloc_common/cv_decompress.hpp>
+#include <yabloc_common/trace.hpp>
+
+#include <cv_bridge/cv_bridge.h>
+
+namespace yabloc::undistort
+{
+UndistortNode::UndistortNode(const rclcpp::NodeOptions & options)
+: Node("undistort", options),
+  OUTPUT_WIDTH(declare_parameter("width", 800)),
+  OVERRIDE_FRAME_ID(declare_parameter("override_frame_id", "")),
+  USE_REDUCED_DECODE(declare_parameter("use_reduced_decode", true))
+{
+  using std::placeholders::_1;
+
+  rclcpp::QoS qos{10};
+  if (declare_parameter("use_sensor_qos", false)) {
+    qos = rclcpp::QoS(10).durability_volatile().best_effort();
+  }
+
+  auto on_image = std::bind(&UndistortNode::on_image, this, _1);
+  auto on_info = std::bind(&UndistortNode::on_info, this, _1);
+  sub_image_ = std::make_shared<common::LatestOnlySubscription<CompressedImage>>(
+    this, "src_image", qos, std::move(on_image), declare_parameter("latest_only", true));
+  decode_stamp_.set_drop_counter([this]() { return sub_image_->dropped_count(); });
+  sub_info_ = create_subscription<CameraInfo>("src_info", qos, std::move(on_info));
+
+  pub_info_ = create_publisher<CameraInfo>("resized_info", 10);
+  pub_image_ = create_publisher<Image>("resized_image", 10);
+  pub_gray_image_ = create_publisher<Image>("resized_gray_image", 10);
+}
+
+void UndistortNode::make_remap_lut(const cv::Size & src_size)
+{
+  if (!info_.has_value()) return;
+  cv::Mat K = cv::Mat(cv::Size(3, 3), CV_64FC1, (void *)(info_->k.data())).clone();
+  cv::Mat D = cv::Mat(cv::Size(5, 1), CV_64FC1, (void *)(info_->d.data()));
+  cv::Size size(info_->width, info_->height);
+
+  cv::Size new_size = size;
+  if (OUTPUT_WIDTH > 0)
+    new_size = cv::Size(OUTPUT_WIDTH, 1.0f * OUTPUT_WIDTH / size.width * size.height);
+
+  if (src_size != size) {
+    // Pixel centers move as u' = (u + 0.5) * ratio - 0.5 when an image is reduced
+    const double ratio_x = static_cast<double>(src_size.width) / size.width;
+    const double ratio_y = static_cast<double>(src_size.height) / size.height;
+    K.at<double>(0, 0) *= ratio_x;
+    K.at<double>(0, 2) = (K.at<double>(0, 2) + 0.5) * ratio_x - 0.5;
+    K.at<double>(1, 1) *= ratio_y;
+    K.at<double>(1, 2) = (K.at<double>(1, 2) + 0.5) * ratio_y - 0.5;
+    size = src_size;
+  }
+
+  cv::Mat new_K = cv::getOptimalNewCameraMatrix(K, D, size, 0, new_size);
+
+  cv::initUndistortRectifyMap(
+    K, D, cv::Mat(), new_K, new_size, CV_32FC1, undistort_map_x, undistort_map_y);
+
+  scaled_info_ = sensor_msgs::msg::CameraInfo{};
+  scaled_info_->k.at(0) = new_K.at<double>(0, 0);
+  scaled_info_->k.at(2) = new_K.at<double>(0, 2);
+  scaled_info_->k.at(4) = new_K.at<double>(1, 1);
+  scaled_info_->k.at(5) = new_K.at<double>(1, 2);
+  scaled_info_->k.at(8) = 1;
+  scaled_info_->d.resize(5);
+  scaled_info_->width = new_size.width;
+  scaled_info_->height = new_size.height;
+  remap_src_size_ = src_size;
+}
+
+void UndistortNode::on_image(const CompressedImage & msg)
+{
+  if (!info_.has_value()) return;
+  if (undistort_map_x.empty() && USE_REDUCED_DECODE) {
+    decode_scale_ = common::reduced_decode_scale(info_->width, OUTPUT_WIDTH);
+    RCLCPP_INFO_STREAM(get_logger(), "decode image at 1/" << decode_scale_ << " scale");
+  }
+
+  YABLOC_TRACE_SCOPE("undistort/on_image");
+  const auto start = decode_stamp_.start();
+  const bool gray_requested = pub_gray_image_->get_subscription_count() > 0;
+  // Bayer images give their luminance for free while binning, otherwise convert after remap,
+  // because the undistorted image is smaller than the decoded one.
+  const bool is_bayer = msg.format.find("bayer") != std::string::npos;
+
+  cv::Mat image, luminance;
+  {
+    YABLOC_TRACE_SCOPE("undistort/decode");
+    if (gray_requested && is_bayer)
+      image = common::decompress_to_cv_mat(msg, decode_scale_, luminance);
+    else
+      image = common::decompress_to_cv_mat(msg, decode_scale_);
+  }
+  decode_stamp_.publish(msg.header.stamp, start);
+  const auto undistort_start = undistort_stamp_.start();
+
+  if (image.size() != remap_src_size_) make_remap_lut(image.size());
+
+  cv::Mat undistorted_image, undistorted_gray_image;
+  {
+    YABLOC_TRACE_SCOPE("undistort/remap");
+    cv::remap(image, undistorted_image, undistort_map_x, undistort_map_y, cv::INTER_LINEAR);
+    if (!luminance.empty()) {
+      cv::remap(
+        luminance, undistorted_gray_image, undistort_map_x, undistort_map_y, cv::INTER_LINEAR);
+    } else if (gray_requested) {
+      cv::cvtColor(undistorted_image, undistorted_gray_image, cv::COLOR_BGR2GRAY);
+    }
+  }
+
+  // Publish CameraInfo
+  {
+    scaled_info_->header = info_->header;
+    if (OVERRIDE_FRAME_ID != "") scaled_info_->header.frame_id = OVERRIDE_FRAME_ID;
+    pub_info_->publish(scaled_info_.value());
+  }
+
+  // Publish Image
+  publish_image(*pub_image_, undistorted_image, "bgr8", msg.header);
+
+  // Publish gray image only when someone needs it
+  if (!undistorted_gray_image.empty()) {
+    publish_image(*pub_gray_image_, undistorted_gray_image, "mono8", msg.header);
+  }
+
+  undistort_stamp_.publish(msg.header.stamp, undistort_start);
+}
+
+void UndistortNode::publish_image(
+  rclcpp::Publisher<Image> & publisher, const cv::Mat & image, const std::string & encoding,
+  const std_msgs::msg::Header & src_header)
+{
+  cv_bridge::CvImage bridge;
+  bridge.header.stamp = src_header.stamp;
+  if (OVERRIDE_FRAME_ID != "")
+    bridge.header.frame_id = OVERRIDE_FRAME_ID;
+  else
+    bridge.header.frame_id = src_header.frame_id;
+  bridge.encoding = encoding;
+  bridge.image = image;
+  publisher.publish(*bridge.toImageMsg());
+}
+
+void UndistortNode::on_info(const CameraInfo & msg) { info_ = msg; }
+}  // namespace yabloc::undistort
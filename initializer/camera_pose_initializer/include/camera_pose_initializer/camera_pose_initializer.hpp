@@ -46,6 +46,8 @@ public:
 
 private:
   const int angle_resolution_;
+  // Cache files are stored in this directory. An empty string disables the cache.
+  const std::string cache_dir_;
   std::unique_ptr<LaneImage> lane_image_{nullptr};
   std::unique_ptr<initializer::MarkerModule> marker_module_{nullptr};
   std::unique_ptr<initializer::ProjectorModule> projector_module_{nullptr};
@@ -60,7 +62,7 @@ private:
   rclcpp::CallbackGroup::SharedPtr service_callback_group_;
 
   std::optional<Image::ConstSharedPtr> latest_image_msg_{std::nullopt};
-  lanelet::ConstLanelets const_lanelets_;
+  std::shared_ptr<const LaneBounds> lane_bounds_{nullptr};
 
   void on_map(const HADMapBin & msg);
   void on_service(
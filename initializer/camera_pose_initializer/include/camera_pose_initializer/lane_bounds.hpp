@@ -0,0 +1,49 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <Eigen/Core>
+
+#include <lanelet2_core/LaneletMap.h>
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace yabloc
+{
+// 2D polylines of the lanelets, which are all that the initializer needs from the map.
+// They are flat arrays so that they are stored in the map cache as they are.
+struct LaneBounds
+{
+  // Each polyline is points[begin, end)
+  struct Range
+  {
+    uint32_t right_begin, right_end;
+    uint32_t left_begin, left_end;
+    uint32_t center_begin, center_end;
+  };
+
+  std::vector<Range> ranges;
+  std::vector<Eigen::Vector2d> points;
+
+  static LaneBounds from_map(const lanelet::LaneletMap & map);
+};
+
+// Return the direction of the centerline segment closest to the position in the lanelet which
+// contains the position. Return nullopt if no lanelet contains it.
+std::optional<double> get_current_direction(
+  const LaneBounds & bounds, const Eigen::Vector3f & query_position);
+
+}  // namespace yabloc
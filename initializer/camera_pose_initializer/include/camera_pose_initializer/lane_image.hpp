@@ -13,12 +13,14 @@
 // limitations under the License.
 
 #pragma once
+#include "camera_pose_initializer/lane_bounds.hpp"
+
 #include <Eigen/Geometry>
 #include <opencv2/core.hpp>
 
 #include <geometry_msgs/msg/pose.hpp>
 
-#include <lanelet2_core/LaneletMap.h>
+#include <memory>
 
 namespace yabloc
 {
@@ -27,13 +29,13 @@ class LaneImage
 public:
   using Pose = geometry_msgs::msg::Pose;
   using SharedPtr = std::shared_ptr<LaneImage>;
-  LaneImage(lanelet::LaneletMapPtr map);
+  LaneImage(std::shared_ptr<const LaneBounds> bounds);
 
   cv::Mat get_image(const Pose & pose);
 
   cv::Mat create_vectormap_image(const Eigen::Vector3f & position);
 
 private:
-  lanelet::LaneletMapPtr map_;
+  std::shared_ptr<const LaneBounds> bounds_;
 };
 }  // namespace yabloc
\ No newline at end of file
@@ -13,9 +13,9 @@
 // limitations under the License.
 
 #include "camera_pose_initializer/camera_pose_initializer.hpp"
-#include "camera_pose_initializer/lanelet_util.hpp"
 
 #include <ll2_decomposer/from_bin_msg.hpp>
+#include <ll2_decomposer/map_cache.hpp>
 #include <opencv2/highgui.hpp>
 #include <opencv2/imgproc.hpp>
 
@@ -25,8 +25,16 @@
 
 namespace yabloc
 {
+namespace
+{
+// Bump it whenever the derivation of the cached lanelet bounds changes
+constexpr int CACHE_VERSION = 1;
+}  // namespace
+
 CameraPoseInitializer::CameraPoseInitializer()
-: Node("camera_pose_initializer"), angle_resolution_{declare_parameter("angle_resolution", 30)}
+: Node("camera_pose_initializer"),
+  angle_resolution_{declare_parameter("angle_resolution", 30)},
+  cache_dir_{declare_parameter<std::string>("cache_dir", "")}
 {
   using std::placeholders::_1;
   using std::placeholders::_2;
@@ -122,7 +130,7 @@ bool CameraPoseInitializer::estimate_pose(
   }
 
   const std::optional<double> lane_angle_rad =
-    lanelet::get_current_direction(const_lanelets_, position);
+    get_current_direction(*lane_bounds_, position);
 
   cv::Mat projected_image = projector_module_->project_image(semseg_image);
   cv::Mat vectormap_image = lane_image_->create_vectormap_image(position);
@@ -173,13 +181,43 @@ bool CameraPoseInitializer::estimate_pose(
 
 void CameraPoseInitializer::on_map(const HADMapBin & msg)
 {
-  lanelet::LaneletMapPtr lanelet_map = ll2_decomposer::from_bin_msg(msg);
-  lane_image_ = std::make_unique<LaneImage>(lanelet_map);
+  const uint64_t key =
+    ll2_decomposer::hash_combine(ll2_decomposer::hash_map_bin(msg), std::to_string(CACHE_VERSION));
+  const std::string cache_path =
+    ll2_decomposer::map_cache_path(cache_dir_, "camera_pose_initializer", key);
+
+  auto bounds = std::make_shared<LaneBounds>();
+  bool loaded = false;
+  if (!cache_dir_.empty()) {
+    ll2_decomposer::MapCacheReader reader;
+    if (reader.open(cache_path, key)) {
+      size_t range_count = 0, point_count = 0;
+      const auto * ranges = reader.elements<LaneBounds::Range>("lanelets", range_count);
+      const auto * points = reader.elements<Eigen::Vector2d>("lanelet_points", point_count);
+      if (ranges != nullptr && points != nullptr) {
+        bounds->ranges.assign(ranges, ranges + range_count);
+        bounds->points.assign(points, points + point_count);
+        loaded = true;
+        RCLCPP_INFO_STREAM(get_logger(), "lanelet bounds are loaded from cache");
+      }
+    }
+  }
 
-  const_lanelets_.clear();
-  for (auto l : lanelet_map->laneletLayer) {
-    const_lanelets_.push_back(l);
+  if (!loaded) {
+    lanelet::LaneletMapPtr lanelet_map = ll2_decomposer::from_bin_msg(msg);
+    *bounds = LaneBounds::from_map(*lanelet_map);
+
+    if (!cache_dir_.empty()) {
+      ll2_decomposer::MapCacheWriter writer;
+      writer.add("lanelets", bounds->ranges);
+      writer.add("lanelet_points", bounds->points);
+      if (!writer.write(cache_path, key))
+        RCLCPP_WARN_STREAM(get_logger(), "lanelet cache cannot be written to " << cache_path);
+    }
   }
+
+  lane_bounds_ = bounds;
+  lane_image_ = std::make_unique<LaneImage>(lane_bounds_);
 }
 
 void CameraPoseInitializer::on_service(
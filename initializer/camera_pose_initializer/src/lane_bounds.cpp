@@ -0,0 +1,108 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "camera_pose_initializer/lane_bounds.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace yabloc
+{
+namespace
+{
+template <typename LineString>
+void append(const LineString & line, std::vector<Eigen::Vector2d> & points)
+{
+  for (const auto & p : line) points.emplace_back(p.x(), p.y());
+}
+
+// Even-odd rule over the polygon of the right bound and the reversed left bound
+bool inside(const LaneBounds & bounds, const LaneBounds::Range & range, const Eigen::Vector2d & q)
+{
+  std::vector<Eigen::Vector2d> polygon;
+  polygon.insert(
+    polygon.end(), bounds.points.begin() + range.right_begin,
+    bounds.points.begin() + range.right_end);
+  for (uint32_t i = range.left_end; i > range.left_begin; --i)
+    polygon.push_back(bounds.points[i - 1]);
+  if (polygon.size() < 3) return false;
+
+  bool is_inside = false;
+  for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++) {
+    const Eigen::Vector2d & a = polygon[i];
+    const Eigen::Vector2d & b = polygon[j];
+    if ((a.y() > q.y()) == (b.y() > q.y())) continue;
+    const double x = a.x() + (q.y() - a.y()) * (b.x() - a.x()) / (b.y() - a.y());
+    if (q.x() < x) is_inside = !is_inside;
+  }
+  return is_inside;
+}
+
+double distance_to_segment(
+  const Eigen::Vector2d & q, const Eigen::Vector2d & from, const Eigen::Vector2d & to)
+{
+  const Eigen::Vector2d d = to - from;
+  const double sq_length = d.squaredNorm();
+  if (sq_length < 1e-12) return (q - from).norm();
+  const double t = std::clamp((q - from).dot(d) / sq_length, 0.0, 1.0);
+  return (from + t * d - q).norm();
+}
+}  // namespace
+
+LaneBounds LaneBounds::from_map(const lanelet::LaneletMap & map)
+{
+  LaneBounds bounds;
+  bounds.ranges.reserve(map.laneletLayer.size());
+  for (const lanelet::ConstLanelet & lanelet : map.laneletLayer) {
+    Range range;
+    range.right_begin = bounds.points.size();
+    append(lanelet.rightBound2d(), bounds.points);
+    range.right_end = range.left_begin = bounds.points.size();
+    append(lanelet.leftBound2d(), bounds.points);
+    range.left_end = range.center_begin = bounds.points.size();
+    append(lanelet.centerline2d(), bounds.points);
+    range.center_end = bounds.points.size();
+    bounds.ranges.push_back(range);
+  }
+  return bounds;
+}
+
+std::optional<double> get_current_direction(
+  const LaneBounds & bounds, const Eigen::Vector3f & query_position)
+{
+  const Eigen::Vector2d q = query_position.topRows(2).cast<double>();
+
+  // TODO: consider all lanelet too
+  for (const LaneBounds::Range & range : bounds.ranges) {
+    if (!inside(bounds, range, q)) continue;
+    if (range.center_end - range.center_begin < 2) return std::nullopt;
+
+    double min_distance = std::numeric_limits<double>::max();
+    Eigen::Vector2d direction = Eigen::Vector2d::Zero();
+    for (uint32_t i = range.center_begin + 1; i < range.center_end; ++i) {
+      const Eigen::Vector2d & from = bounds.points[i - 1];
+      const Eigen::Vector2d & to = bounds.points[i];
+      const double distance = distance_to_segment(q, from, to);
+      if (distance < min_distance) {
+        min_distance = distance;
+        direction = to - from;
+      }
+    }
+    return std::atan2(direction.y(), direction.x());
+  }
+  return std::nullopt;
+}
+
+}  // namespace yabloc
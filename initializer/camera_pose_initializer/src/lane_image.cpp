@@ -21,7 +21,6 @@
 #include <boost/geometry/geometries/box.hpp>
 #include <boost/geometry/geometries/point_xy.hpp>
 #include <boost/geometry/geometries/polygon.hpp>
-#include <boost/range/adaptors.hpp>
 
 namespace yabloc
 {
@@ -31,7 +30,7 @@ typedef bg::model::d2::point_xy<double> point_t;
 typedef bg::model::box<point_t> box_t;
 typedef bg::model::polygon<point_t> polygon_t;
 
-LaneImage::LaneImage(lanelet::LaneletMapPtr map) : map_(map) {}
+LaneImage::LaneImage(std::shared_ptr<const LaneBounds> bounds) : bounds_(bounds) {}
 
 cv::Point2i to_cv_point(const Eigen::Vector3f & v)
 {
@@ -66,11 +65,13 @@ void draw_lane(cv::Mat & image, const polygon_t & polygon)
   cv::drawContours(image, contours, -1, cv::Scalar(255, 0, 0), -1);
 }
 
-void draw_line(cv::Mat & image, const lanelet::LineString2d & line, geometry_msgs::msg::Point xyz)
+void draw_line(
+  cv::Mat & image, const Eigen::Vector2d * begin, const Eigen::Vector2d * end,
+  geometry_msgs::msg::Point xyz)
 {
   std::vector<cv::Point> contour;
-  for (auto p : line) {
-    cv::Point2i pt = to_cv_point({p.x() - xyz.x, p.y() - xyz.y, 0});
+  for (const Eigen::Vector2d * p = begin; p != end; ++p) {
+    cv::Point2i pt = to_cv_point({p->x() - xyz.x, p->y() - xyz.y, 0});
     contour.push_back(pt);
   }
   cv::polylines(image, contour, false, cv::Scalar(0, 0, 255), 2);
@@ -83,24 +84,25 @@ cv::Mat LaneImage::get_image(const Pose & pose)
 
   cv::Mat image = cv::Mat::zeros(cv::Size(800, 800), CV_8UC3);
 
-  std::vector<lanelet::Lanelet> joint_lanes;
-  for (auto lanelet : map_->laneletLayer) {
+  const Eigen::Vector2d * points = bounds_->points.data();
+  std::vector<LaneBounds::Range> joint_lanes;
+  for (const LaneBounds::Range & range : bounds_->ranges) {
     polygon_t polygon;
-    for (auto right : lanelet.rightBound2d()) {
-      polygon.outer().push_back(point_t(right.x() - xyz.x, right.y() - xyz.y));
+    for (uint32_t i = range.right_begin; i < range.right_end; ++i) {
+      polygon.outer().push_back(point_t(points[i].x() - xyz.x, points[i].y() - xyz.y));
     }
-    for (auto left : boost::adaptors::reverse(lanelet.leftBound2d())) {
-      polygon.outer().push_back(point_t(left.x() - xyz.x, left.y() - xyz.y));
+    for (uint32_t i = range.left_end; i > range.left_begin; --i) {
+      polygon.outer().push_back(point_t(points[i - 1].x() - xyz.x, points[i - 1].y() - xyz.y));
     }
 
     if (!bg::disjoint(box, polygon)) {
-      joint_lanes.push_back(lanelet);
+      joint_lanes.push_back(range);
       draw_lane(image, polygon);
     }
   }
-  for (auto lanelet : joint_lanes) {
-    draw_line(image, lanelet.rightBound2d(), xyz);
-    draw_line(image, lanelet.leftBound2d(), xyz);
+  for (const LaneBounds::Range & range : joint_lanes) {
+    draw_line(image, points + range.right_begin, points + range.right_end, xyz);
+    draw_line(image, points + range.left_begin, points + range.left_end, xyz);
   }
 
   return image;
@@ -0,0 +1,80 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <Eigen/Core>
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace yabloc::ground_server
+{
+// 2.5D grid which holds a local ground plane per cell. It is built once from the ground cloud,
+// and a query interpolates the planes of the four cells around the position.
+// Cells where the ground is not a single plane (e.g. under a bridge) are left empty, and the
+// caller falls back to the estimation from the cloud.
+class GroundGrid
+{
+public:
+  struct Plane
+  {
+    float height;
+    Eigen::Vector3f normal;
+  };
+
+  // Flat form of a cell to store the grid in the map cache
+  struct CellRecord
+  {
+    int32_t x, y;
+    float height;
+    float normal[3];
+  };
+
+  // The plane of a cell is fitted to the points within the radius from its center.
+  // If any of the points is farther than the threshold from the plane, the cell is left empty.
+  // A cell is also left empty if the points lie almost on a line, i.e. the ratio of the middle to
+  // the largest eigenvalue of their covariance is below min_spread_ratio, because the tilt
+  // across the line is not determined.
+  GroundGrid(
+    const pcl::PointCloud<pcl::PointXYZ> & cloud, float resolution, float radius,
+    float outlier_threshold = 1.0f, float min_spread_ratio = 0.01f);
+
+  // Restore the grid from records()
+  GroundGrid(const CellRecord * records, size_t count, float resolution);
+
+  std::vector<CellRecord> records() const;
+
+  std::optional<Plane> at(float x, float y) const;
+
+  size_t size() const { return cells_.size(); }
+
+private:
+  struct Cell
+  {
+    float height;  // at the center of the cell
+    Eigen::Vector3f normal;
+  };
+
+  const float resolution_;
+  std::unordered_map<uint64_t, Cell> cells_;
+
+  int32_t to_index(float v) const;
+  static uint64_t to_key(int32_t x, int32_t y);
+};
+}  // namespace yabloc::ground_server
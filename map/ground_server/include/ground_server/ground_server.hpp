@@ -15,6 +15,9 @@
 #pragma once
 #include "ground_server/filter/low_pass_filter.hpp"
 #include "ground_server/filter/moving_averaging.hpp"
+#include "ground_server/ground_grid.hpp"
+#include "ground_server/min_height_grid.hpp"
+#include "ground_server/plane_tracker.hpp"
 
 #include <rclcpp/rclcpp.hpp>
 #include <yabloc_common/ground_plane.hpp>
@@ -60,6 +63,12 @@ private:
   const bool force_zero_tilt_;
   const float R;
   const int K;
+  // Cache files are stored in this directory. An empty string disables the cache.
+  const std::string cache_dir_;
+  const bool use_ground_grid_;
+  const float ground_grid_resolution_;
+  const float ground_grid_radius_;
+  const bool incremental_tracking_;
 
   // Service
   rclcpp::Service<Ground>::SharedPtr service_;
@@ -76,16 +85,23 @@ private:
 
   pcl::PointCloud<pcl::PointXYZ>::Ptr cloud_{nullptr};
   pcl::KdTreeFLANN<pcl::PointXYZ>::Ptr kdtree_{nullptr};
+  std::unique_ptr<GroundGrid> ground_grid_{nullptr};
+  std::unique_ptr<MinHeightGrid> min_height_grid_{nullptr};
 
   // Smoother
   MovingAveraging normal_filter_;
   LowPassFilter height_filter_;
+  PlaneTracker plane_tracker_;
 
   // For debug
   std::vector<int> last_indices_;
 
   // Callback
   void on_map(const HADMapBin & msg);
+
+  // Load the ground cloud and the grids which exist in the cache file
+  void load_cache(const std::string & path, uint64_t key);
+  void save_cache(const std::string & path, uint64_t key) const;
   void on_initial_pose(const PoseCovStamped & msg);
   void on_pose_stamped(const PoseStamped & msg);
   void on_service(
@@ -94,6 +110,9 @@ private:
   // Body
   GroundPlane estimate_ground(const Point & point);
 
+  // Reject a normal vector which is NaN or too tilted
+  Eigen::Vector3f validate_normal(Eigen::Vector3f normal) const;
+
   // Return inlier indices which are belong to a plane
   // Sometimes, this return empty indices due to RANSAC failure
   std::vector<int> estimate_inliers_by_ransac(const std::vector<int> & indices_raw);
@@ -0,0 +1,60 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <Eigen/Core>
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace yabloc::ground_server
+{
+// 2D grid to find the lowest point within the radius around a position.
+// The cell size equals the radius, so a query visits at most 3x3 cells. The points of each cell
+// are sorted by height, so the first one is the min-height of the cell and a scan stops early.
+class MinHeightGrid
+{
+public:
+  MinHeightGrid(const pcl::PointCloud<pcl::PointXYZ> & cloud, float radius);
+
+  // Flat form to store the grid in the map cache. The points of a cell are
+  // points[begin, end) in the sorted order.
+  struct CellRecord
+  {
+    int32_t x, y;
+    uint32_t begin, end;
+  };
+
+  // Restore the grid from export_records() without sorting again
+  MinHeightGrid(
+    const CellRecord * cells, size_t cell_count, const Eigen::Vector3f * points, float radius);
+
+  void export_records(std::vector<CellRecord> & cells, std::vector<Eigen::Vector3f> & points) const;
+
+  // Return nullopt if there is no point within the radius
+  std::optional<float> lowest_height(float x, float y) const;
+
+private:
+  const float radius_;
+  std::unordered_map<uint64_t, std::vector<Eigen::Vector3f>> cells_;
+
+  int32_t to_index(float v) const;
+  static uint64_t to_key(int32_t x, int32_t y);
+};
+}  // namespace yabloc::ground_server
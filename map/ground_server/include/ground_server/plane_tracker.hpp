@@ -0,0 +1,81 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <Eigen/Core>
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <vector>
+
+namespace yabloc::ground_server
+{
+// Track the ground plane around consecutive poses without estimating it from scratch.
+// The neighborhood is reused while the pose stays near the position where it was searched.
+// When a new neighborhood is given, its points which fit the current plane replace the inliers,
+// and the plane is updated by adding and removing their moments instead of recomputing the
+// covariance. If too few points fit, the caller has to estimate inliers by RANSAC and reset.
+// The moments are taken around a local origin, and they are rebuilt from the inliers every
+// REBUILD_INTERVAL updates so that the rounding errors of the additions do not pile up.
+class PlaneTracker
+{
+public:
+  PlaneTracker(float reuse_distance, float inlier_threshold, float min_inlier_ratio);
+
+  bool can_reuse(const Eigen::Vector2f & position) const;
+
+  // Return false if the tracked plane does not explain the neighborhood any longer
+  bool update(
+    const pcl::PointCloud<pcl::PointXYZ> & cloud, const std::vector<int> & neighbors,
+    const Eigen::Vector2f & position);
+
+  void reset(
+    const pcl::PointCloud<pcl::PointXYZ> & cloud, std::vector<int> inliers,
+    const Eigen::Vector2f & position);
+
+  void invalidate() { valid_ = false; }
+
+  const std::vector<int> & indices() const { return indices_; }
+  const Eigen::Vector3f & centroid() const { return centroid_; }
+  // The normal faces upward
+  const Eigen::Vector3f & normal() const { return normal_; }
+
+private:
+  const float reuse_distance_;
+  const float inlier_threshold_;
+  const float min_inlier_ratio_;
+
+  bool valid_{false};
+  Eigen::Vector2f position_;
+  // Sorted indices of the inliers
+  std::vector<int> indices_;
+  static constexpr int REBUILD_INTERVAL = 100;
+  int updates_since_rebuild_{0};
+
+  // Moments of the inliers relative to the origin. Map coordinates are large, so the points are
+  // shifted to near the origin to keep the significant digits of the outer products.
+  Eigen::Vector3d origin_{Eigen::Vector3d::Zero()};
+  Eigen::Vector3d sum_;
+  Eigen::Matrix3d sum_outer_;
+
+  Eigen::Vector3f centroid_{Eigen::Vector3f::Zero()};
+  Eigen::Vector3f normal_{Eigen::Vector3f::UnitZ()};
+
+  void accumulate(const pcl::PointXYZ & p, double sign);
+  // Recompute the moments of the current inliers around their first point
+  void rebuild(const pcl::PointCloud<pcl::PointXYZ> & cloud);
+  void solve();
+};
+}  // namespace yabloc::ground_server
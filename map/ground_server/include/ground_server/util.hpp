@@ -19,9 +19,6 @@
 #include <pcl/point_cloud.h>
 #include <pcl/point_types.h>
 
-#include <unordered_set>
-#include <vector>
-
 namespace yabloc::ground_server
 {
 void upsample_line_string(
@@ -39,15 +36,4 @@ void upsample_line_string(
   }
 };
 
-std::vector<int> merge_indices(const std::vector<int> & indices1, const std::vector<int> & indices2)
-{
-  std::unordered_set<int> set;
-  for (int i : indices1) set.insert(i);
-  for (int i : indices2) set.insert(i);
-
-  std::vector<int> indices;
-  indices.assign(set.begin(), set.end());
-  return indices;
-}
-
 }  // namespace yabloc::ground_server
\ No newline at end of file
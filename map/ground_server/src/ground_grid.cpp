@@ -0,0 +1,164 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ground_server/ground_grid.hpp"
+
+#include <Eigen/Eigenvalues>
+
+#include <cmath>
+#include <unordered_set>
+#include <vector>
+
+namespace yabloc::ground_server
+{
+int32_t GroundGrid::to_index(float v) const
+{
+  return static_cast<int32_t>(std::floor(v / resolution_));
+}
+
+uint64_t GroundGrid::to_key(int32_t x, int32_t y)
+{
+  return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+}
+
+GroundGrid::GroundGrid(
+  const pcl::PointCloud<pcl::PointXYZ> & cloud, float resolution, float radius,
+  float outlier_threshold, float min_spread_ratio)
+: resolution_(resolution)
+{
+  // Bucket the points by cell to find neighbors without a kd-tree
+  std::unordered_map<uint64_t, std::vector<Eigen::Vector3f>> buckets;
+  for (const pcl::PointXYZ & p : cloud) {
+    buckets[to_key(to_index(p.x), to_index(p.y))].push_back(p.getVector3fMap());
+  }
+
+  // Planes are fitted for the cells within the radius from any point
+  const int32_t reach = static_cast<int32_t>(std::ceil(radius / resolution_));
+  std::unordered_set<uint64_t> candidates;
+  for (const pcl::PointXYZ & p : cloud) {
+    const int32_t cx = to_index(p.x), cy = to_index(p.y);
+    for (int32_t dx = -reach; dx <= reach; ++dx) {
+      for (int32_t dy = -reach; dy <= reach; ++dy) candidates.insert(to_key(cx + dx, cy + dy));
+    }
+  }
+
+  const float sq_radius = radius * radius;
+  std::vector<Eigen::Vector3f> neighbors;
+  for (const uint64_t key : candidates) {
+    const int32_t cx = static_cast<int32_t>(key >> 32);
+    const int32_t cy = static_cast<int32_t>(key & 0xffffffff);
+    const Eigen::Vector2f center((cx + 0.5f) * resolution_, (cy + 0.5f) * resolution_);
+
+    neighbors.clear();
+    for (int32_t dx = -reach; dx <= reach; ++dx) {
+      for (int32_t dy = -reach; dy <= reach; ++dy) {
+        auto itr = buckets.find(to_key(cx + dx, cy + dy));
+        if (itr == buckets.end()) continue;
+        for (const Eigen::Vector3f & p : itr->second) {
+          if ((p.topRows(2) - center).squaredNorm() < sq_radius) neighbors.push_back(p);
+        }
+      }
+    }
+    if (neighbors.size() < 3) continue;
+
+    Eigen::Vector3f centroid = Eigen::Vector3f::Zero();
+    for (const Eigen::Vector3f & p : neighbors) centroid += p;
+    centroid /= static_cast<float>(neighbors.size());
+
+    Eigen::Matrix3f covariance = Eigen::Matrix3f::Zero();
+    for (const Eigen::Vector3f & p : neighbors) {
+      const Eigen::Vector3f d = p - centroid;
+      covariance += d * d.transpose();
+    }
+
+    // The eigenvector of the smallest eigenvalue is the normal
+    Eigen::SelfAdjointEigenSolver<Eigen::Matrix3f> solver(covariance);
+    const Eigen::Vector3f & eigenvalues = solver.eigenvalues();
+    if (eigenvalues(1) < min_spread_ratio * eigenvalues(2)) continue;
+
+    Eigen::Vector3f normal = solver.eigenvectors().col(0);
+    if (normal.z() < 0) normal = -normal;
+    if (!normal.allFinite() || normal.z() < 1e-3f) continue;
+
+    bool is_single_plane = true;
+    for (const Eigen::Vector3f & p : neighbors) {
+      if (std::abs(normal.dot(p - centroid)) > outlier_threshold) {
+        is_single_plane = false;
+        break;
+      }
+    }
+    if (!is_single_plane) continue;
+
+    const Eigen::Vector2f offset = center - centroid.topRows(2);
+    const float height = centroid.z() - normal.topRows(2).dot(offset) / normal.z();
+    cells_.emplace(key, Cell{height, normal});
+  }
+}
+
+GroundGrid::GroundGrid(const CellRecord * records, size_t count, float resolution)
+: resolution_(resolution)
+{
+  cells_.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    const CellRecord & r = records[i];
+    cells_.emplace(
+      to_key(r.x, r.y), Cell{r.height, Eigen::Vector3f(r.normal[0], r.normal[1], r.normal[2])});
+  }
+}
+
+std::vector<GroundGrid::CellRecord> GroundGrid::records() const
+{
+  std::vector<CellRecord> records;
+  records.reserve(cells_.size());
+  for (const auto & [key, cell] : cells_) {
+    const int32_t x = static_cast<int32_t>(key >> 32);
+    const int32_t y = static_cast<int32_t>(key & 0xffffffff);
+    records.push_back({x, y, cell.height, {cell.normal.x(), cell.normal.y(), cell.normal.z()}});
+  }
+  return records;
+}
+
+std::optional<GroundGrid::Plane> GroundGrid::at(float x, float y) const
+{
+  // Bilinear weights over the centers of the four cells around the position
+  const float u = x / resolution_ - 0.5f;
+  const float v = y / resolution_ - 0.5f;
+  const int32_t ix = static_cast<int32_t>(std::floor(u));
+  const int32_t iy = static_cast<int32_t>(std::floor(v));
+  const float fx = u - ix;
+  const float fy = v - iy;
+
+  float sum_weight = 0;
+  float height = 0;
+  Eigen::Vector3f normal = Eigen::Vector3f::Zero();
+  for (int32_t dx = 0; dx < 2; ++dx) {
+    for (int32_t dy = 0; dy < 2; ++dy) {
+      auto itr = cells_.find(to_key(ix + dx, iy + dy));
+      if (itr == cells_.end()) continue;
+
+      const float weight = (dx ? fx : 1 - fx) * (dy ? fy : 1 - fy);
+      const Cell & cell = itr->second;
+      // Evaluate the plane of the cell at the position, rather than its height at the center
+      const Eigen::Vector2f offset(
+        x - (ix + dx + 0.5f) * resolution_, y - (iy + dy + 0.5f) * resolution_);
+      height += weight * (cell.height - cell.normal.topRows(2).dot(offset) / cell.normal.z());
+      normal += weight * cell.normal;
+      sum_weight += weight;
+    }
+  }
+
+  if (sum_weight < 1e-6f) return std::nullopt;
+  return Plane{height / sum_weight, normal.normalized()};
+}
+}  // namespace yabloc::ground_server
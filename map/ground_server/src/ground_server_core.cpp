@@ -13,11 +13,13 @@
 // limitations under the License.
 
 #include "ground_server/ground_server.hpp"
+#include "ground_server/ground_grid.hpp"
 #include "ground_server/polygon_operation.hpp"
 #include "ground_server/util.hpp"
 
 #include <Eigen/Eigenvalues>
 #include <ll2_decomposer/from_bin_msg.hpp>
+#include <ll2_decomposer/map_cache.hpp>
 #include <yabloc_common/color.hpp>
 #include <yabloc_common/pub_sub.hpp>
 
@@ -30,11 +32,28 @@
 
 namespace yabloc ::ground_server
 {
+namespace
+{
+// Bump it whenever the derivation of the cached cloud or grids changes
+constexpr int CACHE_VERSION = 1;
+constexpr float MIN_HEIGHT_RADIUS = 3.0f;
+constexpr float GROUND_GRID_OUTLIER_THRESHOLD = 1.0f;
+constexpr float GROUND_GRID_MIN_SPREAD_RATIO = 0.01f;
+}  // namespace
+
 GroundServer::GroundServer()
 : Node("ground_server"),
   force_zero_tilt_(declare_parameter("force_zero_tilt", false)),
   R(declare_parameter("R", 20)),
-  K(declare_parameter("K", 50))
+  K(declare_parameter("K", 50)),
+  cache_dir_(declare_parameter<std::string>("cache_dir", "")),
+  use_ground_grid_(declare_parameter<bool>("use_ground_grid", true)),
+  ground_grid_resolution_(declare_parameter<float>("ground_grid_resolution", 1.0f)),
+  ground_grid_radius_(declare_parameter<float>("ground_grid_radius", 4.0f)),
+  incremental_tracking_(declare_parameter<bool>("incremental_tracking", true)),
+  plane_tracker_(
+    declare_parameter<float>("neighborhood_reuse_distance", 0.5f), 1.0f,
+    declare_parameter<float>("min_inlier_ratio", 0.7f))
 {
   using std::placeholders::_1;
   using std::placeholders::_2;
@@ -103,60 +122,128 @@ void GroundServer::on_pose_stamped(const PoseStamped & msg)
 
 void GroundServer::on_map(const HADMapBin & msg)
 {
-  lanelet::LaneletMapPtr lanelet_map = ll2_decomposer::from_bin_msg(msg);
-
   // TODO: has to be loaded from rosparm
   const std::set<std::string> visible_labels = {
     "zebra_marking",      "virtual",   "line_thin", "line_thick",
     "pedestrian_marking", "stop_line", "curbstone"};
+  const float leaf_size = 1.0f;
+
+  // The cache depends on the map and also on the settings to make the ground cloud
+  uint64_t key = ll2_decomposer::hash_map_bin(msg);
+  key = ll2_decomposer::hash_combine(key, std::to_string(CACHE_VERSION));
+  for (const std::string & label : visible_labels) key = ll2_decomposer::hash_combine(key, label);
+  key = ll2_decomposer::hash_combine(key, std::to_string(leaf_size));
+  // The grids are also cached, so their settings are mixed too
+  key = ll2_decomposer::hash_combine(key, std::to_string(MIN_HEIGHT_RADIUS));
+  key = ll2_decomposer::hash_combine(key, std::to_string(ground_grid_resolution_));
+  key = ll2_decomposer::hash_combine(key, std::to_string(ground_grid_radius_));
+  key = ll2_decomposer::hash_combine(key, std::to_string(GROUND_GRID_OUTLIER_THRESHOLD));
+  key = ll2_decomposer::hash_combine(key, std::to_string(GROUND_GRID_MIN_SPREAD_RATIO));
+  const std::string cache_path = ll2_decomposer::map_cache_path(cache_dir_, "ground_server", key);
+
+  cloud_ = nullptr;
+  min_height_grid_ = nullptr;
+  ground_grid_ = nullptr;
+  if (!cache_dir_.empty()) load_cache(cache_path, key);
+  const bool cache_is_complete = cloud_ != nullptr && min_height_grid_ != nullptr &&
+                                 (ground_grid_ != nullptr || !use_ground_grid_);
+
+  if (cloud_ == nullptr) {
+    lanelet::LaneletMapPtr lanelet_map = ll2_decomposer::from_bin_msg(msg);
+
+    pcl::PointCloud<pcl::PointXYZ>::Ptr upsampled_cloud =
+      pcl::make_shared<pcl::PointCloud<pcl::PointXYZ>>();
+
+    for (lanelet::LineString3d & line : lanelet_map->lineStringLayer) {
+      if (!line.hasAttribute(lanelet::AttributeName::Type)) continue;
+
+      lanelet::Attribute attr = line.attribute(lanelet::AttributeName::Type);
+      if (visible_labels.count(attr.value()) == 0) continue;
+
+      lanelet::ConstPoint3d const * from = nullptr;
+      for (const lanelet::ConstPoint3d & p : line) {
+        if (from != nullptr) upsample_line_string(*from, p, upsampled_cloud);
+        from = &p;
+      }
+    }
 
-  pcl::PointCloud<pcl::PointXYZ>::Ptr upsampled_cloud =
-    pcl::make_shared<pcl::PointCloud<pcl::PointXYZ>>();
+    // NOTE: Under construction
+    // if (lanelet_map->polygonLayer.size() > 0)
+    //   *upsampled_cloud += sample_from_polygons(lanelet_map->polygonLayer);
 
-  for (lanelet::LineString3d & line : lanelet_map->lineStringLayer) {
-    if (!line.hasAttribute(lanelet::AttributeName::Type)) continue;
+    cloud_ = pcl::make_shared<pcl::PointCloud<pcl::PointXYZ>>();
+    pcl::VoxelGrid<pcl::PointXYZ> filter;
+    filter.setInputCloud(upsampled_cloud);
+    filter.setLeafSize(leaf_size, leaf_size, leaf_size);
+    filter.filter(*cloud_);
+  }
 
-    lanelet::Attribute attr = line.attribute(lanelet::AttributeName::Type);
-    if (visible_labels.count(attr.value()) == 0) continue;
+  kdtree_ = pcl::make_shared<pcl::KdTreeFLANN<pcl::PointXYZ>>();
+  kdtree_->setInputCloud(cloud_);
+  plane_tracker_.invalidate();
 
-    lanelet::ConstPoint3d const * from = nullptr;
-    for (const lanelet::ConstPoint3d & p : line) {
-      if (from != nullptr) upsample_line_string(*from, p, upsampled_cloud);
-      from = &p;
-    }
+  if (min_height_grid_ == nullptr)
+    min_height_grid_ = std::make_unique<MinHeightGrid>(*cloud_, MIN_HEIGHT_RADIUS);
+
+  if (use_ground_grid_) {
+    if (ground_grid_ == nullptr)
+      ground_grid_ = std::make_unique<GroundGrid>(
+        *cloud_, ground_grid_resolution_, ground_grid_radius_, GROUND_GRID_OUTLIER_THRESHOLD,
+        GROUND_GRID_MIN_SPREAD_RATIO);
+    RCLCPP_INFO_STREAM(get_logger(), "ground grid has " << ground_grid_->size() << " cells");
   }
 
-  // NOTE: Under construction
-  // if (lanelet_map->polygonLayer.size() > 0)
-  //   *upsampled_cloud += sample_from_polygons(lanelet_map->polygonLayer);
+  if (!cache_dir_.empty() && !cache_is_complete) save_cache(cache_path, key);
+}
 
-  cloud_ = pcl::make_shared<pcl::PointCloud<pcl::PointXYZ>>();
-  pcl::VoxelGrid<pcl::PointXYZ> filter;
-  filter.setInputCloud(upsampled_cloud);
-  filter.setLeafSize(1.0f, 1.0f, 1.0f);
-  filter.filter(*cloud_);
+void GroundServer::load_cache(const std::string & path, uint64_t key)
+{
+  ll2_decomposer::MapCacheReader reader;
+  if (!reader.open(path, key)) return;
+
+  auto cached = reader.cloud<pcl::PointXYZ>("ground");
+  if (!cached) return;
+  cloud_ = pcl::make_shared<pcl::PointCloud<pcl::PointXYZ>>(std::move(cached.value()));
+  RCLCPP_INFO_STREAM(get_logger(), "ground cloud is loaded from cache");
+
+  size_t cell_count = 0, point_count = 0;
+  const auto * cells =
+    reader.elements<MinHeightGrid::CellRecord>("min_height_grid_cells", cell_count);
+  const auto * points = reader.elements<Eigen::Vector3f>("min_height_grid_points", point_count);
+  if (cells != nullptr && points != nullptr) {
+    min_height_grid_ =
+      std::make_unique<MinHeightGrid>(cells, cell_count, points, MIN_HEIGHT_RADIUS);
+  }
 
-  kdtree_ = pcl::make_shared<pcl::KdTreeFLANN<pcl::PointXYZ>>();
-  kdtree_->setInputCloud(cloud_);
+  if (use_ground_grid_) {
+    size_t count = 0;
+    const auto * records = reader.elements<GroundGrid::CellRecord>("ground_grid", count);
+    if (records != nullptr)
+      ground_grid_ = std::make_unique<GroundGrid>(records, count, ground_grid_resolution_);
+  }
+}
+
+void GroundServer::save_cache(const std::string & path, uint64_t key) const
+{
+  ll2_decomposer::MapCacheWriter writer;
+  writer.add("ground", *cloud_);
+
+  std::vector<MinHeightGrid::CellRecord> cells;
+  std::vector<Eigen::Vector3f> points;
+  min_height_grid_->export_records(cells, points);
+  writer.add("min_height_grid_cells", cells);
+  writer.add("min_height_grid_points", points);
+
+  if (ground_grid_) writer.add("ground_grid", ground_grid_->records());
+
+  if (!writer.write(path, key))
+    RCLCPP_WARN_STREAM(get_logger(), "ground cache cannot be written to " << path);
 }
 
 float GroundServer::estimate_height_simply(const geometry_msgs::msg::Point & point) const
 {
   // NOTE: Sometimes it might give not-accurate height
-  constexpr float sq_radius = 3.0 * 3.0;
-  const float x = point.x;
-  const float y = point.y;
-
-  float height = std::numeric_limits<float>::infinity();
-  for (const auto & p : cloud_->points) {
-    const float dx = x - p.x;
-    const float dy = y - p.y;
-    const float sd = (dx * dx) + (dy * dy);
-    if (sd < sq_radius) {
-      height = std::min(height, static_cast<float>(p.z));
-    }
-  }
-  return std::isfinite(height) ? height : 0;
+  return min_height_grid_->lowest_height(point.x, point.y).value_or(0.f);
 }
 
 std::vector<int> GroundServer::estimate_inliers_by_ransac(const std::vector<int> & indices_raw)
@@ -180,47 +267,65 @@ std::vector<int> GroundServer::estimate_inliers_by_ransac(const std::vector<int>
   return inliers->indices;
 }
 
-GroundServer::GroundPlane GroundServer::estimate_ground(const Point & point)
+Eigen::Vector3f GroundServer::validate_normal(Eigen::Vector3f normal) const
 {
-  const float predicted_z = height_filter_.get_estimate();
-  const pcl::PointXYZ xyz(point.x, point.y, predicted_z);
-
-  std::vector<int> raw_indices;
-  std::vector<float> distances;
-  kdtree_->nearestKSearch(xyz, K, raw_indices, distances);
-
-  std::vector<int> indices = estimate_inliers_by_ransac(raw_indices);
+  // Reverse if it is upside down
+  if (normal.z() < 0) normal = -normal;
 
-  if (indices.empty()) indices = raw_indices;
-  last_indices_ = indices;
-
-  // Estimate normal vector using covariance matrix around the target point
-  Eigen::Matrix3f covariance;
-  Eigen::Vector4f centroid;
-  pcl::compute3DCentroid(*cloud_, indices, centroid);
-  pcl::computeCovarianceMatrix(*cloud_, indices, centroid, covariance);
-
-  // NOTE: I forgot why I don't use coefficients computeed by SACSegmentation
-  Eigen::Vector4f plane_parameter;
-  float curvature;
-  pcl::solvePlaneParameters(covariance, centroid, plane_parameter, curvature);
-  Eigen::Vector3f normal = plane_parameter.topRows(3).normalized();
-
-  {
-    // Reverse if it is upside down
-    if (normal.z() < 0) normal = -normal;
+  // Remove NaN
+  if (!normal.allFinite()) {
+    normal = Eigen::Vector3f::UnitZ();
+    RCLCPP_WARN_STREAM(get_logger(), "Reject NaN tilt");
+  }
+  // Remove too large tilt (0.707 = cos(45deg))
+  if ((normal.dot(Eigen::Vector3f::UnitZ())) < 0.707) {
+    normal = Eigen::Vector3f::UnitZ();
+    RCLCPP_WARN_STREAM(get_logger(), "Reject too large tilt of ground");
+  }
+  return normal;
+}
 
-    // Remove NaN
-    if (!normal.allFinite()) {
-      normal = Eigen::Vector3f::UnitZ();
-      RCLCPP_WARN_STREAM(get_logger(), "Reject NaN tilt");
+GroundServer::GroundPlane GroundServer::estimate_ground(const Point & point)
+{
+  // The precomputed grid answers in constant time. The cloud is searched only where the grid has
+  // no plane, e.g. where there are multiple levels of roads.
+  if (ground_grid_) {
+    if (const auto grid_plane = ground_grid_->at(point.x, point.y)) {
+      last_indices_.clear();
+
+      GroundPlane plane;
+      plane.xyz = Eigen::Vector3f(point.x, point.y, grid_plane->height);
+      plane.normal = normal_filter_.update(validate_normal(grid_plane->normal));
+      height_filter_.update(plane.xyz.z());
+
+      if (force_zero_tilt_) plane.normal = Eigen::Vector3f::UnitZ();
+      return plane;
     }
-    // Remove too large tilt (0.707 = cos(45deg))
-    if ((normal.dot(Eigen::Vector3f::UnitZ())) < 0.707) {
-      normal = Eigen::Vector3f::UnitZ();
-      RCLCPP_WARN_STREAM(get_logger(), "Reject too large tilt of ground");
+  }
+
+  const float predicted_z = height_filter_.get_estimate();
+  const Eigen::Vector2f position(point.x, point.y);
+
+  // The neighborhood is searched again only after the pose moves away, and RANSAC runs only when
+  // the tracked plane does not fit the new neighborhood
+  if (!incremental_tracking_ || !plane_tracker_.can_reuse(position)) {
+    const pcl::PointXYZ xyz(point.x, point.y, predicted_z);
+    std::vector<int> raw_indices;
+    std::vector<float> distances;
+    kdtree_->nearestKSearch(xyz, K, raw_indices, distances);
+
+    if (!incremental_tracking_ || !plane_tracker_.update(*cloud_, raw_indices, position)) {
+      std::vector<int> indices = estimate_inliers_by_ransac(raw_indices);
+      if (indices.empty()) indices = raw_indices;
+      plane_tracker_.reset(*cloud_, indices, position);
     }
   }
+  last_indices_ = plane_tracker_.indices();
+
+  // NOTE: I forgot why I don't use coefficients computeed by SACSegmentation
+  // The plane is fitted to the inliers by their covariance, which the tracker keeps as moments
+  const Eigen::Vector3f centroid = plane_tracker_.centroid();
+  const Eigen::Vector3f normal = validate_normal(plane_tracker_.normal());
 
   const Eigen::Vector3f filt_normal = normal_filter_.update(normal);
 
@@ -230,8 +335,7 @@ GroundServer::GroundPlane GroundServer::estimate_ground(const Point & point)
 
   // Compute z value by intersection of estimated plane and orthogonal line
   {
-    Eigen::Vector3f center = centroid.topRows(3);
-    float inner = center.dot(plane.normal);
+    float inner = centroid.dot(plane.normal);
     float px_nx = point.x * plane.normal.x();
     float py_ny = point.y * plane.normal.y();
     plane.xyz.z() = (inner - px_nx - py_ny) / plane.normal.z();
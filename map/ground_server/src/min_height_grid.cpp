@@ -0,0 +1,97 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ground_server/min_height_grid.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace yabloc::ground_server
+{
+int32_t MinHeightGrid::to_index(float v) const
+{
+  return static_cast<int32_t>(std::floor(v / radius_));
+}
+
+uint64_t MinHeightGrid::to_key(int32_t x, int32_t y)
+{
+  return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+}
+
+MinHeightGrid::MinHeightGrid(const pcl::PointCloud<pcl::PointXYZ> & cloud, float radius)
+: radius_(radius)
+{
+  for (const pcl::PointXYZ & p : cloud) {
+    cells_[to_key(to_index(p.x), to_index(p.y))].push_back(p.getVector3fMap());
+  }
+  for (auto & [key, points] : cells_) {
+    std::sort(points.begin(), points.end(), [](const auto & a, const auto & b) {
+      return a.z() < b.z();
+    });
+  }
+}
+
+MinHeightGrid::MinHeightGrid(
+  const CellRecord * cells, size_t cell_count, const Eigen::Vector3f * points, float radius)
+: radius_(radius)
+{
+  cells_.reserve(cell_count);
+  for (size_t i = 0; i < cell_count; ++i) {
+    const CellRecord & cell = cells[i];
+    cells_[to_key(cell.x, cell.y)].assign(points + cell.begin, points + cell.end);
+  }
+}
+
+void MinHeightGrid::export_records(
+  std::vector<CellRecord> & cells, std::vector<Eigen::Vector3f> & points) const
+{
+  cells.clear();
+  points.clear();
+  cells.reserve(cells_.size());
+  for (const auto & [key, cell_points] : cells_) {
+    const int32_t x = static_cast<int32_t>(key >> 32);
+    const int32_t y = static_cast<int32_t>(key & 0xffffffff);
+    const uint32_t begin = points.size();
+    points.insert(points.end(), cell_points.begin(), cell_points.end());
+    cells.push_back({x, y, begin, static_cast<uint32_t>(points.size())});
+  }
+}
+
+std::optional<float> MinHeightGrid::lowest_height(float x, float y) const
+{
+  const float sq_radius = radius_ * radius_;
+  const Eigen::Vector2f query(x, y);
+
+  float height = std::numeric_limits<float>::infinity();
+  for (int32_t ix = to_index(x - radius_); ix <= to_index(x + radius_); ++ix) {
+    for (int32_t iy = to_index(y - radius_); iy <= to_index(y + radius_); ++iy) {
+      auto itr = cells_.find(to_key(ix, iy));
+      if (itr == cells_.end()) continue;
+
+      // Points are sorted by height, so the first one within the radius is the lowest in the cell
+      for (const Eigen::Vector3f & p : itr->second) {
+        if (p.z() >= height) break;
+        if ((p.topRows(2) - query).squaredNorm() < sq_radius) {
+          height = p.z();
+          break;
+        }
+      }
+    }
+  }
+
+  if (!std::isfinite(height)) return std::nullopt;
+  return height;
+}
+}  // namespace yabloc::ground_server
@@ -0,0 +1,117 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ground_server/plane_tracker.hpp"
+
+#include <Eigen/Eigenvalues>
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace yabloc::ground_server
+{
+PlaneTracker::PlaneTracker(float reuse_distance, float inlier_threshold, float min_inlier_ratio)
+: reuse_distance_(reuse_distance),
+  inlier_threshold_(inlier_threshold),
+  min_inlier_ratio_(min_inlier_ratio)
+{
+}
+
+bool PlaneTracker::can_reuse(const Eigen::Vector2f & position) const
+{
+  if (!valid_) return false;
+  return (position - position_).norm() < reuse_distance_;
+}
+
+void PlaneTracker::accumulate(const pcl::PointXYZ & p, double sign)
+{
+  const Eigen::Vector3d v = p.getVector3fMap().cast<double>() - origin_;
+  sum_ += sign * v;
+  sum_outer_ += sign * v * v.transpose();
+}
+
+void PlaneTracker::solve()
+{
+  const double n = static_cast<double>(indices_.size());
+  const Eigen::Vector3d centroid = sum_ / n;
+  const Eigen::Matrix3d covariance = sum_outer_ / n - centroid * centroid.transpose();
+
+  // The eigenvector of the smallest eigenvalue is the normal
+  Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(covariance);
+  Eigen::Vector3d normal = solver.eigenvectors().col(0);
+  if (normal.z() < 0) normal = -normal;
+
+  centroid_ = (origin_ + centroid).cast<float>();
+  normal_ = normal.cast<float>();
+}
+
+void PlaneTracker::reset(
+  const pcl::PointCloud<pcl::PointXYZ> & cloud, std::vector<int> inliers,
+  const Eigen::Vector2f & position)
+{
+  std::sort(inliers.begin(), inliers.end());
+  indices_ = std::move(inliers);
+  position_ = position;
+
+  valid_ = !indices_.empty();
+  if (valid_) {
+    rebuild(cloud);
+    solve();
+  }
+}
+
+void PlaneTracker::rebuild(const pcl::PointCloud<pcl::PointXYZ> & cloud)
+{
+  origin_ = cloud.at(indices_.front()).getVector3fMap().cast<double>();
+  sum_.setZero();
+  sum_outer_.setZero();
+  for (int i : indices_) accumulate(cloud.at(i), 1.0);
+  updates_since_rebuild_ = 0;
+}
+
+bool PlaneTracker::update(
+  const pcl::PointCloud<pcl::PointXYZ> & cloud, const std::vector<int> & neighbors,
+  const Eigen::Vector2f & position)
+{
+  if (!valid_ || neighbors.empty()) return false;
+
+  std::vector<int> inliers;
+  inliers.reserve(neighbors.size());
+  for (int i : neighbors) {
+    const Eigen::Vector3f p = cloud.at(i).getVector3fMap();
+    if (std::abs(normal_.dot(p - centroid_)) < inlier_threshold_) inliers.push_back(i);
+  }
+  if (inliers.size() < 3) return false;
+  if (inliers.size() < min_inlier_ratio_ * neighbors.size()) return false;
+
+  // Only the difference between the old and new inliers is applied to the moments
+  std::sort(inliers.begin(), inliers.end());
+  std::vector<int> removed, added;
+  std::set_difference(
+    indices_.begin(), indices_.end(), inliers.begin(), inliers.end(), std::back_inserter(removed));
+  std::set_difference(
+    inliers.begin(), inliers.end(), indices_.begin(), indices_.end(), std::back_inserter(added));
+  indices_ = std::move(inliers);
+  position_ = position;
+  if (++updates_since_rebuild_ >= REBUILD_INTERVAL) {
+    rebuild(cloud);
+  } else {
+    for (int i : removed) accumulate(cloud.at(i), -1.0);
+    for (int i : added) accumulate(cloud.at(i), 1.0);
+  }
+  solve();
+  return true;
+}
+}  // namespace yabloc::ground_server
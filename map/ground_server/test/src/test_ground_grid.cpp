@@ -0,0 +1,116 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ground_server/ground_grid.hpp"
+
+#include <gtest/gtest.h>
+
+#include <functional>
+
+namespace gs = yabloc::ground_server;
+using Cloud = pcl::PointCloud<pcl::PointXYZ>;
+
+constexpr float RESOLUTION = 1.0f;
+constexpr float RADIUS = 4.0f;
+
+// Sample a surface z = f(x, y) at 0.5 m intervals over [-20, 20)^2
+Cloud sample_surface(std::function<float(float, float)> f)
+{
+  Cloud cloud;
+  for (float x = -20; x < 20; x += 0.5f) {
+    for (float y = -20; y < 20; y += 0.5f) cloud.push_back(pcl::PointXYZ(x, y, f(x, y)));
+  }
+  return cloud;
+}
+
+TEST(GroundGridTestSuite, flatPlane)
+{
+  const Cloud cloud = sample_surface([](float, float) { return 2.0f; });
+  gs::GroundGrid grid(cloud, RESOLUTION, RADIUS);
+
+  for (const auto & [x, y] : {std::pair{0.f, 0.f}, {3.3f, -1.7f}, {-10.25f, 12.6f}}) {
+    const auto plane = grid.at(x, y);
+    ASSERT_TRUE(plane.has_value());
+    EXPECT_NEAR(plane->height, 2.0f, 1e-4f);
+    EXPECT_NEAR(plane->normal.z(), 1.0f, 1e-4f);
+  }
+}
+
+TEST(GroundGridTestSuite, tiltedPlane)
+{
+  const Cloud cloud = sample_surface([](float x, float y) { return 0.1f * x - 0.05f * y + 1; });
+  gs::GroundGrid grid(cloud, RESOLUTION, RADIUS);
+
+  const Eigen::Vector3f expected_normal = Eigen::Vector3f(-0.1f, 0.05f, 1).normalized();
+  for (const auto & [x, y] : {std::pair{0.f, 0.f}, {3.3f, -1.7f}, {-10.25f, 12.6f}}) {
+    const auto plane = grid.at(x, y);
+    ASSERT_TRUE(plane.has_value());
+    // The height is evaluated on the plane at the position, not at the cell center
+    EXPECT_NEAR(plane->height, 0.1f * x - 0.05f * y + 1, 1e-3f);
+    EXPECT_GT(plane->normal.dot(expected_normal), 0.9999f);
+  }
+}
+
+TEST(GroundGridTestSuite, emptyCell)
+{
+  const Cloud cloud = sample_surface([](float, float) { return 0.0f; });
+  gs::GroundGrid grid(cloud, RESOLUTION, RADIUS);
+
+  // No point is within the radius
+  EXPECT_FALSE(grid.at(100, 100).has_value());
+  EXPECT_FALSE(gs::GroundGrid(Cloud(), RESOLUTION, RADIUS).at(0, 0).has_value());
+}
+
+TEST(GroundGridTestSuite, outlierCell)
+{
+  Cloud cloud = sample_surface([](float, float) { return 0.0f; });
+  // e.g. a bridge over the road
+  cloud.push_back(pcl::PointXYZ(5.0f, 5.0f, 3.0f));
+  gs::GroundGrid grid(cloud, RESOLUTION, RADIUS);
+
+  // The cells which see the outlier are left empty
+  EXPECT_FALSE(grid.at(5.0f, 5.0f).has_value());
+
+  // The cells far from it are not affected
+  const auto plane = grid.at(-10.0f, -10.0f);
+  ASSERT_TRUE(plane.has_value());
+  EXPECT_NEAR(plane->height, 0.0f, 1e-4f);
+}
+
+TEST(GroundGridTestSuite, collinearCell)
+{
+  // A single line marking does not determine the tilt across it
+  Cloud cloud;
+  for (float x = -20; x < 20; x += 0.5f) cloud.push_back(pcl::PointXYZ(x, 0.0f, 0.1f * x));
+  gs::GroundGrid grid(cloud, RESOLUTION, RADIUS);
+
+  EXPECT_EQ(grid.size(), 0u);
+  EXPECT_FALSE(grid.at(0.0f, 0.0f).has_value());
+}
+
+TEST(GroundGridTestSuite, restoreFromRecords)
+{
+  const Cloud cloud = sample_surface([](float x, float y) { return 0.1f * x + 0.2f * y; });
+  gs::GroundGrid grid(cloud, RESOLUTION, RADIUS);
+
+  const auto records = grid.records();
+  gs::GroundGrid restored(records.data(), records.size(), RESOLUTION);
+  ASSERT_EQ(restored.size(), grid.size());
+
+  const auto expected = grid.at(-3.7f, 8.1f);
+  const auto actual = restored.at(-3.7f, 8.1f);
+  ASSERT_TRUE(expected.has_value() && actual.has_value());
+  EXPECT_FLOAT_EQ(actual->height, expected->height);
+  EXPECT_TRUE(actual->normal.isApprox(expected->normal));
+}
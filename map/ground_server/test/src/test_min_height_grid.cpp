@@ -0,0 +1,131 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ground_server/min_height_grid.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <optional>
+#include <random>
+#include <vector>
+
+namespace gs = yabloc::ground_server;
+using Cloud = pcl::PointCloud<pcl::PointXYZ>;
+
+constexpr float RADIUS = 3.0f;
+
+// The linear scan which MinHeightGrid replaces
+std::optional<float> lowest_height_by_scan(const Cloud & cloud, float x, float y)
+{
+  constexpr float sq_radius = RADIUS * RADIUS;
+  float height = std::numeric_limits<float>::infinity();
+  for (const auto & p : cloud.points) {
+    const float dx = x - p.x;
+    const float dy = y - p.y;
+    if ((dx * dx) + (dy * dy) < sq_radius) height = std::min(height, p.z);
+  }
+  if (!std::isfinite(height)) return std::nullopt;
+  return height;
+}
+
+Cloud make_random_cloud(std::mt19937 & engine)
+{
+  std::uniform_real_distribution<float> xy(-30, 30);
+  std::uniform_real_distribution<float> z(-5, 5);
+  Cloud cloud;
+  for (int i = 0; i < 2000; ++i) cloud.push_back(pcl::PointXYZ(xy(engine), xy(engine), z(engine)));
+  return cloud;
+}
+
+TEST(MinHeightGridTestSuite, randomQueries)
+{
+  std::mt19937 engine(0);
+  const Cloud cloud = make_random_cloud(engine);
+  gs::MinHeightGrid grid(cloud, RADIUS);
+
+  std::uniform_real_distribution<float> xy(-40, 40);
+  for (int i = 0; i < 1000; ++i) {
+    const float x = xy(engine);
+    const float y = xy(engine);
+    EXPECT_EQ(grid.lowest_height(x, y), lowest_height_by_scan(cloud, x, y)) << x << " " << y;
+  }
+}
+
+TEST(MinHeightGridTestSuite, cellBorders)
+{
+  std::mt19937 engine(1);
+  const Cloud cloud = make_random_cloud(engine);
+  gs::MinHeightGrid grid(cloud, RADIUS);
+
+  // Queries on the borders and the corners of the cells, and just beside them
+  for (int ix = -10; ix <= 10; ++ix) {
+    for (int iy = -10; iy <= 10; ++iy) {
+      for (const float eps : {-1e-3f, 0.f, 1e-3f}) {
+        const float x = ix * RADIUS + eps;
+        const float y = iy * RADIUS - eps;
+        EXPECT_EQ(grid.lowest_height(x, y), lowest_height_by_scan(cloud, x, y)) << x << " " << y;
+      }
+    }
+  }
+}
+
+TEST(MinHeightGridTestSuite, exactlyOnRadius)
+{
+  // A point exactly at the radius is out of range as the linear scan
+  Cloud cloud;
+  cloud.push_back(pcl::PointXYZ(RADIUS, 0, -1));
+  cloud.push_back(pcl::PointXYZ(0, 1, 2));
+  gs::MinHeightGrid grid(cloud, RADIUS);
+
+  EXPECT_EQ(grid.lowest_height(0, 0), std::optional<float>(2));
+  EXPECT_EQ(grid.lowest_height(0, 0), lowest_height_by_scan(cloud, 0, 0));
+
+  // Slightly inside the radius, the lower point is found
+  EXPECT_EQ(grid.lowest_height(0.01f, 0), std::optional<float>(-1));
+}
+
+TEST(MinHeightGridTestSuite, noPointInRange)
+{
+  Cloud cloud;
+  cloud.push_back(pcl::PointXYZ(10, 10, 0));
+  gs::MinHeightGrid grid(cloud, RADIUS);
+
+  EXPECT_FALSE(grid.lowest_height(0, 0).has_value());
+  // The point is in a neighboring cell but out of the radius
+  EXPECT_FALSE(grid.lowest_height(10 - RADIUS, 10 - RADIUS).has_value());
+  EXPECT_FALSE(gs::MinHeightGrid(Cloud(), RADIUS).lowest_height(0, 0).has_value());
+}
+
+TEST(MinHeightGridTestSuite, restoreFromRecords)
+{
+  std::mt19937 engine(2);
+  const Cloud cloud = make_random_cloud(engine);
+  gs::MinHeightGrid grid(cloud, RADIUS);
+
+  std::vector<gs::MinHeightGrid::CellRecord> cells;
+  std::vector<Eigen::Vector3f> points;
+  grid.export_records(cells, points);
+  ASSERT_EQ(points.size(), cloud.size());
+  gs::MinHeightGrid restored(cells.data(), cells.size(), points.data(), RADIUS);
+
+  std::uniform_real_distribution<float> xy(-40, 40);
+  for (int i = 0; i < 200; ++i) {
+    const float x = xy(engine);
+    const float y = xy(engine);
+    EXPECT_EQ(restored.lowest_height(x, y), grid.lowest_height(x, y));
+  }
+}
@@ -13,9 +13,12 @@
 // limitations under the License.
 
 #pragma once
+#include "ll2_decomposer/map_tiler.hpp"
+
 #include <rclcpp/rclcpp.hpp>
 
 #include <autoware_auto_mapping_msgs/msg/had_map_bin.hpp>
+#include <map_tile_msgs/srv/get_map_tiles.hpp>
 #include <sensor_msgs/msg/image.hpp>
 #include <sensor_msgs/msg/point_cloud2.hpp>
 #include <visualization_msgs/msg/marker_array.hpp>
@@ -24,6 +27,11 @@
 #include <pcl/point_cloud.h>
 #include <pcl/point_types.h>
 
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+
 namespace yabloc::ll2_decomposer
 {
 class Ll2Decomposer : public rclcpp::Node
@@ -33,6 +41,7 @@ public:
   using HADMapBin = autoware_auto_mapping_msgs::msg::HADMapBin;
   using Marker = visualization_msgs::msg::Marker;
   using MarkerArray = visualization_msgs::msg::MarkerArray;
+  using GetMapTiles = map_tile_msgs::srv::GetMapTiles;
 
   Ll2Decomposer();
 
@@ -44,32 +53,45 @@ private:
   rclcpp::Publisher<MarkerArray>::SharedPtr pub_marker_;
 
   rclcpp::Subscription<HADMapBin>::SharedPtr sub_map_;
+  rclcpp::Service<GetMapTiles>::SharedPtr service_tiles_;
   std::set<std::string> road_marking_labels_;
   std::set<std::string> sign_board_labels_;
   std::set<std::string> bounding_box_labels_;
 
+  // Cache files are stored in this directory. An empty string disables the cache.
+  const std::string cache_dir_;
+  // Road markings are served by tiles of this size. A non-positive value disables the service.
+  const float tile_size_;
+  std::unique_ptr<MapTiler> tiler_{nullptr};
+
+  struct Decomposition
+  {
+    pcl::PointCloud<pcl::PointNormal> road_marking;
+    pcl::PointCloud<pcl::PointNormal> sign_board;
+    pcl::PointCloud<pcl::PointXYZL> transition_area;
+    pcl::PointCloud<pcl::PointXYZL> bounding_box;
+    MarkerArray marker;
+  };
+
   void on_map(const HADMapBin & msg);
+  void on_road_marking_tiles(
+    GetMapTiles::Request::ConstSharedPtr request, GetMapTiles::Response::SharedPtr response);
+
+  Decomposition decompose(const lanelet::LaneletMapPtr & lanelet_map);
+
+  uint64_t cache_key(const HADMapBin & msg) const;
+  std::optional<Decomposition> load_cache(uint64_t key) const;
+  void save_cache(uint64_t key, const Decomposition & decomposition) const;
 
   pcl::PointNormal to_point_normal(
     const lanelet::ConstPoint3d & from, const lanelet::ConstPoint3d & to) const;
 
   pcl::PointCloud<pcl::PointNormal> split_line_strings(
-    const lanelet::ConstLineStrings3d & line_strings);
-
-  pcl::PointCloud<pcl::PointXYZL> load_bounding_boxes(const lanelet::PolygonLayer & polygons) const;
-
-  lanelet::ConstLineStrings3d extract_specified_line_string(
-    const lanelet::LineStringLayer & line_strings, const std::set<std::string> & visible_labels);
-  lanelet::ConstPolygons3d extract_specified_polygon(
-    const lanelet::PolygonLayer & polygon_layer, const std::set<std::string> & visible_labels);
+    const lanelet::ConstLineStrings3d & line_strings) const;
 
   MarkerArray make_sign_marker_msg(
-    const lanelet::LineStringLayer & line_string_layer, const std::set<std::string> & labels,
-    const std::string & ns);
+    const lanelet::ConstLineStrings3d & line_strings, const std::string & ns) const;
   MarkerArray make_polygon_marker_msg(
-    const lanelet::PolygonLayer & polygon_layer, const std::set<std::string> & labels,
-    const std::string & ns);
-
-  void publish_additional_marker(const lanelet::LaneletMapPtr & lanelet_map);
+    const lanelet::ConstPolygons3d & polygons, const std::string & ns) const;
 };
 }  // namespace yabloc::ll2_decomposer
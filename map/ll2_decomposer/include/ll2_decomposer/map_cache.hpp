@@ -0,0 +1,110 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <autoware_auto_mapping_msgs/msg/had_map_bin.hpp>
+
+#include <pcl/point_cloud.h>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace yabloc::ll2_decomposer
+{
+// Hash of the map content, which is independent of the stamp of the message
+uint64_t hash_map_bin(const autoware_auto_mapping_msgs::msg::HADMapBin & msg);
+// Mix a setting which the cached data depends on, e.g. labels, into a hash
+uint64_t hash_combine(uint64_t hash, const std::string & value);
+
+// <cache_dir>/<name>_<key in hex>.bin
+std::string map_cache_path(const std::string & cache_dir, const std::string & name, uint64_t key);
+
+// A map cache file holds named sections of fixed-size elements, e.g. points of a cloud, which are
+// derived from a lanelet2 map. The sections are aligned so that MapCacheReader reads them in place
+// from the mmapped file, and nodes skip deserializing the map on later launches.
+// The elements are stored as they are in memory, so a cache is valid only on the same platform.
+class MapCacheWriter
+{
+public:
+  void add(const std::string & name, const void * data, size_t element_size, size_t count);
+
+  template <typename PointT>
+  void add(const std::string & name, const pcl::PointCloud<PointT> & cloud)
+  {
+    add(name, cloud.points.data(), sizeof(PointT), cloud.size());
+  }
+
+  template <typename T>
+  void add(const std::string & name, const std::vector<T> & elements)
+  {
+    add(name, elements.data(), sizeof(T), elements.size());
+  }
+
+  // The file is written under a temporary name and renamed, so that a reader never sees a
+  // partial file. Return false on failure.
+  bool write(const std::string & path, uint64_t key) const;
+
+private:
+  struct Section
+  {
+    std::string name;
+    size_t element_size;
+    size_t count;
+    std::vector<uint8_t> bytes;
+  };
+  std::vector<Section> sections_;
+};
+
+class MapCacheReader
+{
+public:
+  MapCacheReader() = default;
+  ~MapCacheReader();
+  MapCacheReader(const MapCacheReader &) = delete;
+  MapCacheReader & operator=(const MapCacheReader &) = delete;
+
+  // Return false if the file does not exist or it is not a cache of the key
+  bool open(const std::string & path, uint64_t key);
+
+  // Return nullptr if the section does not exist or its element size differs
+  const void * find(const std::string & name, size_t element_size, size_t & count) const;
+
+  // The elements are valid while the reader is open
+  template <typename T>
+  const T * elements(const std::string & name, size_t & count) const
+  {
+    return static_cast<const T *>(find(name, sizeof(T), count));
+  }
+
+  template <typename PointT>
+  std::optional<pcl::PointCloud<PointT>> cloud(const std::string & name) const
+  {
+    size_t count = 0;
+    const auto * points = static_cast<const PointT *>(find(name, sizeof(PointT), count));
+    if (points == nullptr) return std::nullopt;
+
+    pcl::PointCloud<PointT> cloud;
+    cloud.points.assign(points, points + count);
+    cloud.width = count;
+    cloud.height = 1;
+    return cloud;
+  }
+
+private:
+  const uint8_t * data_{nullptr};
+  size_t size_{0};
+};
+}  // namespace yabloc::ll2_decomposer
@@ -0,0 +1,72 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace yabloc::ll2_decomposer
+{
+struct TileIndex
+{
+  int32_t x;
+  int32_t y;
+
+  friend bool operator==(const TileIndex & a, const TileIndex & b)
+  {
+    return a.x == b.x && a.y == b.y;
+  }
+
+  struct Hash
+  {
+    size_t operator()(const TileIndex & index) const
+    {
+      return std::hash<uint64_t>()(
+        (static_cast<uint64_t>(static_cast<uint32_t>(index.x)) << 32) |
+        static_cast<uint32_t>(index.y));
+    }
+  };
+};
+
+// Partition line segments into square tiles of the fixed size, so that a consumer holds only the
+// segments around its current position.
+// A segment is stored in every tile which its bounding box intersects.
+class MapTiler
+{
+public:
+  using Segments = pcl::PointCloud<pcl::PointNormal>;
+
+  explicit MapTiler(float tile_size);
+
+  void set_cloud(const Segments & cloud);
+
+  float tile_size() const { return tile_size_; }
+
+  // Indices of non-empty tiles which intersect [center - radius, center + radius]
+  std::vector<TileIndex> tiles_around(float x, float y, float radius) const;
+
+  // Return nullptr for an empty tile
+  const Segments * tile(const TileIndex & index) const;
+
+private:
+  const float tile_size_;
+  std::unordered_map<TileIndex, Segments, TileIndex::Hash> tiles_;
+
+  int32_t to_index(float v) const;
+};
+}  // namespace yabloc::ll2_decomposer
@@ -0,0 +1,48 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <cstdint>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace yabloc::ll2_decomposer
+{
+// Classify lanelet2 elements by the value of their type attribute.
+// Each distinct type is interned into a small integer ID at its first appearance, and its class
+// bits are computed only then. Later elements of the same type cost a single hash lookup instead
+// of comparing the string against every label set.
+class TypeClassifier
+{
+public:
+  using ClassMask = uint32_t;
+
+  // Elements whose type is in the labels get the class bit
+  void add_class(ClassMask bit, const std::set<std::string> & labels);
+
+  // Return the class bits of the type, which is 0 for an unrelated type
+  ClassMask classify(const std::string & type);
+
+  // All types which have been classified, in order of their IDs
+  const std::vector<std::string> & types() const { return types_; }
+
+private:
+  std::vector<std::pair<ClassMask, std::set<std::string>>> classes_;
+  std::unordered_map<std::string, uint16_t> ids_;
+  std::vector<std::string> types_;
+  std::vector<ClassMask> masks_;
+};
+}  // namespace yabloc::ll2_decomposer
@@ -0,0 +1,191 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ll2_decomposer/map_cache.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace yabloc::ll2_decomposer
+{
+namespace
+{
+constexpr char MAGIC[8] = {'Y', 'L', 'M', 'A', 'P', 'C', 'C', 'H'};
+constexpr uint32_t VERSION = 1;
+// Every section starts at a multiple of this, which satisfies the alignment of any point type
+constexpr size_t ALIGNMENT = 64;
+
+struct FileHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t section_count;
+  uint64_t key;
+};
+
+struct SectionHeader
+{
+  char name[48];
+  uint64_t element_size;
+  uint64_t count;
+  uint64_t offset;
+};
+
+size_t align(size_t offset) { return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT; }
+
+uint64_t fnv1a(const uint8_t * data, size_t size, uint64_t hash)
+{
+  constexpr uint64_t prime = 0x100000001b3ULL;
+  for (size_t i = 0; i < size; ++i) hash = (hash ^ data[i]) * prime;
+  return hash;
+}
+}  // namespace
+
+uint64_t hash_map_bin(const autoware_auto_mapping_msgs::msg::HADMapBin & msg)
+{
+  constexpr uint64_t offset_basis = 0xcbf29ce484222325ULL;
+  return fnv1a(msg.data.data(), msg.data.size(), offset_basis);
+}
+
+uint64_t hash_combine(uint64_t hash, const std::string & value)
+{
+  // The length separates ("ab", "c") from ("a", "bc")
+  const uint64_t length = value.size();
+  hash = fnv1a(reinterpret_cast<const uint8_t *>(&length), sizeof(length), hash);
+  return fnv1a(reinterpret_cast<const uint8_t *>(value.data()), value.size(), hash);
+}
+
+std::string map_cache_path(const std::string & cache_dir, const std::string & name, uint64_t key)
+{
+  std::stringstream ss;
+  ss << name << "_" << std::hex << std::setw(16) << std::setfill('0') << key << ".bin";
+  return (std::filesystem::path(cache_dir) / ss.str()).string();
+}
+
+void MapCacheWriter::add(
+  const std::string & name, const void * data, size_t element_size, size_t count)
+{
+  const auto * begin = static_cast<const uint8_t *>(data);
+  sections_.push_back({name, element_size, count, {begin, begin + element_size * count}});
+}
+
+bool MapCacheWriter::write(const std::string & path, uint64_t key) const
+{
+  FileHeader file_header;
+  std::memcpy(file_header.magic, MAGIC, sizeof(MAGIC));
+  file_header.version = VERSION;
+  file_header.section_count = sections_.size();
+  file_header.key = key;
+
+  std::vector<SectionHeader> section_headers(sections_.size());
+  size_t offset = align(sizeof(FileHeader) + sizeof(SectionHeader) * sections_.size());
+  for (size_t i = 0; i < sections_.size(); ++i) {
+    SectionHeader & header = section_headers[i];
+    if (sections_[i].name.size() >= sizeof(header.name)) return false;
+    std::memset(header.name, 0, sizeof(header.name));
+    std::memcpy(header.name, sections_[i].name.data(), sections_[i].name.size());
+    header.element_size = sections_[i].element_size;
+    header.count = sections_[i].count;
+    header.offset = offset;
+    offset = align(offset + sections_[i].bytes.size());
+  }
+
+  std::error_code error;
+  const std::filesystem::path target(path);
+  std::filesystem::create_directories(target.parent_path(), error);
+  const std::filesystem::path temporary = target.string() + ".tmp" + std::to_string(getpid());
+
+  {
+    std::ofstream ofs(temporary, std::ios::binary);
+    if (!ofs) return false;
+    ofs.write(reinterpret_cast<const char *>(&file_header), sizeof(file_header));
+    ofs.write(
+      reinterpret_cast<const char *>(section_headers.data()),
+      sizeof(SectionHeader) * section_headers.size());
+    for (size_t i = 0; i < sections_.size(); ++i) {
+      ofs.seekp(section_headers[i].offset);
+      const std::vector<uint8_t> & bytes = sections_[i].bytes;
+      ofs.write(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+    }
+    if (!ofs) return false;
+  }
+
+  std::filesystem::rename(temporary, target, error);
+  if (error) std::filesystem::remove(temporary, error);
+  return !error;
+}
+
+MapCacheReader::~MapCacheReader()
+{
+  if (data_ != nullptr) munmap(const_cast<uint8_t *>(data_), size_);
+}
+
+bool MapCacheReader::open(const std::string & path, uint64_t key)
+{
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(FileHeader)) {
+    close(fd);
+    return false;
+  }
+  void * mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED) return false;
+
+  if (data_ != nullptr) munmap(const_cast<uint8_t *>(data_), size_);
+  data_ = static_cast<const uint8_t *>(mapped);
+  size_ = st.st_size;
+
+  const auto * header = reinterpret_cast<const FileHeader *>(data_);
+  const bool valid = std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0 &&
+                     header->version == VERSION && header->key == key &&
+                     sizeof(FileHeader) + sizeof(SectionHeader) * header->section_count <= size_;
+  if (!valid) {
+    munmap(const_cast<uint8_t *>(data_), size_);
+    data_ = nullptr;
+    size_ = 0;
+  }
+  return valid;
+}
+
+const void * MapCacheReader::find(
+  const std::string & name, size_t element_size, size_t & count) const
+{
+  if (data_ == nullptr) return nullptr;
+
+  const auto * header = reinterpret_cast<const FileHeader *>(data_);
+  const auto * sections = reinterpret_cast<const SectionHeader *>(data_ + sizeof(FileHeader));
+  for (uint32_t i = 0; i < header->section_count; ++i) {
+    const SectionHeader & section = sections[i];
+    if (std::strncmp(section.name, name.c_str(), sizeof(section.name)) != 0) continue;
+    if (section.element_size != element_size) return nullptr;
+    count = section.count;
+    // An empty section at the end may lie beyond the end of the file
+    if (count == 0) return data_;
+    if (section.offset + section.element_size * count > size_) return nullptr;
+    return data_ + section.offset;
+  }
+  return nullptr;
+}
+}  // namespace yabloc::ll2_decomposer
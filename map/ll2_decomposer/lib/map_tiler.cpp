@@ -0,0 +1,64 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ll2_decomposer/map_tiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace yabloc::ll2_decomposer
+{
+MapTiler::MapTiler(float tile_size) : tile_size_(tile_size)
+{
+  if (tile_size_ <= 0) throw std::invalid_argument("tile size must be positive");
+}
+
+int32_t MapTiler::to_index(float v) const
+{
+  return static_cast<int32_t>(std::floor(v / tile_size_));
+}
+
+void MapTiler::set_cloud(const Segments & cloud)
+{
+  tiles_.clear();
+  for (const pcl::PointNormal & pn : cloud) {
+    const auto [min_x, max_x] = std::minmax(pn.x, pn.normal_x);
+    const auto [min_y, max_y] = std::minmax(pn.y, pn.normal_y);
+    for (int32_t x = to_index(min_x); x <= to_index(max_x); ++x) {
+      for (int32_t y = to_index(min_y); y <= to_index(max_y); ++y) {
+        tiles_[{x, y}].push_back(pn);
+      }
+    }
+  }
+}
+
+std::vector<TileIndex> MapTiler::tiles_around(float x, float y, float radius) const
+{
+  std::vector<TileIndex> indices;
+  for (int32_t ix = to_index(x - radius); ix <= to_index(x + radius); ++ix) {
+    for (int32_t iy = to_index(y - radius); iy <= to_index(y + radius); ++iy) {
+      if (tiles_.count({ix, iy}) > 0) indices.push_back({ix, iy});
+    }
+  }
+  return indices;
+}
+
+const MapTiler::Segments * MapTiler::tile(const TileIndex & index) const
+{
+  auto itr = tiles_.find(index);
+  if (itr == tiles_.end()) return nullptr;
+  return &itr->second;
+}
+}  // namespace yabloc::ll2_decomposer
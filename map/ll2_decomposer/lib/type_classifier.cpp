@@ -0,0 +1,41 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ll2_decomposer/type_classifier.hpp"
+
+namespace yabloc::ll2_decomposer
+{
+void TypeClassifier::add_class(ClassMask bit, const std::set<std::string> & labels)
+{
+  classes_.emplace_back(bit, labels);
+  // Types which were already interned have to be classified again
+  for (size_t id = 0; id < types_.size(); ++id) {
+    if (labels.count(types_[id]) > 0) masks_[id] |= bit;
+  }
+}
+
+TypeClassifier::ClassMask TypeClassifier::classify(const std::string & type)
+{
+  auto [itr, inserted] = ids_.try_emplace(type, static_cast<uint16_t>(types_.size()));
+  if (!inserted) return masks_[itr->second];
+
+  ClassMask mask = 0;
+  for (const auto & [bit, labels] : classes_) {
+    if (labels.count(type) > 0) mask |= bit;
+  }
+  types_.push_back(type);
+  masks_.push_back(mask);
+  return mask;
+}
+}  // namespace yabloc::ll2_decomposer
@@ -12,9 +12,13 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-#include "ll2_decomposer/from_bin_msg.hpp"
 #include "ll2_decomposer/ll2_decomposer.hpp"
 
+#include "ll2_decomposer/from_bin_msg.hpp"
+#include "ll2_decomposer/map_cache.hpp"
+#include "ll2_decomposer/type_classifier.hpp"
+
+#include <rclcpp/serialization.hpp>
 #include <yabloc_common/color.hpp>
 #include <yabloc_common/pub_sub.hpp>
 
@@ -22,11 +26,28 @@
 
 #include <pcl_conversions/pcl_conversions.h>
 
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <execution>
+#include <functional>
+#include <unordered_set>
+
 namespace yabloc::ll2_decomposer
 {
-Ll2Decomposer::Ll2Decomposer() : Node("ll2_to_image")
+namespace
+{
+// Bump it whenever the derivation of the cached clouds and markers changes
+constexpr int CACHE_VERSION = 1;
+}  // namespace
+
+Ll2Decomposer::Ll2Decomposer()
+: Node("ll2_to_image"),
+  cache_dir_(declare_parameter<std::string>("cache_dir", "")),
+  tile_size_(declare_parameter<float>("tile_size", 100.0f))
 {
   using std::placeholders::_1;
+  using std::placeholders::_2;
   const rclcpp::QoS latch_qos = rclcpp::QoS(10).transient_local();
   const rclcpp::QoS map_qos = rclcpp::QoS(10).transient_local().reliable();
 
@@ -41,6 +62,13 @@ Ll2Decomposer::Ll2Decomposer() : Node("ll2_to_image")
   auto cb_map = std::bind(&Ll2Decomposer::on_map, this, _1);
   sub_map_ = create_subscription<HADMapBin>("/map/vector_map", map_qos, cb_map);
 
+  // Service
+  if (tile_size_ > 0) {
+    auto on_tiles = std::bind(&Ll2Decomposer::on_road_marking_tiles, this, _1, _2);
+    tiler_ = std::make_unique<MapTiler>(tile_size_);
+    service_tiles_ = create_service<GetMapTiles>("ll2_road_marking_tiles", on_tiles);
+  }
+
   auto load_lanelet2_labels =
     [this](const std::string & param_name, std::set<std::string> & labels) -> void {
     declare_parameter(param_name, std::vector<std::string>{});
@@ -58,38 +86,12 @@ Ll2Decomposer::Ll2Decomposer() : Node("ll2_to_image")
   }
 }
 
-void print_attr(const lanelet::LaneletMapPtr & lanelet_map, const rclcpp::Logger & logger)
-{
-  std::set<std::string> types;
-  for (const lanelet::ConstLineString3d & line : lanelet_map->lineStringLayer) {
-    if (!line.hasAttribute(lanelet::AttributeName::Type)) continue;
-    lanelet::Attribute attr = line.attribute(lanelet::AttributeName::Type);
-    types.insert(attr.value());
-  }
-  for (const lanelet::ConstPolygon3d & polygon : lanelet_map->polygonLayer) {
-    if (!polygon.hasAttribute(lanelet::AttributeName::Type)) {
-      continue;
-    }
-    lanelet::Attribute attr = polygon.attribute(lanelet::AttributeName::Type);
-    types.insert(attr.value());
-  }
-
-  for (const auto & type : types) {
-    RCLCPP_INFO_STREAM(logger, "lanelet type: " << type);
-  }
-}
-
-pcl::PointCloud<pcl::PointXYZL> Ll2Decomposer::load_bounding_boxes(
-  const lanelet::PolygonLayer & polygons) const
+pcl::PointCloud<pcl::PointXYZL> load_bounding_boxes(const lanelet::ConstPolygons3d & polygons)
 {
   pcl::PointCloud<pcl::PointXYZL> cloud;
   int index = 0;
 
   for (const lanelet::ConstPolygon3d & polygon : polygons) {
-    if (!polygon.hasAttribute(lanelet::AttributeName::Type)) continue;
-    lanelet::Attribute attr = polygon.attribute(lanelet::AttributeName::Type);
-    if (bounding_box_labels_.count(attr.value()) == 0) continue;
-
     for (const lanelet::ConstPoint3d & p : polygon) {
       pcl::PointXYZL xyzl;
       xyzl.x = p.x();
@@ -103,17 +105,14 @@ pcl::PointCloud<pcl::PointXYZL> Ll2Decomposer::load_bounding_boxes(
   return cloud;
 }
 
-pcl::PointCloud<pcl::PointXYZL> load_transition_areas(const lanelet::PolygonLayer & polygons)
+pcl::PointCloud<pcl::PointXYZL> load_transition_areas(const lanelet::ConstPolygons3d & polygons)
 {
   pcl::PointCloud<pcl::PointXYZL> cloud;
   int index = 0;
 
   for (const lanelet::ConstPolygon3d & polygon : polygons) {
-    if (!polygon.hasAttribute(lanelet::AttributeName::Type)) continue;
     lanelet::Attribute attr = polygon.attribute(lanelet::AttributeName::Type);
-    bool is_init_label = (attr.value() == "yabloc_init_area");
     bool is_deinit_label = (attr.value() == "yabloc_deinit_area");
-    if (!is_init_label && !is_deinit_label) continue;
 
     for (const lanelet::ConstPoint3d & p : polygon) {
       pcl::PointXYZL xyzl;
@@ -131,32 +130,185 @@ pcl::PointCloud<pcl::PointXYZL> load_transition_areas(const lanelet::PolygonLaye
 void Ll2Decomposer::on_map(const HADMapBin & msg)
 {
   RCLCPP_INFO_STREAM(get_logger(), "subscribed binary vector map");
-  lanelet::LaneletMapPtr lanelet_map = from_bin_msg(msg);
-  print_attr(lanelet_map, get_logger());
-
   const rclcpp::Time stamp = msg.header.stamp;
 
-  const auto & ls_layer = lanelet_map->lineStringLayer;
-  const auto & po_layer = lanelet_map->polygonLayer;
-  auto tmp1 = extract_specified_line_string(ls_layer, sign_board_labels_);
-  auto tmp2 = extract_specified_line_string(ls_layer, road_marking_labels_);
-  pcl::PointCloud<pcl::PointNormal> ll2_sign_board = split_line_strings(tmp1);
-  pcl::PointCloud<pcl::PointNormal> ll2_road_marking = split_line_strings(tmp2);
-  pcl::PointCloud<pcl::PointXYZL> ll2_transition_area = load_transition_areas(po_layer);
-  pcl::PointCloud<pcl::PointXYZL> ll2_bounding_box = load_bounding_boxes(po_layer);
+  // The map is deserialized only if there is no cache of it
+  const uint64_t key = cache_key(msg);
+  std::optional<Decomposition> decomposition = load_cache(key);
+  if (decomposition.has_value()) {
+    RCLCPP_INFO_STREAM(get_logger(), "map is loaded from cache");
+  } else {
+    decomposition = decompose(from_bin_msg(msg));
+    save_cache(key, decomposition.value());
+  }
+
+  for (Marker & marker : decomposition->marker.markers) marker.header.stamp = get_clock()->now();
+  pub_marker_->publish(decomposition->marker);
 
-  publish_additional_marker(lanelet_map);
+  common::publish_cloud(*pub_road_marking_, decomposition->road_marking, stamp);
+  common::publish_cloud(*pub_sign_board_, decomposition->sign_board, stamp);
+  common::publish_cloud(*pub_transition_area_, decomposition->transition_area, stamp);
+  common::publish_cloud(*pub_bounding_box_, decomposition->bounding_box, stamp);
 
-  common::publish_cloud(*pub_road_marking_, ll2_road_marking, stamp);
-  common::publish_cloud(*pub_sign_board_, ll2_sign_board, stamp);
-  common::publish_cloud(*pub_transition_area_, ll2_transition_area, stamp);
-  common::publish_cloud(*pub_bounding_box_, ll2_bounding_box, stamp);
+  if (tiler_) tiler_->set_cloud(decomposition->road_marking);
 
   RCLCPP_INFO_STREAM(get_logger(), "successed map decomposing");
 }
 
+void Ll2Decomposer::on_road_marking_tiles(
+  GetMapTiles::Request::ConstSharedPtr request, GetMapTiles::Response::SharedPtr response)
+{
+  std::unordered_set<TileIndex, TileIndex::Hash> held;
+  const size_t held_count = std::min(request->held_x.size(), request->held_y.size());
+  for (size_t i = 0; i < held_count; ++i) held.insert({request->held_x[i], request->held_y[i]});
+
+  response->tile_size = tiler_->tile_size();
+  const auto & center = request->center;
+  for (const TileIndex & index : tiler_->tiles_around(center.x, center.y, request->radius)) {
+    if (held.count(index) > 0) continue;
+
+    map_tile_msgs::msg::MapTile tile;
+    tile.x = index.x;
+    tile.y = index.y;
+    pcl::toROSMsg(*tiler_->tile(index), tile.cloud);
+    tile.cloud.header.frame_id = "map";
+    tile.cloud.header.stamp = get_clock()->now();
+    response->tiles.push_back(std::move(tile));
+  }
+}
+
+Ll2Decomposer::Decomposition Ll2Decomposer::decompose(const lanelet::LaneletMapPtr & lanelet_map)
+{
+  enum : TypeClassifier::ClassMask {
+    SIGN_BOARD = 1 << 0,
+    ROAD_MARKING = 1 << 1,
+    VIRTUAL = 1 << 2,
+    TRANSITION_AREA = 1 << 3,
+    BOUNDING_BOX = 1 << 4,
+    BOUNDING_BOX_MARKER = 1 << 5,
+  };
+
+  TypeClassifier classifier;
+  classifier.add_class(SIGN_BOARD, sign_board_labels_);
+  classifier.add_class(ROAD_MARKING, road_marking_labels_);
+  classifier.add_class(VIRTUAL, {"virtual"});
+  classifier.add_class(TRANSITION_AREA, {"yabloc_init_area", "yabloc_deinit_area"});
+  classifier.add_class(BOUNDING_BOX, bounding_box_labels_);
+  classifier.add_class(BOUNDING_BOX_MARKER, {"bounding_box"});
+
+  // Each layer is scanned once, and the elements are bucketed by their class
+  lanelet::ConstLineStrings3d sign_boards, road_markings, virtual_lines;
+  for (const lanelet::ConstLineString3d & line : lanelet_map->lineStringLayer) {
+    if (!line.hasAttribute(lanelet::AttributeName::Type)) continue;
+    const auto mask = classifier.classify(line.attribute(lanelet::AttributeName::Type).value());
+    if (mask & SIGN_BOARD) sign_boards.push_back(line);
+    if (mask & ROAD_MARKING) road_markings.push_back(line);
+    if (mask & VIRTUAL) virtual_lines.push_back(line);
+  }
+
+  lanelet::ConstPolygons3d transition_areas, bounding_boxes, bounding_box_markers;
+  for (const lanelet::ConstPolygon3d & polygon : lanelet_map->polygonLayer) {
+    if (!polygon.hasAttribute(lanelet::AttributeName::Type)) continue;
+    const auto mask = classifier.classify(polygon.attribute(lanelet::AttributeName::Type).value());
+    if (mask & TRANSITION_AREA) transition_areas.push_back(polygon);
+    if (mask & BOUNDING_BOX) bounding_boxes.push_back(polygon);
+    if (mask & BOUNDING_BOX_MARKER) bounding_box_markers.push_back(polygon);
+  }
+
+  const std::set<std::string> types(classifier.types().begin(), classifier.types().end());
+  for (const auto & type : types) {
+    RCLCPP_INFO_STREAM(get_logger(), "lanelet type: " << type);
+  }
+
+  // The outputs are independent of each other, so they are generated in parallel.
+  // Every task writes only its own output.
+  Decomposition decomposition;
+  std::array<MarkerArray, 4> markers;
+  const std::vector<std::function<void()>> tasks = {
+    [&] { decomposition.road_marking = split_line_strings(road_markings); },
+    [&] { decomposition.sign_board = split_line_strings(sign_boards); },
+    [&] { decomposition.transition_area = load_transition_areas(transition_areas); },
+    [&] { decomposition.bounding_box = load_bounding_boxes(bounding_boxes); },
+    [&] { markers[0] = make_sign_marker_msg(sign_boards, "sign_board"); },
+    [&] { markers[1] = make_sign_marker_msg(virtual_lines, "virtual"); },
+    [&] { markers[2] = make_polygon_marker_msg(transition_areas, "transition_area"); },
+    [&] { markers[3] = make_polygon_marker_msg(bounding_box_markers, "bounding_box"); },
+  };
+  std::for_each(std::execution::par, tasks.begin(), tasks.end(), [](const auto & task) { task(); });
+
+  for (const MarkerArray & marker_array : markers) {
+    auto & dst = decomposition.marker.markers;
+    dst.insert(dst.end(), marker_array.markers.begin(), marker_array.markers.end());
+  }
+  return decomposition;
+}
+
+uint64_t Ll2Decomposer::cache_key(const HADMapBin & msg) const
+{
+  uint64_t key = hash_map_bin(msg);
+  key = hash_combine(key, std::to_string(CACHE_VERSION));
+  for (const auto * labels : {&road_marking_labels_, &sign_board_labels_, &bounding_box_labels_}) {
+    std::string joined;
+    for (const std::string & label : *labels) joined += label + ",";
+    key = hash_combine(key, joined);
+  }
+  return key;
+}
+
+std::optional<Ll2Decomposer::Decomposition> Ll2Decomposer::load_cache(uint64_t key) const
+{
+  if (cache_dir_.empty()) return std::nullopt;
+
+  MapCacheReader reader;
+  if (!reader.open(map_cache_path(cache_dir_, "ll2_decomposer", key), key)) return std::nullopt;
+
+  auto road_marking = reader.cloud<pcl::PointNormal>("road_marking");
+  auto sign_board = reader.cloud<pcl::PointNormal>("sign_board");
+  auto transition_area = reader.cloud<pcl::PointXYZL>("transition_area");
+  auto bounding_box = reader.cloud<pcl::PointXYZL>("bounding_box");
+  size_t marker_size = 0;
+  const void * marker_data = reader.find("marker", 1, marker_size);
+  if (!road_marking || !sign_board || !transition_area || !bounding_box || !marker_data)
+    return std::nullopt;
+
+  Decomposition decomposition;
+  decomposition.road_marking = std::move(road_marking.value());
+  decomposition.sign_board = std::move(sign_board.value());
+  decomposition.transition_area = std::move(transition_area.value());
+  decomposition.bounding_box = std::move(bounding_box.value());
+
+  rclcpp::SerializedMessage serialized(marker_size);
+  auto & buffer = serialized.get_rcl_serialized_message();
+  std::memcpy(buffer.buffer, marker_data, marker_size);
+  buffer.buffer_length = marker_size;
+  rclcpp::Serialization<MarkerArray>().deserialize_message(&serialized, &decomposition.marker);
+  return decomposition;
+}
+
+void Ll2Decomposer::save_cache(uint64_t key, const Decomposition & decomposition) const
+{
+  if (cache_dir_.empty()) return;
+
+  rclcpp::SerializedMessage serialized;
+  rclcpp::Serialization<MarkerArray>().serialize_message(&decomposition.marker, &serialized);
+  const auto & buffer = serialized.get_rcl_serialized_message();
+
+  MapCacheWriter writer;
+  writer.add("road_marking", decomposition.road_marking);
+  writer.add("sign_board", decomposition.sign_board);
+  writer.add("transition_area", decomposition.transition_area);
+  writer.add("bounding_box", decomposition.bounding_box);
+  writer.add("marker", buffer.buffer, 1, buffer.buffer_length);
+
+  const std::string path = map_cache_path(cache_dir_, "ll2_decomposer", key);
+  if (writer.write(path, key))
+    RCLCPP_INFO_STREAM(get_logger(), "map cache is written to " << path);
+  else
+    RCLCPP_WARN_STREAM(get_logger(), "map cache cannot be written to " << path);
+}
+
 pcl::PointCloud<pcl::PointNormal> Ll2Decomposer::split_line_strings(
-  const lanelet::ConstLineStrings3d & line_strings)
+  const lanelet::ConstLineStrings3d & line_strings) const
 {
   pcl::PointCloud<pcl::PointNormal> extracted;
   for (const lanelet::ConstLineString3d & line : line_strings) {
@@ -172,32 +324,6 @@ pcl::PointCloud<pcl::PointNormal> Ll2Decomposer::split_line_strings(
   return extracted;
 }
 
-lanelet::ConstLineStrings3d Ll2Decomposer::extract_specified_line_string(
-  const lanelet::LineStringLayer & line_string_layer, const std::set<std::string> & visible_labels)
-{
-  lanelet::ConstLineStrings3d line_strings;
-  for (const lanelet::ConstLineString3d & line : line_string_layer) {
-    if (!line.hasAttribute(lanelet::AttributeName::Type)) continue;
-    lanelet::Attribute attr = line.attribute(lanelet::AttributeName::Type);
-    if (visible_labels.count(attr.value()) == 0) continue;
-    line_strings.push_back(line);
-  }
-  return line_strings;
-}
-
-lanelet::ConstPolygons3d Ll2Decomposer::extract_specified_polygon(
-  const lanelet::PolygonLayer & polygon_layer, const std::set<std::string> & visible_labels)
-{
-  lanelet::ConstPolygons3d polygons;
-  for (const lanelet::ConstPolygon3d & polygon : polygon_layer) {
-    if (!polygon.hasAttribute(lanelet::AttributeName::Type)) continue;
-    lanelet::Attribute attr = polygon.attribute(lanelet::AttributeName::Type);
-    if (visible_labels.count(attr.value()) == 0) continue;
-    polygons.push_back(polygon);
-  }
-  return polygons;
-}
-
 pcl::PointNormal Ll2Decomposer::to_point_normal(
   const lanelet::ConstPoint3d & from, const lanelet::ConstPoint3d & to) const
 {
@@ -212,18 +338,13 @@ pcl::PointNormal Ll2Decomposer::to_point_normal(
 }
 
 Ll2Decomposer::MarkerArray Ll2Decomposer::make_sign_marker_msg(
-  const lanelet::LineStringLayer & line_string_layer, const std::set<std::string> & labels,
-  const std::string & ns)
+  const lanelet::ConstLineStrings3d & line_strings, const std::string & ns) const
 {
-  lanelet::ConstLineStrings3d line_strings =
-    extract_specified_line_string(line_string_layer, labels);
-
   MarkerArray marker_array;
   int id = 0;
   for (const lanelet::ConstLineString3d & line_string : line_strings) {
     Marker marker;
     marker.header.frame_id = "map";
-    marker.header.stamp = get_clock()->now();
     marker.type = Marker::LINE_STRIP;
     marker.color = common::Color(0.6f, 0.6f, 0.6f, 0.999f);
     marker.scale.x = 0.1;
@@ -243,17 +364,13 @@ Ll2Decomposer::MarkerArray Ll2Decomposer::make_sign_marker_msg(
 }
 
 Ll2Decomposer::MarkerArray Ll2Decomposer::make_polygon_marker_msg(
-  const lanelet::PolygonLayer & polygon_layer, const std::set<std::string> & labels,
-  const std::string & ns)
+  const lanelet::ConstPolygons3d & polygons, const std::string & ns) const
 {
-  lanelet::ConstPolygons3d polygons = extract_specified_polygon(polygon_layer, labels);
-
   MarkerArray marker_array;
   int id = 0;
   for (const lanelet::ConstPolygon3d & polygon : polygons) {
     Marker marker;
     marker.header.frame_id = "map";
-    marker.header.stamp = get_clock()->now();
     marker.type = Marker::LINE_STRIP;
     marker.color = common::Color(0.4f, 0.4f, 0.8f, 0.999f);
     marker.scale.x = 0.2;
@@ -276,20 +393,4 @@ Ll2Decomposer::MarkerArray Ll2Decomposer::make_polygon_marker_msg(
   return marker_array;
 }
 
-void Ll2Decomposer::publish_additional_marker(const lanelet::LaneletMapPtr & lanelet_map)
-{
-  auto marker1 =
-    make_sign_marker_msg(lanelet_map->lineStringLayer, sign_board_labels_, "sign_board");
-  auto marker2 = make_sign_marker_msg(lanelet_map->lineStringLayer, {"virtual"}, "virtual");
-  auto marker3 = make_polygon_marker_msg(
-    lanelet_map->polygonLayer, {"yabloc_init_area", "yabloc_deinit_area"}, "transition_area");
-  auto marker4 =
-    make_polygon_marker_msg(lanelet_map->polygonLayer, {"bounding_box"}, "bounding_box");
-
-  std::copy(marker2.markers.begin(), marker2.markers.end(), std::back_inserter(marker1.markers));
-  std::copy(marker3.markers.begin(), marker3.markers.end(), std::back_inserter(marker1.markers));
-  std::copy(marker4.markers.begin(), marker4.markers.end(), std::back_inserter(marker1.markers));
-  pub_marker_->publish(marker1);
-}
-
 }  // namespace yabloc::ll2_decomposer
\ No newline at end of file
@@ -14,10 +14,18 @@
 
 #pragma once
 
+#include "camera_particle_corrector/scoring_sample.hpp"
+
 #include <ll2_cost_map/hierarchical_cost_map.hpp>
 #include <modularized_particle_filter/correction/abst_corrector.hpp>
 #include <opencv4/opencv2/core.hpp>
+#include <sophus/geometry.hpp>
 #include <std_srvs/srv/set_bool.hpp>
+#include <yabloc_common/latest_only_subscription.hpp>
+#include <yabloc_common/line_segments_view.hpp>
+#include <yabloc_common/stage_stamp_publisher.hpp>
+#include <yabloc_common/timer.hpp>
+#include <yabloc_common/trace_reporter.hpp>
 
 #include <geometry_msgs/msg/pose_stamped.hpp>
 #include <sensor_msgs/msg/image.hpp>
@@ -28,16 +36,24 @@
 #include <pcl/point_cloud.h>
 #include <pcl/point_types.h>
 
+#include <set>
+#include <string>
+
 namespace yabloc::modularized_particle_filter
 {
 cv::Point2f cv2pt(const Eigen::Vector3f v);
 float abs_cos(const Eigen::Vector3f & t, float deg);
 
+// Sum up the logit of samples[begin, end) placed at the pose of transform
+float compute_logit(
+  const std::vector<ScoringSample> & samples, size_t begin, size_t end,
+  const Sophus::SE3f & transform, HierarchicalCostMap & cost_map);
+
 class CameraParticleCorrector : public modularized_particle_filter::AbstCorrector
 {
 public:
-  using LineSegment = pcl::PointXYZLNormal;
-  using LineSegments = pcl::PointCloud<LineSegment>;
+  using LineSegment = ScoringSamplePlanner::LineSegment;
+  using LineSegments = ScoringSamplePlanner::LineSegments;
   using PointCloud2 = sensor_msgs::msg::PointCloud2;
   using PoseStamped = geometry_msgs::msg::PoseStamped;
   using Image = sensor_msgs::msg::Image;
@@ -46,19 +62,25 @@ public:
   using Bool = std_msgs::msg::Bool;
   using String = std_msgs::msg::String;
   using SetBool = std_srvs::srv::SetBool;
-  CameraParticleCorrector();
+  explicit CameraParticleCorrector(const rclcpp::NodeOptions & options = rclcpp::NodeOptions());
 
 private:
   const float min_prob_;
   const float far_weight_gain_;
+  const ScoringSamplePlanner sample_planner_;
+  const double fusion_time_window_;
+  const int num_of_cameras_;
+  // Scoring stops at this time [ms] from the start of correction. Disabled if not positive.
+  const float scoring_time_budget_;
   HierarchicalCostMap cost_map_;
 
   rclcpp::Subscription<PointCloud2>::SharedPtr sub_bounding_box_;
-  rclcpp::Subscription<PointCloud2>::SharedPtr sub_line_segments_cloud_;
+  common::LatestOnlySubscription<PointCloud2>::SharedPtr sub_line_segments_cloud_;
   rclcpp::Subscription<PointCloud2>::SharedPtr sub_ll2_;
   rclcpp::Subscription<PoseStamped>::SharedPtr sub_pose_;
   rclcpp::Service<SetBool>::SharedPtr switch_service_;
   rclcpp::TimerBase::SharedPtr timer_;
+  rclcpp::TimerBase::SharedPtr fusion_timer_;
 
   rclcpp::Publisher<Image>::SharedPtr pub_image_;
   rclcpp::Publisher<Image>::SharedPtr pub_map_image_;
@@ -72,21 +94,52 @@ private:
   std::function<float(float)> score_converter_;
 
   bool enable_switch_{true};
+  // Fraction of the gain of the sample set which was scored in the last correction
+  float last_scored_fraction_{1.0f};
+
+  // Segments from multiple cameras which are waiting to be scored together
+  struct PendingSegments
+  {
+    rclcpp::Time stamp;
+    // When the first segments of the set arrived, on the node clock
+    rclcpp::Time arrival;
+    // frame_id of the cameras which have arrived
+    std::set<std::string> cameras;
+    LineSegments segments;
+  };
+  std::optional<PendingSegments> pending_{std::nullopt};
+
+  common::TraceReporter trace_reporter_{this};
+  common::StageStampPublisher stage_stamp_{this, "corrector"};
 
   void on_line_segments(const PointCloud2 & msg);
   void on_ll2(const PointCloud2 & msg);
   void on_bounding_box(const PointCloud2 & msg);
   void on_pose(const PoseStamped & msg);
   void on_timer();
+  void on_fusion_timer();
   void on_service(SetBool::Request::ConstSharedPtr request, SetBool::Response::SharedPtr response);
 
-  std::pair<LineSegments, LineSegments> split_line_segments(const PointCloud2 & msg);
+  // Return the reliable segments and the a posteriori ones which are consistent with the map.
+  // The view is read in place, and only the selected segments are copied.
+  LineSegments select_line_segments(
+    const common::LineSegmentsView & line_segments, const rclcpp::Time & stamp);
+
+  void flush_pending_segments();
+
+  void correct(const rclcpp::Time & stamp, const LineSegments & line_segments);
 
-  float compute_logit(const LineSegments & line_segments_cloud, const Eigen::Vector3f & self_position);
+  // Score samples in order by chunk until the time budget runs out. Every particle is scored with
+  // the same prefix of the samples, and the logits are normalized by the scored fraction.
+  // Return the scored fraction.
+  float score_particles(
+    const std::vector<ScoringSample> & samples, ParticleArray & particles,
+    const common::Timer & timer);
 
   pcl::PointCloud<pcl::PointXYZI> evaluate_cloud(
-    const LineSegments & line_segments_cloud, const Eigen::Vector3f & self_position);
+    const std::vector<ScoringSample> & samples, const Sophus::SE3f & transform, bool reliable);
 
-  std::pair<LineSegments, LineSegments> filt(const LineSegments & lines);
+  // Return true if the a posteriori segment is consistent with the map at the pose
+  bool filt(const LineSegment & iffy_line, const Sophus::SE3f & pose);
 };
 }  // namespace yabloc::modularized_particle_filter
\ No newline at end of file
@@ -0,0 +1,74 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <Eigen/Core>
+#include <yabloc_common/line_segments_view.hpp>
+
+#include <vector>
+
+namespace yabloc::modularized_particle_filter
+{
+// A point sampled on an observed line segment, in base_link.
+// It does not depend on particles, so the sample set is made once per frame and shared by all of
+// them. Only the pose of each particle is applied at scoring.
+struct ScoringSample
+{
+  Eigen::Vector3f position;
+  Eigen::Vector3f tangent;
+  // Attenuation by the distance from the vehicle multiplied by the weight of the segment label
+  // and the length which the sample represents
+  float gain;
+  // False if the sample is on an a posteriori (label == 0) segment
+  bool reliable;
+};
+
+// Plan a sample set of a frame. The spacing grows as the distance gain decays, from min_spacing
+// up to max_spacing, and each sample is weighted by its spacing so that the total logit does not
+// depend on the spacing. If the samples exceed max_samples, all spacings are widened evenly so
+// that the number of samples becomes about max_samples.
+class ScoringSamplePlanner
+{
+public:
+  using LineSegment = common::LineSegmentsView::Segment;
+  using LineSegments = std::vector<LineSegment>;
+
+  ScoringSamplePlanner(
+    float far_weight_gain, float min_spacing, float max_spacing, int max_samples,
+    bool merge_collinear);
+
+  // Samples are sorted by the horizontal distance from base_link, near samples first.
+  std::vector<ScoringSample> plan(const LineSegments & line_segments) const;
+
+private:
+  // Logits are weighted relative to this spacing which was the fixed one before
+  static constexpr float REFERENCE_SPACING = 0.1f;
+
+  const float far_weight_gain_;
+  const float min_spacing_;
+  const float max_spacing_;
+  const int max_samples_;
+  const bool merge_collinear_;
+
+  float distance_gain(const Eigen::Vector3f & p) const;
+  float spacing_at(const Eigen::Vector3f & p) const;
+
+  // Return the number of samples. Samples are pushed into `samples` if it is not nullptr.
+  size_t sample_segment(
+    const LineSegment & segment, float scale, std::vector<ScoringSample> * samples) const;
+
+  // Overlapping segments (e.g. detected by two cameras) would be scored twice without this
+  LineSegments merge_collinear_segments(const LineSegments & line_segments) const;
+};
+}  // namespace yabloc::modularized_particle_filter
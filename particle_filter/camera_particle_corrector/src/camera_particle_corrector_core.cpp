@@ -18,26 +18,44 @@
 
 #include <opencv4/opencv2/imgproc.hpp>
 #include <yabloc_common/color.hpp>
+#include <yabloc_common/line_segments_view.hpp>
 #include <yabloc_common/pose_conversions.hpp>
 #include <yabloc_common/pub_sub.hpp>
 #include <yabloc_common/timer.hpp>
-#include <yabloc_common/transform_line_segments.hpp>
+#include <yabloc_common/trace.hpp>
 
 #include <pcl_conversions/pcl_conversions.h>
 
+#include <chrono>
+#include <stdexcept>
+
 namespace yabloc::modularized_particle_filter
 {
 FastCosSin fast_math;
 
-CameraParticleCorrector::CameraParticleCorrector()
-: AbstCorrector("camera_particle_corrector"),
+CameraParticleCorrector::CameraParticleCorrector(const rclcpp::NodeOptions & options)
+: AbstCorrector("camera_particle_corrector", options),
   min_prob_(declare_parameter<float>("min_prob", 0.01)),
   far_weight_gain_(declare_parameter<float>("far_weight_gain", 0.001)),
+  sample_planner_(
+    far_weight_gain_, declare_parameter<float>("min_sample_spacing", 0.1),
+    declare_parameter<float>("max_sample_spacing", 0.1),
+    declare_parameter<int>("max_samples_per_frame", 0),
+    declare_parameter<bool>("merge_collinear_segments", false)),
+  fusion_time_window_(declare_parameter<double>("fusion_time_window", 0.0)),
+  num_of_cameras_(declare_parameter<int>("num_of_cameras", 0)),
+  scoring_time_budget_(declare_parameter<float>("scoring_time_budget", 0.0)),
   cost_map_(this)
 {
   using std::placeholders::_1;
   using std::placeholders::_2;
 
+  // Without the number of cameras, a frame set could be closed only by the next frame set
+  if (fusion_time_window_ > 0 && num_of_cameras_ <= 0) {
+    throw std::invalid_argument(
+      "num_of_cameras must be positive if fusion_time_window is positive");
+  }
+
   enable_switch_ = declare_parameter<bool>("enabled_at_first", true);
 
   // Publication
@@ -53,9 +71,15 @@ CameraParticleCorrector::CameraParticleCorrector()
   auto on_ll2 = std::bind(&CameraParticleCorrector::on_ll2, this, _1);
   auto on_bounding_box = std::bind(&CameraParticleCorrector::on_bounding_box, this, _1);
   auto on_pose = std::bind(&CameraParticleCorrector::on_pose, this, _1);
-  sub_line_segments_cloud_ =
-    create_subscription<PointCloud2>("line_segments_cloud", 10, on_line_segments);
-  sub_ll2_ = create_subscription<PointCloud2>("ll2_road_marking", 10, on_ll2);
+  // Line segments of multiple cameras share the topic, so none of them may be skipped for fusion
+  const bool latest_only = declare_parameter<bool>("latest_only", true) && fusion_time_window_ <= 0;
+  sub_line_segments_cloud_ = std::make_shared<common::LatestOnlySubscription<PointCloud2>>(
+    this, "line_segments_cloud", 10, on_line_segments, latest_only);
+  stage_stamp_.set_drop_counter([this]() { return sub_line_segments_cloud_->dropped_count(); });
+  // With map tiles, the whole road marking cloud is not held
+  if (!cost_map_.use_map_tiles()) {
+    sub_ll2_ = create_subscription<PointCloud2>("ll2_road_marking", 10, on_ll2);
+  }
   sub_bounding_box_ = create_subscription<PointCloud2>("ll2_bounding_box", 10, on_bounding_box);
   sub_pose_ = create_subscription<PoseStamped>("pose", 10, on_pose);
 
@@ -66,6 +90,15 @@ CameraParticleCorrector::CameraParticleCorrector()
   auto on_timer = std::bind(&CameraParticleCorrector::on_timer, this);
   timer_ =
     rclcpp::create_timer(this, this->get_clock(), rclcpp::Rate(1).period(), std::move(on_timer));
+
+  // A set which misses a camera is scored when the window expires
+  if (fusion_time_window_ > 0) {
+    auto on_fusion_timer = std::bind(&CameraParticleCorrector::on_fusion_timer, this);
+    const auto period = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::duration<double>(fusion_time_window_));
+    fusion_timer_ =
+      rclcpp::create_timer(this, this->get_clock(), period, std::move(on_fusion_timer));
+  }
 }
 
 void CameraParticleCorrector::on_pose(const PoseStamped & msg) { latest_pose_ = msg; }
@@ -90,45 +123,100 @@ void CameraParticleCorrector::on_bounding_box(const PointCloud2 & msg)
   RCLCPP_INFO_STREAM(get_logger(), "Set bounding box into cost map");
 }
 
-std::pair<CameraParticleCorrector::LineSegments, CameraParticleCorrector::LineSegments>
-CameraParticleCorrector::split_line_segments(const PointCloud2 & msg)
+CameraParticleCorrector::LineSegments CameraParticleCorrector::select_line_segments(
+  const common::LineSegmentsView & line_segments, const rclcpp::Time & stamp)
 {
-  LineSegments all_line_segments_cloud;
-  pcl::fromROSMsg(msg, all_line_segments_cloud);
-  LineSegments reliable_cloud, iffy_cloud;
-  {
-    for (const auto & p : all_line_segments_cloud) {
-      if (p.label == 0)
-        iffy_cloud.push_back(p);
-      else
-        reliable_cloud.push_back(p);
-    }
+  if (!latest_pose_.has_value()) {
+    throw std::runtime_error("latest_pose_ is nullopt");
   }
-
-  auto [good_cloud, bad_cloud] = filt(iffy_cloud);
-  {
-    cv::Mat debug_image = cv::Mat::zeros(800, 800, CV_8UC3);
-    auto draw = [&debug_image](LineSegments & cloud, cv::Scalar color) -> void {
-      for (const auto & line : cloud) {
-        const Eigen::Vector3f p1 = line.getVector3fMap();
-        const Eigen::Vector3f p2 = line.getNormalVector3fMap();
-        cv::line(debug_image, cv2pt(p1), cv2pt(p2), color, 2);
-      }
-    };
-
-    draw(reliable_cloud, cv::Scalar(0, 0, 255));
-    draw(good_cloud, cv::Scalar(0, 255, 0));
-    draw(bad_cloud, cv::Scalar(100, 100, 100));
-    common::publish_image(*pub_image_, debug_image, msg.header.stamp);
+  const Sophus::SE3f pose = common::pose_to_se3(latest_pose_.value().pose);
+
+  LineSegments selected;
+  selected.reserve(line_segments.size());
+  cv::Mat debug_image = cv::Mat::zeros(800, 800, CV_8UC3);
+  for (const LineSegment & segment : line_segments) {
+    const bool reliable = segment.label != 0;
+    const bool good = reliable || filt(segment, pose);
+    if (good) selected.push_back(segment);
+
+    // reliable: red, consistent a posteriori: green, inconsistent a posteriori: gray
+    cv::Scalar color(100, 100, 100);
+    if (reliable)
+      color = cv::Scalar(0, 0, 255);
+    else if (good)
+      color = cv::Scalar(0, 255, 0);
+    cv::line(debug_image, cv2pt(segment.from), cv2pt(segment.to), color, 2);
   }
+  common::publish_image(*pub_image_, debug_image, stamp);
 
-  return {reliable_cloud, good_cloud};
+  return selected;
 }
 
 void CameraParticleCorrector::on_line_segments(const PointCloud2 & line_segments_msg)
 {
-  common::Timer timer;
   const rclcpp::Time stamp = line_segments_msg.header.stamp;
+
+  // Segments are read in place rather than converting the whole message
+  const common::LineSegmentsView view(line_segments_msg);
+  if (!view.valid()) {
+    RCLCPP_WARN_STREAM_THROTTLE(
+      get_logger(), *get_clock(), 2000, "Drop malformed line segments: " << view.error());
+    return;
+  }
+  LineSegments line_segments = select_line_segments(view, stamp);
+
+  // Single camera: every message is scored as it comes
+  if (fusion_time_window_ <= 0) {
+    correct(stamp, line_segments);
+    return;
+  }
+
+  // Multiple cameras: all cameras publish into the same topic and their segments are already in
+  // base_link, so the segments within the time window are merged and scored at once.
+  // segment_filter gives the camera frame as frame_id, which tells the cameras apart.
+  const std::string & camera = line_segments_msg.header.frame_id;
+  if (pending_.has_value()) {
+    const double dt = (stamp - pending_->stamp).seconds();
+    // The next frame of a camera in the set also closes the set
+    if (std::abs(dt) > fusion_time_window_ || pending_->cameras.count(camera) > 0) {
+      flush_pending_segments();
+    }
+  }
+  if (!pending_.has_value()) pending_ = PendingSegments{stamp, now(), {}, {}};
+
+  pending_->cameras.insert(camera);
+  pending_->segments.insert(
+    pending_->segments.end(), line_segments.begin(), line_segments.end());
+
+  if (static_cast<int>(pending_->cameras.size()) >= num_of_cameras_) flush_pending_segments();
+}
+
+void CameraParticleCorrector::on_fusion_timer()
+{
+  if (!pending_.has_value()) return;
+  if ((now() - pending_->arrival).seconds() < fusion_time_window_) return;
+
+  RCLCPP_WARN_STREAM_THROTTLE(
+    get_logger(), *get_clock(), 2000,
+    "Score line segments of " << pending_->cameras.size() << " of " << num_of_cameras_
+                              << " cameras since the fusion time window expired");
+  flush_pending_segments();
+}
+
+void CameraParticleCorrector::flush_pending_segments()
+{
+  if (!pending_.has_value()) return;
+  PendingSegments pending = std::move(pending_.value());
+  pending_ = std::nullopt;
+  correct(pending.stamp, pending.segments);
+}
+
+void CameraParticleCorrector::correct(
+  const rclcpp::Time & stamp, const LineSegments & line_segments)
+{
+  YABLOC_TRACE_SCOPE("camera_particle_corrector/correct");
+  const auto start = stage_stamp_.start();
+  common::Timer timer;
   std::optional<ParticleArray> opt_array = this->get_synchronized_particle_array(stamp);
   if (!opt_array.has_value()) {
     return;
@@ -140,7 +228,6 @@ void CameraParticleCorrector::on_line_segments(const PointCloud2 & line_segments
     RCLCPP_WARN_STREAM(get_logger(), text << dt.seconds());
   }
 
-  auto [line_segments_cloud, iffy_line_segments_cloud] = split_line_segments(line_segments_msg);
   ParticleArray weighted_particles = opt_array.value();
 
   bool publish_weighted_particles = true;
@@ -160,22 +247,26 @@ void CameraParticleCorrector::on_line_segments(const PointCloud2 & line_segments
   }
 
   cost_map_.set_height(meaned_pose.position.z);
+  cost_map_.request_tiles({meaned_pose.position.x, meaned_pose.position.y});
+
+  std::vector<ScoringSample> samples;
+  {
+    YABLOC_TRACE_SCOPE("camera_particle_corrector/plan");
+    samples = sample_planner_.plan(line_segments);
+  }
 
   if (publish_weighted_particles) {
-    for (auto & particle : weighted_particles.particles) {
-      Sophus::SE3f transform = common::pose_to_se3(particle.pose);
-      LineSegments transformed_line_segments =
-        common::transform_line_segments(line_segments_cloud, transform);
-      LineSegments transformed_iffy_line_segments =
-        common::transform_line_segments(iffy_line_segments_cloud, transform);
-      transformed_line_segments += transformed_iffy_line_segments;
-
-      float logit = compute_logit(transformed_line_segments, transform.translation());
-      particle.weight = logit_to_prob(logit, 0.01f);
+    YABLOC_TRACE_SCOPE("camera_particle_corrector/score");
+    last_scored_fraction_ = score_particles(samples, weighted_particles, timer);
+    if (last_scored_fraction_ < 1.0f) {
+      RCLCPP_WARN_STREAM_THROTTLE(
+        get_logger(), *get_clock(), 2000,
+        "Scoring reached the time budget at " << last_scored_fraction_ * 100 << "% of samples");
     }
 
     if (enable_switch_) {
       this->set_weighted_particle_array(weighted_particles);
+      stage_stamp_.publish(stamp, weighted_particles.header.stamp, start);
     }
   }
 
@@ -184,14 +275,12 @@ void CameraParticleCorrector::on_line_segments(const PointCloud2 & line_segments
 
   // DEBUG: just visualization
   {
+    YABLOC_TRACE_SCOPE("camera_particle_corrector/debug");
     Pose meaned_pose = mean_pose(weighted_particles);
     Sophus::SE3f transform = common::pose_to_se3(meaned_pose);
 
-    pcl::PointCloud<pcl::PointXYZI> cloud = evaluate_cloud(
-      common::transform_line_segments(line_segments_cloud, transform), transform.translation());
-    pcl::PointCloud<pcl::PointXYZI> iffy_cloud = evaluate_cloud(
-      common::transform_line_segments(iffy_line_segments_cloud, transform),
-      transform.translation());
+    pcl::PointCloud<pcl::PointXYZI> cloud = evaluate_cloud(samples, transform, true);
+    pcl::PointCloud<pcl::PointXYZI> iffy_cloud = evaluate_cloud(samples, transform, false);
 
     pcl::PointCloud<pcl::PointXYZRGB> rgb_cloud;
     pcl::PointCloud<pcl::PointXYZRGB> rgb_cloud2;
@@ -213,15 +302,12 @@ void CameraParticleCorrector::on_line_segments(const PointCloud2 & line_segments
       rgb_cloud2.push_back(rgb);
     }
 
-    common::publish_cloud(*pub_scored_cloud_, rgb_cloud, line_segments_msg.header.stamp);
-    common::publish_cloud(
-      *pub_scored_posteriori_cloud_, rgb_cloud2, line_segments_msg.header.stamp);
+    common::publish_cloud(*pub_scored_cloud_, rgb_cloud, stamp);
+    common::publish_cloud(*pub_scored_posteriori_cloud_, rgb_cloud2, stamp);
   }
 
   if (timer.milli_seconds() > 80) {
-    RCLCPP_WARN_STREAM(get_logger(), "on_line_segments: " << timer);
-  } else {
-    RCLCPP_INFO_STREAM(get_logger(), "on_line_segments: " << timer);
+    RCLCPP_WARN_STREAM(get_logger(), "correct: " << timer);
   }
 
   // Publish status as string
@@ -231,6 +317,7 @@ void CameraParticleCorrector::on_line_segments(const PointCloud2 & line_segments
     ss << "-- Camera particle corrector --" << std::endl;
     ss << (enable_switch_ ? "ENABLED" : "disabled") << std::endl;
     ss << "time: " << timer << std::endl;
+    ss << "scored: " << static_cast<int>(last_scored_fraction_ * 100) << "%" << std::endl;
     msg.data = ss.str();
     pub_string_->publish(msg);
   }
@@ -260,60 +347,79 @@ float abs_cos(const Eigen::Vector3f & t, float deg)
   return std::abs(x.dot(y));
 }
 
-float CameraParticleCorrector::compute_logit(
-  const LineSegments & line_segments_cloud, const Eigen::Vector3f & self_position)
+float CameraParticleCorrector::score_particles(
+  const std::vector<ScoringSample> & samples, ParticleArray & particles,
+  const common::Timer & timer)
+{
+  // The deadline is checked every this number of samples
+  constexpr size_t CHUNK_SIZE = 256;
+
+  std::vector<Sophus::SE3f> transforms;
+  transforms.reserve(particles.particles.size());
+  for (const auto & particle : particles.particles) {
+    transforms.push_back(common::pose_to_se3(particle.pose));
+  }
+
+  float total_gain = 0;
+  for (const ScoringSample & sample : samples) total_gain += sample.gain;
+
+  std::vector<float> logits(particles.particles.size(), 0.f);
+  float scored_gain = 0;
+  for (size_t begin = 0; begin < samples.size(); begin += CHUNK_SIZE) {
+    const size_t end = std::min(begin + CHUNK_SIZE, samples.size());
+    for (size_t i = 0; i < transforms.size(); ++i) {
+      logits[i] += compute_logit(samples, begin, end, transforms[i], cost_map_);
+    }
+    for (size_t j = begin; j < end; ++j) scored_gain += samples[j].gain;
+
+    if (scoring_time_budget_ > 0 && timer.milli_seconds() > scoring_time_budget_) break;
+  }
+
+  // Normalize so that the weights keep the same sharpness even if scoring was cut off
+  const float fraction = (total_gain > 0) ? (scored_gain / total_gain) : 1.0f;
+  for (size_t i = 0; i < logits.size(); ++i) {
+    particles.particles[i].weight = logit_to_prob(logits[i] / std::max(fraction, 1e-3f), 0.01f);
+  }
+  return fraction;
+}
+
+float compute_logit(
+  const std::vector<ScoringSample> & samples, size_t begin, size_t end,
+  const Sophus::SE3f & transform, HierarchicalCostMap & cost_map)
 {
   float logit = 0;
-  for (const LineSegment & pn : line_segments_cloud) {
-    const Eigen::Vector3f tangent = (pn.getNormalVector3fMap() - pn.getVector3fMap()).normalized();
-    const float length = (pn.getVector3fMap() - pn.getNormalVector3fMap()).norm();
-
-    for (float distance = 0; distance < length; distance += 0.1f) {
-      Eigen::Vector3f p = pn.getVector3fMap() + tangent * distance;
-
-      // NOTE: Close points are prioritized
-      float squared_norm = (p - self_position).topRows(2).squaredNorm();
-      float gain = exp(-far_weight_gain_ * squared_norm);  // 0 < gain < 1
-
-      const CostMapValue v3 = cost_map_.at(p.topRows(2));
-
-      if (v3.unmapped) {
-        // logit does not change if target pixel is unmapped
-        continue;
-      }
-      if (pn.label == 0) {  // posteriori
-        logit += 0.2f * gain * (abs_cos(tangent, v3.angle) * v3.intensity - 0.5f);
-      } else {  // apriori
-        logit += gain * (abs_cos(tangent, v3.angle) * v3.intensity - 0.5f);
-      }
+  for (size_t j = begin; j < end; ++j) {
+    const ScoringSample & sample = samples[j];
+    const Eigen::Vector3f p = transform * sample.position;
+
+    const CostMapValue v3 = cost_map.at(p.topRows(2));
+    if (v3.unmapped) {
+      // logit does not change if target pixel is unmapped
+      continue;
     }
+
+    const Eigen::Vector3f tangent = transform.so3() * sample.tangent;
+    logit += sample.gain * (abs_cos(tangent, v3.angle) * v3.intensity - 0.5f);
   }
   return logit;
 }
 
 pcl::PointCloud<pcl::PointXYZI> CameraParticleCorrector::evaluate_cloud(
-  const LineSegments & line_segments_cloud, const Eigen::Vector3f & self_position)
+  const std::vector<ScoringSample> & samples, const Sophus::SE3f & transform, bool reliable)
 {
   pcl::PointCloud<pcl::PointXYZI> cloud;
-  for (const LineSegment & pn : line_segments_cloud) {
-    Eigen::Vector3f tangent = (pn.getNormalVector3fMap() - pn.getVector3fMap()).normalized();
-    float length = (pn.getVector3fMap() - pn.getNormalVector3fMap()).norm();
-
-    for (float distance = 0; distance < length; distance += 0.1f) {
-      Eigen::Vector3f p = pn.getVector3fMap() + tangent * distance;
-
-      // NOTE: Close points are prioritized
-      float squared_norm = (p - self_position).topRows(2).squaredNorm();
-      float gain = std::exp(-far_weight_gain_ * squared_norm);
-
-      CostMapValue v3 = cost_map_.at(p.topRows(2));
-      float logit = 0;
-      if (!v3.unmapped) logit = gain * (abs_cos(tangent, v3.angle) * v3.intensity - 0.5f);
-
-      pcl::PointXYZI xyzi(logit_to_prob(logit, 10.f));
-      xyzi.getVector3fMap() = p;
-      cloud.push_back(xyzi);
-    }
+  for (const ScoringSample & sample : samples) {
+    if (sample.reliable != reliable) continue;
+    const Eigen::Vector3f p = transform * sample.position;
+    const Eigen::Vector3f tangent = transform.so3() * sample.tangent;
+
+    CostMapValue v3 = cost_map_.at(p.topRows(2));
+    float logit = 0;
+    if (!v3.unmapped) logit = sample.gain * (abs_cos(tangent, v3.angle) * v3.intensity - 0.5f);
+
+    pcl::PointXYZI xyzi(logit_to_prob(logit, 10.f));
+    xyzi.getVector3fMap() = p;
+    cloud.push_back(xyzi);
   }
   return cloud;
 }
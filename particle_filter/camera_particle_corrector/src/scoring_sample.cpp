@@ -0,0 +1,177 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "camera_particle_corrector/scoring_sample.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <optional>
+
+namespace yabloc::modularized_particle_filter
+{
+namespace
+{
+// 3 deg
+constexpr float MERGE_ANGLE_TOLERANCE = 3.f * M_PI / 180.f;
+// cos(MERGE_ANGLE_TOLERANCE)
+constexpr float MERGE_COS_TOLERANCE = 0.9986f;
+// Segments are bucketed by their direction in [0, pi). A bucket is not narrower than the
+// tolerance, so only the same and the adjacent buckets can hold mergeable segments.
+constexpr int MERGE_ANGLE_BUCKETS = static_cast<int>(M_PI / MERGE_ANGLE_TOLERANCE);
+// [m]
+constexpr float MERGE_DISTANCE_TOLERANCE = 0.05f;
+// [m]
+constexpr float MERGE_GAP_TOLERANCE = 0.1f;
+
+using LineSegment = ScoringSamplePlanner::LineSegment;
+
+std::optional<LineSegment> try_merge(const LineSegment & a, const LineSegment & b)
+{
+  if (a.label != b.label) return std::nullopt;
+
+  const Eigen::Vector3f & a1 = a.from, & a2 = a.to;
+  const Eigen::Vector3f & b1 = b.from, & b2 = b.to;
+
+  const float length_a = (a2 - a1).norm();
+  const float length_b = (b2 - b1).norm();
+  if (length_a < 1e-3f || length_b < 1e-3f) return std::nullopt;
+
+  const Eigen::Vector3f d = (a2 - a1) / length_a;
+  if (std::abs(d.dot((b2 - b1) / length_b)) < MERGE_COS_TOLERANCE) return std::nullopt;
+
+  // Distance from the line of a
+  auto distance = [&](const Eigen::Vector3f & p) -> float {
+    const Eigen::Vector3f v = p - a1;
+    return (v - d.dot(v) * d).norm();
+  };
+  if (distance(b1) > MERGE_DISTANCE_TOLERANCE) return std::nullopt;
+  if (distance(b2) > MERGE_DISTANCE_TOLERANCE) return std::nullopt;
+
+  // Position of each end point along a
+  const float t[4] = {0.f, length_a, d.dot(b1 - a1), d.dot(b2 - a1)};
+  const Eigen::Vector3f p[4] = {a1, a2, b1, b2};
+  const float gap = std::max(std::min(t[2], t[3]) - length_a, -std::max(t[2], t[3]));
+  if (gap > MERGE_GAP_TOLERANCE) return std::nullopt;
+
+  const int first = std::min_element(t, t + 4) - t;
+  const int last = std::max_element(t, t + 4) - t;
+  return LineSegment{p[first], p[last], a.label};
+}
+}  // namespace
+
+ScoringSamplePlanner::ScoringSamplePlanner(
+  float far_weight_gain, float min_spacing, float max_spacing, int max_samples,
+  bool merge_collinear)
+: far_weight_gain_(far_weight_gain),
+  min_spacing_(std::max(min_spacing, 0.01f)),
+  max_spacing_(std::max(max_spacing, min_spacing_)),
+  max_samples_(max_samples),
+  merge_collinear_(merge_collinear)
+{
+}
+
+float ScoringSamplePlanner::distance_gain(const Eigen::Vector3f & p) const
+{
+  // NOTE: The horizontal distance from a particle is the same as the one from base_link as long
+  // as the particle does not roll or pitch much.
+  return std::exp(-far_weight_gain_ * p.topRows(2).squaredNorm());
+}
+
+float ScoringSamplePlanner::spacing_at(const Eigen::Vector3f & p) const
+{
+  // The weight of each sample, gain * spacing, is kept around min_spacing
+  const float gain = std::max(distance_gain(p), 1e-6f);
+  return std::clamp(min_spacing_ / gain, min_spacing_, max_spacing_);
+}
+
+size_t ScoringSamplePlanner::sample_segment(
+  const LineSegment & segment, float scale, std::vector<ScoringSample> * samples) const
+{
+  const Eigen::Vector3f & from = segment.from;
+  const Eigen::Vector3f tangent = (segment.to - from).normalized();
+  const float length = (segment.to - from).norm();
+  const float label_weight = (segment.label == 0) ? 0.2f : 1.0f;
+
+  size_t count = 0;
+  for (float distance = 0; distance < length;) {
+    const Eigen::Vector3f p = from + tangent * distance;
+    const float spacing = spacing_at(p) * scale;
+    if (samples) {
+      const float weight = label_weight * spacing / REFERENCE_SPACING;
+      samples->push_back({p, tangent, weight * distance_gain(p), segment.label != 0});
+    }
+    distance += spacing;
+    count++;
+  }
+  return count;
+}
+
+ScoringSamplePlanner::LineSegments ScoringSamplePlanner::merge_collinear_segments(
+  const LineSegments & line_segments) const
+{
+  const float bucket_width = M_PI / MERGE_ANGLE_BUCKETS;
+  std::vector<std::vector<size_t>> buckets(MERGE_ANGLE_BUCKETS);
+  std::vector<int> bucket_of(line_segments.size());
+  for (size_t i = 0; i < line_segments.size(); ++i) {
+    // Segments are on the ground, so their horizontal direction is enough
+    const Eigen::Vector3f d = line_segments[i].to - line_segments[i].from;
+    float angle = std::atan2(d.y(), d.x());
+    if (angle < 0) angle += M_PI;
+    bucket_of[i] = std::min(static_cast<int>(angle / bucket_width), MERGE_ANGLE_BUCKETS - 1);
+    buckets[bucket_of[i]].push_back(i);
+  }
+
+  LineSegments merged;
+  std::vector<bool> absorbed(line_segments.size(), false);
+  for (size_t i = 0; i < line_segments.size(); ++i) {
+    if (absorbed[i]) continue;
+    LineSegment segment = line_segments[i];
+    for (int offset = -1; offset <= 1; ++offset) {
+      const int bucket = (bucket_of[i] + offset + MERGE_ANGLE_BUCKETS) % MERGE_ANGLE_BUCKETS;
+      for (size_t j : buckets[bucket]) {
+        if (j <= i || absorbed[j]) continue;
+        if (auto opt = try_merge(segment, line_segments[j])) {
+          segment = opt.value();
+          absorbed[j] = true;
+        }
+      }
+    }
+    merged.push_back(segment);
+  }
+  return merged;
+}
+
+std::vector<ScoringSample> ScoringSamplePlanner::plan(const LineSegments & line_segments) const
+{
+  const LineSegments segments =
+    merge_collinear_ ? merge_collinear_segments(line_segments) : line_segments;
+
+  // Widen spacings evenly if the sample set would be too large
+  float scale = 1.0f;
+  if (max_samples_ > 0) {
+    size_t count = 0;
+    for (const auto & segment : segments) count += sample_segment(segment, 1.0f, nullptr);
+    scale = std::max(1.0f, static_cast<float>(count) / max_samples_);
+  }
+
+  std::vector<ScoringSample> samples;
+  for (const auto & segment : segments) sample_segment(segment, scale, &samples);
+
+  // Near samples first. Note that the gain is no longer monotonic with the distance.
+  std::sort(samples.begin(), samples.end(), [](const ScoringSample & a, const ScoringSample & b) {
+    return a.position.topRows(2).squaredNorm() < b.position.topRows(2).squaredNorm();
+  });
+  return samples;
+}
+}  // namespace yabloc::modularized_particle_filter
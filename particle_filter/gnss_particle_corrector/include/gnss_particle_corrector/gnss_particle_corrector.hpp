@@ -16,6 +16,7 @@
 #define GNSS_PARTILCE_CORRECTOR__GNSS_PARTICLE_CORRECTOR_HPP_
 
 #include "gnss_particle_corrector/weight_manager.hpp"
+#include "gnss_particle_corrector/weight_table.hpp"
 
 #include <Eigen/Core>
 #include <modularized_particle_filter/correction/abst_corrector.hpp>
@@ -46,6 +47,8 @@ private:
   const bool ignore_less_than_float_;
   const float mahalanobis_distance_threshold_;
   const WeightManager weight_manager_;
+  const WeightTable fixed_weight_table_;
+  const WeightTable not_fixed_weight_table_;
 
   rclcpp::Subscription<Float32>::SharedPtr height_sub_;
   rclcpp::Subscription<NavPVT>::SharedPtr ublox_sub_;
@@ -55,6 +58,9 @@ private:
   Float32 latest_height_;
   Eigen::Vector3f last_mean_position_;
 
+  // Buffers which are reused for weighting
+  WeightTable::Offsets offsets_;
+
   void on_ublox(const NavPVT::ConstSharedPtr ublox_msg);
   void on_pose(const PoseCovStamped::ConstSharedPtr pose_msg);
 
@@ -65,9 +71,6 @@ private:
     const Eigen::Matrix3f & sigma, const Eigen::Vector3f & meaned_position,
     const Eigen::Vector3f & gnss_position);
 
-  ParticleArray weight_particles(
-    const ParticleArray & predicted_particles, const Eigen::Vector3f & pose, bool is_rtk_fixed);
-
   // unstable feature
   void add_weight_by_orientation(
     ParticleArray & weighted_particles, const Eigen::Vector3f & velocity);
@@ -36,6 +36,13 @@ struct WeightManager
   Parameter for_fixed_;
   Parameter for_not_fixed_;
 
+  WeightManager(const Parameter & for_fixed, const Parameter & for_not_fixed)
+  : for_fixed_(for_fixed), for_not_fixed_(for_not_fixed)
+  {
+    for_fixed_.compute_coeff();
+    for_not_fixed_.compute_coeff();
+  }
+
   WeightManager(rclcpp::Node * node)
   {
     for_fixed_.flat_radius_ = node->declare_parameter("for_fixed/flat_radius", 0.5f);
@@ -0,0 +1,64 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GNSS_PARTILCE_CORRECTOR__WEIGHT_TABLE_HPP_
+#define GNSS_PARTILCE_CORRECTOR__WEIGHT_TABLE_HPP_
+
+#include "gnss_particle_corrector/weight_manager.hpp"
+
+#include <Eigen/Core>
+
+#include <modularized_particle_filter_msgs/msg/particle_array.hpp>
+
+#include <vector>
+
+namespace yabloc::modularized_particle_filter
+{
+// Lookup table of WeightManager::normal_pdf indexed by the squared distance, so that weighting
+// a particle needs neither sqrt nor exp. Values between samples are linearly interpolated.
+class WeightTable
+{
+public:
+  // Offsets of the particles from the GNSS position, laid out as arrays for the kernel.
+  // The caller keeps them so that the buffers are reused across messages.
+  struct Offsets
+  {
+    std::vector<float> dx;
+    std::vector<float> dy;
+  };
+
+  WeightTable(const WeightManager & manager, bool is_rtk_fixed, size_t resolution = 4096);
+
+  float operator()(float squared_distance) const
+  {
+    const float u = squared_distance * inv_step_;
+    if (u >= last_) return table_.back();
+    const size_t i = static_cast<size_t>(u);
+    const float t = u - static_cast<float>(i);
+    return table_[i] + t * (table_[i + 1] - table_[i]);
+  }
+
+  // Overwrite the weights of the particles by their horizontal distances from the GNSS position
+  void weight(
+    modularized_particle_filter_msgs::msg::ParticleArray & particles,
+    const Eigen::Vector3f & gnss_position, Offsets & offsets) const;
+
+private:
+  float inv_step_;
+  float last_;
+  std::vector<float> table_;
+};
+}  // namespace yabloc::modularized_particle_filter
+
+#endif  // GNSS_PARTILCE_CORRECTOR__WEIGHT_TABLE_HPP_
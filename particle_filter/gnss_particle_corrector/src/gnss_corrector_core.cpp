@@ -25,7 +25,9 @@ GnssParticleCorrector::GnssParticleCorrector()
 : AbstCorrector("gnss_particle_corrector"),
   ignore_less_than_float_(declare_parameter<bool>("ignore_less_than_float", true)),
   mahalanobis_distance_threshold_(declare_parameter<float>("mahalanobis_distance_threshold", 20.0)),
-  weight_manager_(this)
+  weight_manager_(this),
+  fixed_weight_table_(weight_manager_, true),
+  not_fixed_weight_table_(weight_manager_, false)
 {
   using std::placeholders::_1;
 
@@ -102,7 +104,7 @@ void GnssParticleCorrector::on_ublox(const NavPVT::ConstSharedPtr ublox_msg)
 void GnssParticleCorrector::process(
   const Eigen::Vector3f & gnss_position, const rclcpp::Time & stamp, const bool is_rtk_fixed)
 {
-  publish_marker(gnss_position, is_rtk_fixed);
+  if (marker_pub_->get_subscription_count() > 0) publish_marker(gnss_position, is_rtk_fixed);
 
   std::optional<ParticleArray> opt_particles = get_synchronized_particle_array(stamp);
 
@@ -113,17 +115,19 @@ void GnssParticleCorrector::process(
       get_logger(), "Timestamp gap between gnss and particles is too large: " << dt.seconds());
   }
 
-  const Eigen::Matrix3f sigma = modularized_particle_filter::std_of_distribution(*opt_particles);
-  const geometry_msgs::msg::Pose meaned_pose = mean_pose(opt_particles.value());
-  const Eigen::Vector3f meaned_position = common::pose_to_affine(meaned_pose).translation();
+  const DistributionStatistics statistics = statistics_of_distribution(*opt_particles);
+  const Eigen::Vector3f meaned_position =
+    common::pose_to_affine(statistics.mean_pose).translation();
 
   // Check validity of GNSS measurement by mahalanobis distance
-  if (!is_gnss_observation_valid(sigma, meaned_position, gnss_position)) {
+  if (!is_gnss_observation_valid(statistics.sigma, meaned_position, gnss_position)) {
     return;
   }
 
-  ParticleArray weighted_particles =
-    weight_particles(opt_particles.value(), gnss_position, is_rtk_fixed);
+  // The synchronized particles are a copy, so they are weighted in place
+  ParticleArray & weighted_particles = opt_particles.value();
+  const WeightTable & table = is_rtk_fixed ? fixed_weight_table_ : not_fixed_weight_table_;
+  table.weight(weighted_particles, gnss_position, offsets_);
 
   // NOTE: Not sure whether the correction using orientation is effective.
   // const Eigen::Vector3f doppler = extract_enu_vel(*ublox_msg);
@@ -133,7 +137,6 @@ void GnssParticleCorrector::process(
   // Compute travel distance from last update position
   // If the distance is too short, skip weighting
   {
-    Eigen::Vector3f meaned_position = common::pose_to_affine(meaned_pose).translation();
     if ((meaned_position - last_mean_position_).squaredNorm() > 1) {
       this->set_weighted_particle_array(weighted_particles);
       last_mean_position_ = meaned_position;
@@ -182,20 +185,6 @@ void GnssParticleCorrector::publish_marker(const Eigen::Vector3f & position, boo
   marker_pub_->publish(array_msg);
 }
 
-GnssParticleCorrector::ParticleArray GnssParticleCorrector::weight_particles(
-  const ParticleArray & predicted_particles, const Eigen::Vector3f & pose, bool is_rtk_fixed)
-{
-  ParticleArray weighted_particles{predicted_particles};
-
-  for (auto & particle : weighted_particles.particles) {
-    float distance = static_cast<float>(
-      std::hypot(particle.pose.position.x - pose.x(), particle.pose.position.y - pose.y()));
-    particle.weight = weight_manager_.normal_pdf(distance, is_rtk_fixed);
-  }
-
-  return weighted_particles;
-}
-
 void GnssParticleCorrector::add_weight_by_orientation(
   ParticleArray & weighted_particles, const Eigen::Vector3f & velocity)
 {
@@ -0,0 +1,58 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gnss_particle_corrector/weight_table.hpp"
+
+#include <cmath>
+
+namespace yabloc::modularized_particle_filter
+{
+WeightTable::WeightTable(const WeightManager & manager, bool is_rtk_fixed, size_t resolution)
+{
+  const WeightManager::Parameter & param =
+    is_rtk_fixed ? manager.for_fixed_ : manager.for_not_fixed_;
+
+  // The weight is constant beyond this distance
+  const float max_distance = param.flat_radius_ + param.max_radius_;
+  const float max_squared_distance = max_distance * max_distance;
+  inv_step_ = static_cast<float>(resolution) / max_squared_distance;
+  last_ = static_cast<float>(resolution);
+
+  table_.resize(resolution + 1);
+  for (size_t i = 0; i <= resolution; ++i) {
+    table_[i] = manager.normal_pdf(std::sqrt(static_cast<float>(i) / inv_step_), param);
+  }
+}
+
+void WeightTable::weight(
+  modularized_particle_filter_msgs::msg::ParticleArray & particles,
+  const Eigen::Vector3f & gnss_position, Offsets & offsets) const
+{
+  const size_t count = particles.particles.size();
+  offsets.dx.resize(count);
+  offsets.dy.resize(count);
+  float * dx = offsets.dx.data();
+  float * dy = offsets.dy.data();
+  for (size_t i = 0; i < count; ++i) {
+    const auto & position = particles.particles[i].pose.position;
+    dx[i] = static_cast<float>(position.x - gnss_position.x());
+    dy[i] = static_cast<float>(position.y - gnss_position.y());
+  }
+
+  // The squared distances overwrite dx in a loop which the compiler vectorizes
+  for (size_t i = 0; i < count; ++i) dx[i] = dx[i] * dx[i] + dy[i] * dy[i];
+
+  for (size_t i = 0; i < count; ++i) particles.particles[i].weight = (*this)(dx[i]);
+}
+}  // namespace yabloc::modularized_particle_filter
@@ -0,0 +1,86 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gnss_particle_corrector/weight_table.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+namespace mpf = yabloc::modularized_particle_filter;
+using Parameter = mpf::WeightManager::Parameter;
+
+// Defaults of the node
+mpf::WeightManager make_weight_manager()
+{
+  Parameter for_fixed;
+  for_fixed.flat_radius_ = 0.5f;
+  for_fixed.max_radius_ = 10.0f;
+  for_fixed.min_weight_ = 0.5f;
+  for_fixed.max_weight_ = 1.5f;
+
+  Parameter for_not_fixed;
+  for_not_fixed.flat_radius_ = 5.0f;
+  for_not_fixed.max_radius_ = 20.0f;
+  for_not_fixed.min_weight_ = 0.5f;
+  for_not_fixed.max_weight_ = 1.0f;
+  return mpf::WeightManager(for_fixed, for_not_fixed);
+}
+
+class WeightTableTestSuite : public ::testing::TestWithParam<bool>
+{
+};
+
+TEST_P(WeightTableTestSuite, maxError)
+{
+  const bool is_rtk_fixed = GetParam();
+  const mpf::WeightManager manager = make_weight_manager();
+  const mpf::WeightTable table(manager, is_rtk_fixed);
+
+  // The distances run beyond the end of the table, where the weight is constant
+  float max_error = 0;
+  for (float distance = 0; distance < 40; distance += 0.001f) {
+    const float expected = manager.normal_pdf(distance, is_rtk_fixed);
+    max_error = std::max(max_error, std::abs(table(distance * distance) - expected));
+  }
+  EXPECT_LT(max_error, 1e-4f);
+}
+
+TEST_P(WeightTableTestSuite, weightParticles)
+{
+  const bool is_rtk_fixed = GetParam();
+  const mpf::WeightManager manager = make_weight_manager();
+  const mpf::WeightTable table(manager, is_rtk_fixed);
+
+  const Eigen::Vector3f gnss_position(81000, 50000, 40);
+  modularized_particle_filter_msgs::msg::ParticleArray particles;
+  particles.particles.resize(100);
+  for (size_t i = 0; i < particles.particles.size(); ++i) {
+    auto & pose = particles.particles[i].pose;
+    pose.position.x = gnss_position.x() + 0.3 * i;
+    pose.position.y = gnss_position.y() - 0.1 * i;
+    // The height does not affect the weight
+    pose.position.z = 1000;
+  }
+
+  mpf::WeightTable::Offsets offsets;
+  table.weight(particles, gnss_position, offsets);
+  for (size_t i = 0; i < particles.particles.size(); ++i) {
+    const float distance = std::hypot(0.3f * i, 0.1f * i);
+    EXPECT_NEAR(particles.particles[i].weight, manager.normal_pdf(distance, is_rtk_fixed), 1e-4f);
+  }
+}
+
+// RTK fixed and not fixed
+INSTANTIATE_TEST_SUITE_P(RtkFixed, WeightTableTestSuite, ::testing::Bool());
@@ -13,11 +13,14 @@
 // limitations under the License.
 
 #pragma once
+#include "ll2_cost_map/map_tile_cache.hpp"
+
 #include <Eigen/StdVector>
 #include <opencv4/opencv2/core.hpp>
 #include <rclcpp/node.hpp>
 #include <yabloc_common/gamma_converter.hpp>
 
+#include <map_tile_msgs/srv/get_map_tiles.hpp>
 #include <visualization_msgs/msg/marker_array.hpp>
 
 #include <boost/functional/hash.hpp>
@@ -89,6 +92,7 @@ public:
   using Marker = visualization_msgs::msg::Marker;
   using MarkerArray = visualization_msgs::msg::MarkerArray;
   using Pose = geometry_msgs::msg::Pose;
+  using GetMapTiles = map_tile_msgs::srv::GetMapTiles;
 
   using BgPoint = boost::geometry::model::d2::point_xy<double>;
   using BgPolygon = boost::geometry::model::polygon<BgPoint>;
@@ -114,13 +118,30 @@ public:
 
   void set_height(float height);
 
+  // If map tiles are used, the road markings are not given by set_cloud() but requested from
+  // the map tile service around the position
+  bool use_map_tiles() const { return use_map_tiles_; }
+  void request_tiles(const Eigen::Vector2f & position);
+
 private:
   const float max_range_;
   const float image_size_;
   const size_t max_map_count_;
   rclcpp::Logger logger_;
+  rclcpp::Clock::SharedPtr clock_;
   std::optional<float> height_{std::nullopt};
 
+  const bool use_map_tiles_;
+  const float tile_radius_;
+  // A request without a response for this duration [s] is regarded as lost and sent again
+  const double tile_request_timeout_;
+  rclcpp::Client<GetMapTiles>::SharedPtr tile_client_{nullptr};
+  MapTileCache tile_cache_;
+  // The request in flight, which is identified by its sequence number
+  std::optional<int64_t> tile_request_id_{std::nullopt};
+  rclcpp::Time tile_request_stamp_;
+  std::optional<Eigen::Vector2f> last_tile_request_position_{std::nullopt};
+
   common::GammaConverter gamma_converter{4.0f};
 
   std::unordered_map<Area, bool, Area> map_accessed_;
@@ -134,5 +155,7 @@ private:
   void build_map(const Area & area);
 
   cv::Mat create_available_area_image(const Area & area) const;
+
+  void on_tiles(rclcpp::Client<GetMapTiles>::SharedFuture future);
 };
 }  // namespace yabloc
\ No newline at end of file
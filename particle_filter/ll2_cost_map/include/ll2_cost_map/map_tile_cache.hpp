@@ -0,0 +1,67 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <Eigen/Core>
+#include <ll2_decomposer/map_tiler.hpp>
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+namespace yabloc
+{
+// Holds map tiles around the current position.
+// When it holds more than the capacity, the least recently used tiles are evicted.
+class MapTileCache
+{
+public:
+  using TileIndex = ll2_decomposer::TileIndex;
+  using Segments = pcl::PointCloud<pcl::PointNormal>;
+
+  explicit MapTileCache(size_t max_tile_count);
+
+  void set_tile_size(float tile_size) { tile_size_ = tile_size; }
+  float tile_size() const { return tile_size_; }
+
+  void insert(const TileIndex & index, Segments && segments);
+
+  // Mark the tile as recently used. Return false if it is not held.
+  bool touch(const TileIndex & index);
+
+  // Concatenated segments of the held tiles which intersect [min, max].
+  // A segment lying across a tile border appears once per tile.
+  Segments collect(const Eigen::Vector2f & min, const Eigen::Vector2f & max) const;
+
+  std::vector<TileIndex> held_tiles() const;
+
+  bool empty() const { return tiles_.empty(); }
+
+private:
+  const size_t max_tile_count_;
+  float tile_size_{0};
+
+  // The front is the most recently used
+  std::list<TileIndex> usage_;
+  struct Entry
+  {
+    Segments segments;
+    std::list<TileIndex>::iterator usage;
+  };
+  std::unordered_map<TileIndex, Entry, TileIndex::Hash> tiles_;
+};
+}  // namespace yabloc
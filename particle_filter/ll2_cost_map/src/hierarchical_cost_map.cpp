@@ -22,6 +22,8 @@
 
 #include <boost/geometry/geometry.hpp>
 
+#include <pcl_conversions/pcl_conversions.h>
+
 namespace yabloc
 {
 float Area::unit_length_ = -1;
@@ -30,11 +32,20 @@ HierarchicalCostMap::HierarchicalCostMap(rclcpp::Node * node)
 : max_range_(node->declare_parameter<float>("max_range", 40.0)),
   image_size_(node->declare_parameter<int>("image_size", 800)),
   max_map_count_(10),
-  logger_(node->get_logger())
+  logger_(node->get_logger()),
+  clock_(node->get_clock()),
+  use_map_tiles_(node->declare_parameter<bool>("use_map_tiles", false)),
+  tile_radius_(node->declare_parameter<float>("map_tile_radius", 150.0)),
+  tile_request_timeout_(node->declare_parameter<double>("map_tile_request_timeout", 5.0)),
+  tile_cache_(node->declare_parameter<int>("max_map_tile_count", 36))
 {
   Area::unit_length_ = max_range_;
   float gamma = node->declare_parameter<float>("gamma", 5.0);
   gamma_converter.reset(gamma);
+
+  if (use_map_tiles_) {
+    tile_client_ = node->create_client<GetMapTiles>("ll2_road_marking_tiles");
+  }
 }
 
 cv::Point2i HierarchicalCostMap::to_cv_point(const Area & area, const Eigen::Vector2f p) const
@@ -47,7 +58,7 @@ cv::Point2i HierarchicalCostMap::to_cv_point(const Area & area, const Eigen::Vec
 
 CostMapValue HierarchicalCostMap::at(const Eigen::Vector2f & position)
 {
-  if (!cloud_.has_value()) {
+  if (!cloud_.has_value() && tile_cache_.empty()) {
     return CostMapValue{0.5f, 0, true};
   }
 
@@ -99,9 +110,106 @@ void HierarchicalCostMap::set_cloud(const pcl::PointCloud<pcl::PointNormal> & cl
   cloud_ = cloud;
 }
 
+void HierarchicalCostMap::request_tiles(const Eigen::Vector2f & position)
+{
+  if (!use_map_tiles_) return;
+
+  // Keep the tiles around the position from being evicted
+  const float tile_size = tile_cache_.tile_size();
+  if (tile_size > 0) {
+    auto to_index = [tile_size](float v) -> int32_t {
+      return static_cast<int32_t>(std::floor(v / tile_size));
+    };
+    const Eigen::Vector2f min = position.array() - tile_radius_;
+    const Eigen::Vector2f max = position.array() + tile_radius_;
+    for (int32_t x = to_index(min.x()); x <= to_index(max.x()); ++x) {
+      for (int32_t y = to_index(min.y()); y <= to_index(max.y()); ++y) tile_cache_.touch({x, y});
+    }
+  }
+
+  if (tile_request_id_) {
+    if ((clock_->now() - tile_request_stamp_).seconds() < tile_request_timeout_) return;
+    // The response was lost, e.g. the server restarted, so the request is given up and the
+    // tiles are requested again without waiting for movement
+    RCLCPP_WARN_STREAM(logger_, "map tile request timed out");
+    tile_client_->remove_pending_request(*tile_request_id_);
+    tile_request_id_ = std::nullopt;
+    last_tile_request_position_ = std::nullopt;
+  }
+
+  // Tiles are requested again only after moving a quarter of a tile
+  if (last_tile_request_position_) {
+    if ((position - *last_tile_request_position_).norm() < tile_size / 4) return;
+  }
+  if (!tile_client_->service_is_ready()) {
+    RCLCPP_WARN_STREAM_THROTTLE(logger_, *clock_, 5000, "map tile service is not ready");
+    return;
+  }
+
+  auto request = std::make_shared<GetMapTiles::Request>();
+  request->center.x = position.x();
+  request->center.y = position.y();
+  request->radius = tile_radius_;
+  for (const MapTileCache::TileIndex & index : tile_cache_.held_tiles()) {
+    request->held_x.push_back(index.x);
+    request->held_y.push_back(index.y);
+  }
+
+  last_tile_request_position_ = position;
+  auto on_tiles = std::bind(&HierarchicalCostMap::on_tiles, this, std::placeholders::_1);
+  tile_request_id_ = tile_client_->async_send_request(request, on_tiles).request_id;
+  tile_request_stamp_ = clock_->now();
+}
+
+void HierarchicalCostMap::on_tiles(rclcpp::Client<GetMapTiles>::SharedFuture future)
+{
+  tile_request_id_ = std::nullopt;
+  const auto response = future.get();
+  tile_cache_.set_tile_size(response->tile_size);
+  if (response->tiles.empty()) {
+    // The map may not be decomposed yet, so retry without waiting for movement
+    if (tile_cache_.empty()) last_tile_request_position_ = std::nullopt;
+    return;
+  }
+
+  const float tile_size = response->tile_size;
+  for (const auto & tile : response->tiles) {
+    MapTileCache::Segments segments;
+    pcl::fromROSMsg(tile.cloud, segments);
+    tile_cache_.insert({tile.x, tile.y}, std::move(segments));
+
+    // Cost maps which were built before the tile arrived have to be rebuilt
+    const Eigen::Vector2f tile_min(tile.x * tile_size, tile.y * tile_size);
+    const Eigen::Vector2f tile_max = tile_min + Eigen::Vector2f(tile_size, tile_size);
+    for (auto itr = generated_map_history_.begin(); itr != generated_map_history_.end();) {
+      const auto boundary = itr->real_scale_boundary();
+      const bool overlapped = (boundary[0].array() < tile_max.array()).all() &&
+                              (tile_min.array() < boundary[1].array()).all();
+      if (!overlapped) {
+        ++itr;
+        continue;
+      }
+      cost_maps_.erase(*itr);
+      map_accessed_.erase(*itr);
+      itr = generated_map_history_.erase(itr);
+    }
+  }
+  RCLCPP_INFO_STREAM(
+    logger_, "received " << response->tiles.size() << " map tiles and holds "
+                         << tile_cache_.held_tiles().size() << " tiles");
+}
+
 void HierarchicalCostMap::build_map(const Area & area)
 {
-  if (!cloud_.has_value()) return;
+  if (!cloud_.has_value() && tile_cache_.empty()) return;
+
+  // With map tiles, only the segments of the tiles around the area are drawn
+  std::optional<pcl::PointCloud<pcl::PointNormal>> tile_segments;
+  if (use_map_tiles_) {
+    const auto boundary = area.real_scale_boundary();
+    tile_segments = tile_cache_.collect(boundary[0], boundary[1]);
+  }
+  const auto & segments = tile_segments ? tile_segments.value() : cloud_.value();
 
   cv::Mat image = 255 * cv::Mat::ones(cv::Size(image_size_, image_size_), CV_8UC1);
   cv::Mat orientation = cv::Mat::zeros(cv::Size(image_size_, image_size_), CV_8UC1);
@@ -111,7 +219,7 @@ void HierarchicalCostMap::build_map(const Area & area)
   };
 
   // TODO: We can speed up by skipping too far line_segments
-  for (const auto pn : cloud_.value()) {
+  for (const auto pn : segments) {
     if (height_) {
       if (std::abs(pn.z - *height_) > 4) continue;
       if (std::abs(pn.normal_z - *height_) > 4) continue;
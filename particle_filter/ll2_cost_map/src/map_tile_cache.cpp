@@ -0,0 +1,74 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ll2_cost_map/map_tile_cache.hpp"
+
+#include <cmath>
+
+namespace yabloc
+{
+MapTileCache::MapTileCache(size_t max_tile_count) : max_tile_count_(max_tile_count) {}
+
+void MapTileCache::insert(const TileIndex & index, Segments && segments)
+{
+  if (touch(index)) {
+    tiles_.at(index).segments = std::move(segments);
+    return;
+  }
+
+  usage_.push_front(index);
+  tiles_.emplace(index, Entry{std::move(segments), usage_.begin()});
+
+  while (tiles_.size() > max_tile_count_) {
+    tiles_.erase(usage_.back());
+    usage_.pop_back();
+  }
+}
+
+bool MapTileCache::touch(const TileIndex & index)
+{
+  auto itr = tiles_.find(index);
+  if (itr == tiles_.end()) return false;
+  usage_.splice(usage_.begin(), usage_, itr->second.usage);
+  return true;
+}
+
+MapTileCache::Segments MapTileCache::collect(
+  const Eigen::Vector2f & min, const Eigen::Vector2f & max) const
+{
+  Segments segments;
+  if (tile_size_ <= 0) return segments;
+
+  auto to_index = [this](float v) -> int32_t {
+    return static_cast<int32_t>(std::floor(v / tile_size_));
+  };
+  for (int32_t x = to_index(min.x()); x <= to_index(max.x()); ++x) {
+    for (int32_t y = to_index(min.y()); y <= to_index(max.y()); ++y) {
+      auto itr = tiles_.find({x, y});
+      if (itr == tiles_.end()) continue;
+      segments.points.insert(
+        segments.points.end(), itr->second.segments.points.begin(),
+        itr->second.segments.points.end());
+    }
+  }
+  segments.width = segments.points.size();
+  segments.height = 1;
+  return segments;
+}
+
+std::vector<MapTileCache::TileIndex> MapTileCache::held_tiles() const
+{
+  return {usage_.begin(), usage_.end()};
+}
+}  // namespace yabloc
@@ -30,6 +30,16 @@ geometry_msgs::msg::Pose mean_pose(
 Eigen::Matrix3f std_of_distribution(
   const modularized_particle_filter_msgs::msg::ParticleArray & particle_array);
 
+struct DistributionStatistics
+{
+  geometry_msgs::msg::Pose mean_pose;
+  Eigen::Matrix3f sigma;
+};
+
+// Equivalent to mean_pose() and std_of_distribution(), but the particles are visited only once
+DistributionStatistics statistics_of_distribution(
+  const modularized_particle_filter_msgs::msg::ParticleArray & particle_array);
+
 float std_of_weight(const modularized_particle_filter_msgs::msg::ParticleArray & particle_array);
 }  // namespace modularized_particle_filter
 }  // namespace yabloc
@@ -34,7 +34,8 @@ public:
   using Particle = modularized_particle_filter_msgs::msg::Particle;
   using ParticleArray = modularized_particle_filter_msgs::msg::ParticleArray;
 
-  AbstCorrector(const std::string & node_name);
+  AbstCorrector(
+    const std::string & node_name, const rclcpp::NodeOptions & options = rclcpp::NodeOptions());
 
 protected:
   const float acceptable_max_delay_;  // [sec]
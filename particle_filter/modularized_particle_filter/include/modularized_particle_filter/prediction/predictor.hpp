@@ -20,6 +20,8 @@
 #include "modularized_particle_filter/prediction/resampler.hpp"
 
 #include <rclcpp/rclcpp.hpp>
+#include <yabloc_common/stage_stamp_publisher.hpp>
+#include <yabloc_common/trace_reporter.hpp>
 
 #include <geometry_msgs/msg/pose_stamped.hpp>
 #include <geometry_msgs/msg/pose_with_covariance_stamped.hpp>
@@ -41,7 +43,7 @@ public:
   using TwistCovStamped = geometry_msgs::msg::TwistWithCovarianceStamped;
   using TwistStamped = geometry_msgs::msg::TwistStamped;
 
-  Predictor();
+  explicit Predictor(const rclcpp::NodeOptions & options = rclcpp::NodeOptions());
 
 private:
   // The number of particles of particle filter
@@ -79,6 +81,9 @@ private:
   std::unique_ptr<RetroactiveResampler> resampler_ptr_{nullptr};
   std::unique_ptr<SwapModeAdaptor> swap_mode_adaptor_ptr_{nullptr};
 
+  common::TraceReporter trace_reporter_{this};
+  common::StageStampPublisher stage_stamp_{this, "predictor"};
+
   // Callback
   void on_initial_pose(const PoseCovStamped::ConstSharedPtr initialpose);
   void on_twist_cov(const TwistCovStamped::ConstSharedPtr twist);
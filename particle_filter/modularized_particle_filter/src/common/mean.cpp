@@ -91,27 +91,70 @@ geometry_msgs::msg::Pose mean_pose(
 
 Eigen::Matrix3f std_of_distribution(
   const modularized_particle_filter_msgs::msg::ParticleArray & array)
+{
+  return statistics_of_distribution(array).sigma;
+}
+
+DistributionStatistics statistics_of_distribution(
+  const modularized_particle_filter_msgs::msg::ParticleArray & array)
 {
   using Particle = modularized_particle_filter_msgs::msg::Particle;
-  auto ori = mean_pose(array).orientation;
-  Eigen::Quaternionf orientation(ori.w, ori.x, ori.y, ori.z);
-  float invN = 1.f / array.particles.size();
-  Eigen::Vector3f mean = Eigen::Vector3f::Zero();
-  for (const Particle & p : array.particles) {
-    Eigen::Affine3f affine = common::pose_to_affine(p.pose);
-    mean += affine.translation();
+
+  // Positions are accumulated relative to a particle so that the moments keep precision
+  Eigen::Vector3d origin = Eigen::Vector3d::Zero();
+  if (!array.particles.empty()) {
+    const auto & p = array.particles.front().pose.position;
+    origin = Eigen::Vector3d(p.x, p.y, p.z);
   }
-  mean *= invN;
 
-  Eigen::Matrix3f sigma = Eigen::Matrix3f::Zero();
-  for (const Particle & p : array.particles) {
-    Eigen::Affine3f affine = common::pose_to_affine(p.pose);
-    Eigen::Vector3f d = affine.translation() - mean;
-    d = orientation.conjugate() * d;
-    sigma += (d * d.transpose()) * invN;
+  // Weighted sums for the mean pose, and unweighted moments for the covariance
+  double sum_weight = 0;
+  Eigen::Vector3d weighted_position = Eigen::Vector3d::Zero();
+  std::complex<double> roll_sum{}, pitch_sum{}, yaw_sum{};
+  Eigen::Vector3d sum = Eigen::Vector3d::Zero();
+  Eigen::Matrix3d sum_outer = Eigen::Matrix3d::Zero();
+
+  for (const Particle & particle : array.particles) {
+    const auto & p = particle.pose.position;
+    const Eigen::Vector3d position = Eigen::Vector3d(p.x, p.y, p.z) - origin;
+    const double weight = particle.weight;
+    sum_weight += weight;
+    weighted_position += weight * position;
+
+    double yaw{0.0}, pitch{0.0}, roll{0.0};
+    tf2::getEulerYPR(particle.pose.orientation, yaw, pitch, roll);
+    roll_sum += weight * std::polar(1.0, roll);
+    pitch_sum += weight * std::polar(1.0, pitch);
+    yaw_sum += weight * std::polar(1.0, yaw);
+
+    sum += position;
+    sum_outer += position * position.transpose();
+  }
+
+  if (std::isinf(sum_weight)) {
+    RCLCPP_WARN_STREAM(rclcpp::get_logger("meanPose"), "sum_weight: " << sum_weight);
   }
 
-  return sigma;
+  DistributionStatistics statistics;
+  auto & mean_pose = statistics.mean_pose;
+  const Eigen::Vector3d mean_position = origin + weighted_position / sum_weight;
+  mean_pose.position.x = mean_position.x();
+  mean_pose.position.y = mean_position.y();
+  mean_pose.position.z = mean_position.z();
+
+  // The argument of a sum of unit vectors does not depend on the normalization of the weights
+  tf2::Quaternion q;
+  q.setRPY(std::arg(roll_sum), std::arg(pitch_sum), std::arg(yaw_sum));
+  mean_pose.orientation = tf2::toMsg(q);
+
+  // The covariance is expressed in the frame of the mean orientation
+  const double inv_n = 1.0 / static_cast<double>(array.particles.size());
+  const Eigen::Vector3d mean = sum * inv_n;
+  const Eigen::Matrix3d covariance = sum_outer * inv_n - mean * mean.transpose();
+  const Eigen::Matrix3d R =
+    Eigen::Quaterniond(q.w(), q.x(), q.y(), q.z()).normalized().toRotationMatrix();
+  statistics.sigma = (R.transpose() * covariance * R).cast<float>();
+  return statistics;
 }
 
 float std_of_weight(const modularized_particle_filter_msgs::msg::ParticleArray & particle_array)
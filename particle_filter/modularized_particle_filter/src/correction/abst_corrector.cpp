@@ -16,8 +16,8 @@
 
 namespace yabloc::modularized_particle_filter
 {
-AbstCorrector::AbstCorrector(const std::string & node_name)
-: Node(node_name),
+AbstCorrector::AbstCorrector(const std::string & node_name, const rclcpp::NodeOptions & options)
+: Node(node_name, options),
   acceptable_max_delay_(declare_parameter<float>("acceptable_max_delay", 1.0f)),
   visualize_(declare_parameter<bool>("visualize", false)),
   logger_(rclcpp::get_logger("abst_corrector"))
@@ -21,6 +21,7 @@
 #include <Eigen/Core>
 #include <sophus/geometry.hpp>
 #include <yabloc_common/pose_conversions.hpp>
+#include <yabloc_common/trace.hpp>
 
 #include <tf2_geometry_msgs/tf2_geometry_msgs.hpp>
 
@@ -31,8 +32,8 @@
 namespace yabloc::modularized_particle_filter
 {
 
-Predictor::Predictor()
-: Node("predictor"),
+Predictor::Predictor(const rclcpp::NodeOptions & options)
+: Node("predictor", options),
   number_of_particles_(declare_parameter("num_of_particles", 500)),
   resampling_interval_seconds_(declare_parameter("resampling_interval_seconds", 1.0f)),
   static_linear_covariance_(declare_parameter("static_linear_covariance", 0.01)),
@@ -162,6 +163,8 @@ void Predictor::update_with_dynamic_noise(
 
 void Predictor::on_timer()
 {
+  YABLOC_TRACE_SCOPE("predictor/predict");
+
   // ==========================================================================
   // Pre-check section
   // TODO: Refactor
@@ -215,6 +218,9 @@ void Predictor::on_timer()
 
 void Predictor::on_weighted_particles(const ParticleArray::ConstSharedPtr weighted_particles_ptr)
 {
+  YABLOC_TRACE_SCOPE("predictor/weight");
+  const auto start = stage_stamp_.start();
+
   // NOTE: **We need not to check particle_array_opt.has_value().**
   // Since the weighted_particles is generated from messages published from this node,
   // the particle_array must have an entity in this function.
@@ -252,6 +258,7 @@ void Predictor::on_weighted_particles(const ParticleArray::ConstSharedPtr weight
 
   // ==========================================================================
   particle_array_opt_ = particle_array;
+  stage_stamp_.publish(weighted_particles_ptr->header.stamp, particle_array.header.stamp, start);
 }
 
 void Predictor::publish_mean_pose(
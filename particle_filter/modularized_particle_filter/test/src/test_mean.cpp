@@ -0,0 +1,103 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "modularized_particle_filter/common/mean.hpp"
+
+#include <eigen3/Eigen/Geometry>
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+namespace mpf = yabloc::modularized_particle_filter;
+using Particle = modularized_particle_filter_msgs::msg::Particle;
+using ParticleArray = modularized_particle_filter_msgs::msg::ParticleArray;
+
+// Particles around a position far from the origin of the map, like real ones
+ParticleArray make_particles(double yaw_spread, int seed)
+{
+  std::mt19937 engine(seed);
+  std::normal_distribution<double> position(0, 2.0);
+  std::normal_distribution<double> yaw(0.5, yaw_spread);
+  std::uniform_real_distribution<float> weight(0.1f, 1.0f);
+
+  ParticleArray array;
+  array.particles.resize(500);
+  for (Particle & p : array.particles) {
+    p.pose.position.x = 81000 + position(engine);
+    p.pose.position.y = 50000 + 0.5 * position(engine);
+    p.pose.position.z = 40 + 0.1 * position(engine);
+    const Eigen::Quaterniond q(Eigen::AngleAxisd(yaw(engine), Eigen::Vector3d::UnitZ()));
+    p.pose.orientation.w = q.w();
+    p.pose.orientation.x = q.x();
+    p.pose.orientation.y = q.y();
+    p.pose.orientation.z = q.z();
+    p.weight = weight(engine);
+  }
+  return array;
+}
+
+// The two-pass covariance which statistics_of_distribution replaces
+Eigen::Matrix3d two_pass_sigma(const ParticleArray & array)
+{
+  const auto ori = mpf::mean_pose(array).orientation;
+  const Eigen::Quaterniond orientation(ori.w, ori.x, ori.y, ori.z);
+  const double inv_n = 1.0 / array.particles.size();
+
+  Eigen::Vector3d mean = Eigen::Vector3d::Zero();
+  for (const Particle & p : array.particles)
+    mean += Eigen::Vector3d(p.pose.position.x, p.pose.position.y, p.pose.position.z);
+  mean *= inv_n;
+
+  Eigen::Matrix3d sigma = Eigen::Matrix3d::Zero();
+  for (const Particle & p : array.particles) {
+    Eigen::Vector3d d =
+      Eigen::Vector3d(p.pose.position.x, p.pose.position.y, p.pose.position.z) - mean;
+    d = orientation.conjugate() * d;
+    sigma += d * d.transpose() * inv_n;
+  }
+  return sigma;
+}
+
+class MeanTestSuite : public ::testing::TestWithParam<double>
+{
+};
+
+TEST_P(MeanTestSuite, statisticsOfDistribution)
+{
+  const ParticleArray array = make_particles(GetParam(), 0);
+  const mpf::DistributionStatistics statistics = mpf::statistics_of_distribution(array);
+
+  const auto expected = mpf::mean_pose(array);
+  const auto & actual = statistics.mean_pose;
+  EXPECT_NEAR(actual.position.x, expected.position.x, 1e-6);
+  EXPECT_NEAR(actual.position.y, expected.position.y, 1e-6);
+  EXPECT_NEAR(actual.position.z, expected.position.z, 1e-6);
+
+  const Eigen::Quaterniond q_expected(
+    expected.orientation.w, expected.orientation.x, expected.orientation.y,
+    expected.orientation.z);
+  const Eigen::Quaterniond q_actual(
+    actual.orientation.w, actual.orientation.x, actual.orientation.y, actual.orientation.z);
+  EXPECT_NEAR(q_expected.angularDistance(q_actual), 0.0, 1e-6);
+
+  const Eigen::Matrix3d sigma = two_pass_sigma(array);
+  EXPECT_TRUE(statistics.sigma.cast<double>().isApprox(sigma, 1e-4))
+    << statistics.sigma << "\n\n"
+    << sigma;
+  EXPECT_TRUE(mpf::std_of_distribution(array).isApprox(statistics.sigma));
+}
+
+// Narrow and wide spreads of the yaw
+INSTANTIATE_TEST_SUITE_P(YawSpread, MeanTestSuite, ::testing::Values(0.05, 1.0));
@@ -18,7 +18,9 @@
 
 #include <opencv4/opencv2/core.hpp>
 #include <rclcpp/rclcpp.hpp>
+#include <sophus/geometry.hpp>
 #include <std_srvs/srv/set_bool.hpp>
+#include <yabloc_common/line_segments_view.hpp>
 
 #include <geometry_msgs/msg/pose_stamped.hpp>
 #include <geometry_msgs/msg/pose_with_covariance_stamped.hpp>
@@ -38,8 +40,8 @@ float abs_cos(const Eigen::Vector3f & t, float deg);
 class CameraEkfCorrector : public rclcpp::Node
 {
 public:
-  using LineSegment = pcl::PointXYZLNormal;
-  using LineSegments = pcl::PointCloud<LineSegment>;
+  using LineSegment = common::LineSegmentsView::Segment;
+  using LineSegments = std::vector<LineSegment>;
   using PointCloud2 = sensor_msgs::msg::PointCloud2;
   using Image = sensor_msgs::msg::Image;
   using Marker = visualization_msgs::msg::Marker;
@@ -85,20 +87,25 @@ private:
   void on_bounding_box(const PointCloud2 & msg);
   void on_pose_cov(const PoseCovStamped & msg);
 
-  std::pair<LineSegments, LineSegments> split_line_segments(const PointCloud2 & msg);
+  // Return the reliable segments and the a posteriori ones which are consistent with the map.
+  // The view is read in place, and only the selected segments are copied.
+  LineSegments select_line_segments(
+    const common::LineSegmentsView & line_segments, const rclcpp::Time & stamp);
 
-  float compute_logit(const LineSegments & line_segments_cloud, const Eigen::Vector3f & self_position);
+  // Segments are given in base_link and placed at transform on the fly
+  float compute_logit(const LineSegments & line_segments, const Sophus::SE3f & transform);
 
-  std::pair<LineSegments, LineSegments> filt(const LineSegments & lines);
+  // Return true if the a posteriori segment is consistent with the map at the pose
+  bool filt(const LineSegment & iffy_line, const Sophus::SE3f & pose);
   std::optional<PoseCovStamped> get_synchronized_pose(const rclcpp::Time & stamp);
 
   void publish_visualize_markers(const ParticleArray & particles);
 
   PoseCovStamped estimate_pose_with_covariance(
-    const PoseCovStamped & init, const LineSegments & line_segments_cloud,
-    const LineSegments & iffy_line_segments_cloud);
+    const PoseCovStamped & init, const LineSegments & line_segments);
 
+  // Only the reliable segments are evaluated
   pcl::PointCloud<pcl::PointXYZI> evaluate_cloud(
-    const LineSegments & line_segments_cloud, const Eigen::Vector3f & self_position);
+    const LineSegments & line_segments, const Sophus::SE3f & transform);
 };
 }  // namespace yabloc::ekf_corrector
\ No newline at end of file
@@ -19,10 +19,10 @@
 
 #include <opencv4/opencv2/imgproc.hpp>
 #include <yabloc_common/color.hpp>
+#include <yabloc_common/line_segments_view.hpp>
 #include <yabloc_common/pose_conversions.hpp>
 #include <yabloc_common/pub_sub.hpp>
 #include <yabloc_common/timer.hpp>
-#include <yabloc_common/transform_line_segments.hpp>
 
 #include <pcl_conversions/pcl_conversions.h>
 
@@ -76,39 +76,33 @@ void CameraEkfCorrector::on_bounding_box(const PointCloud2 & msg)
   RCLCPP_INFO_STREAM(get_logger(), "Set bounding box into cost map");
 }
 
-std::pair<CameraEkfCorrector::LineSegments, CameraEkfCorrector::LineSegments>
-CameraEkfCorrector::split_line_segments(const PointCloud2 & msg)
+CameraEkfCorrector::LineSegments CameraEkfCorrector::select_line_segments(
+  const common::LineSegmentsView & line_segments, const rclcpp::Time & stamp)
 {
-  LineSegments all_line_segments_cloud;
-  pcl::fromROSMsg(msg, all_line_segments_cloud);
-  LineSegments reliable_cloud, iffy_cloud;
-  {
-    for (const auto & p : all_line_segments_cloud) {
-      if (p.label == 0)
-        iffy_cloud.push_back(p);
-      else
-        reliable_cloud.push_back(p);
-    }
-  }
-
-  auto [good_cloud, bad_cloud] = filt(iffy_cloud);
-  {
-    cv::Mat debug_image = cv::Mat::zeros(800, 800, CV_8UC3);
-    auto draw = [&debug_image](LineSegments & cloud, cv::Scalar color) -> void {
-      for (const auto & line : cloud) {
-        const Eigen::Vector3f p1 = line.getVector3fMap();
-        const Eigen::Vector3f p2 = line.getNormalVector3fMap();
-        cv::line(debug_image, cv2pt(p1), cv2pt(p2), color, 2);
-      }
-    };
-
-    draw(reliable_cloud, cv::Scalar(0, 0, 255));
-    draw(good_cloud, cv::Scalar(0, 255, 0));
-    draw(bad_cloud, cv::Scalar(100, 100, 100));
-    common::publish_image(*pub_image_, debug_image, msg.header.stamp);
+  // TODO: do not use pose_buffer but use synched_pose
+  // Without any pose, no a posteriori segment is selected
+  std::optional<Sophus::SE3f> pose = std::nullopt;
+  if (!pose_buffer_.empty()) pose = common::pose_to_se3(pose_buffer_.back().pose.pose);
+
+  LineSegments selected;
+  selected.reserve(line_segments.size());
+  cv::Mat debug_image = cv::Mat::zeros(800, 800, CV_8UC3);
+  for (const LineSegment & segment : line_segments) {
+    const bool reliable = segment.label != 0;
+    const bool good = reliable || (pose.has_value() && filt(segment, pose.value()));
+    if (good) selected.push_back(segment);
+
+    // reliable: red, consistent a posteriori: green, inconsistent a posteriori: gray
+    cv::Scalar color(100, 100, 100);
+    if (reliable)
+      color = cv::Scalar(0, 0, 255);
+    else if (good)
+      color = cv::Scalar(0, 255, 0);
+    cv::line(debug_image, cv2pt(segment.from), cv2pt(segment.to), color, 2);
   }
+  common::publish_image(*pub_image_, debug_image, stamp);
 
-  return {reliable_cloud, good_cloud};
+  return selected;
 }
 
 std::optional<CameraEkfCorrector::PoseCovStamped> CameraEkfCorrector::get_synchronized_pose(
@@ -168,21 +162,27 @@ void CameraEkfCorrector::on_line_segments(const PointCloud2 & line_segments_msg)
     return;
   }
 
-  auto [line_segments_cloud, iffy_line_segments_cloud] = split_line_segments(line_segments_msg);
-  // iffy_line_segments_cloud.clear(); // TODO:
+  // Segments are read in place rather than converting the whole message
+  const common::LineSegmentsView view(line_segments_msg);
+  if (!view.valid()) {
+    RCLCPP_WARN_STREAM_THROTTLE(
+      get_logger(), *get_clock(), (1000ms).count(),
+      "Drop malformed line segments: " << view.error());
+    return;
+  }
+  const LineSegments line_segments = select_line_segments(view, stamp);
 
   // cost_map_.set_height(opt_synched_pose->pose.pose.position.z);
 
   // TODO:
   if (opt_synched_pose->pose.covariance[0] > 1000) return;
 
-  PoseCovStamped estimated_pose = estimate_pose_with_covariance(
-    opt_synched_pose.value(), line_segments_cloud, iffy_line_segments_cloud);
+  PoseCovStamped estimated_pose =
+    estimate_pose_with_covariance(opt_synched_pose.value(), line_segments);
 
   {
     Sophus::SE3f transform = common::pose_to_se3(opt_synched_pose->pose.pose);
-    pcl::PointCloud<pcl::PointXYZI> cloud = evaluate_cloud(
-      common::transform_line_segments(line_segments_cloud, transform), transform.translation());
+    pcl::PointCloud<pcl::PointXYZI> cloud = evaluate_cloud(line_segments, transform);
 
     pcl::PointCloud<pcl::PointXYZRGB> rgb_cloud;
 
@@ -220,8 +220,7 @@ void CameraEkfCorrector::on_line_segments(const PointCloud2 & line_segments_msg)
 }
 
 CameraEkfCorrector::PoseCovStamped CameraEkfCorrector::estimate_pose_with_covariance(
-  const PoseCovStamped & init, const LineSegments & line_segments_cloud,
-  const LineSegments & iffy_line_segments_cloud)
+  const PoseCovStamped & init, const LineSegments & line_segments)
 {
   ParticleArray particles;
 
@@ -260,13 +259,7 @@ CameraEkfCorrector::PoseCovStamped CameraEkfCorrector::estimate_pose_with_covari
   // Find weights for every pose candidates
   for (auto & particle : particles.particles) {
     Sophus::SE3f transform = common::pose_to_se3(particle.pose);
-    LineSegments transformed_line_segments =
-      common::transform_line_segments(line_segments_cloud, transform);
-    LineSegments transformed_iffy_line_segments =
-      common::transform_line_segments(iffy_line_segments_cloud, transform);
-    transformed_line_segments += transformed_iffy_line_segments;
-
-    float logit = compute_logit(transformed_line_segments, transform.translation());
+    float logit = compute_logit(line_segments, transform);
     particle.weight = logit_to_prob(logit, logit_gain_);
   }
 
@@ -366,15 +359,18 @@ float abs_cos(const Eigen::Vector3f & t, float deg)
 }
 
 float CameraEkfCorrector::compute_logit(
-  const LineSegments & line_segments_cloud, const Eigen::Vector3f & self_position)
+  const LineSegments & line_segments, const Sophus::SE3f & transform)
 {
+  const Eigen::Vector3f self_position = transform.translation();
   float logit = 0;
-  for (const LineSegment & pn : line_segments_cloud) {
-    const Eigen::Vector3f tangent = (pn.getNormalVector3fMap() - pn.getVector3fMap()).normalized();
-    const float length = (pn.getVector3fMap() - pn.getNormalVector3fMap()).norm();
+  for (const LineSegment & pn : line_segments) {
+    const Eigen::Vector3f from = transform * pn.from;
+    const Eigen::Vector3f to = transform * pn.to;
+    const Eigen::Vector3f tangent = (to - from).normalized();
+    const float length = (from - to).norm();
 
     for (float distance = 0; distance < length; distance += 0.1f) {
-      Eigen::Vector3f p = pn.getVector3fMap() + tangent * distance;
+      Eigen::Vector3f p = from + tangent * distance;
 
       // NOTE: Close points are prioritized
       float squared_norm = (p - self_position).topRows(2).squaredNorm();
@@ -397,15 +393,19 @@ float CameraEkfCorrector::compute_logit(
 }
 
 pcl::PointCloud<pcl::PointXYZI> CameraEkfCorrector::evaluate_cloud(
-  const LineSegments & line_segments_cloud, const Eigen::Vector3f & self_position)
+  const LineSegments & line_segments, const Sophus::SE3f & transform)
 {
+  const Eigen::Vector3f self_position = transform.translation();
   pcl::PointCloud<pcl::PointXYZI> cloud;
-  for (const LineSegment & pn : line_segments_cloud) {
-    Eigen::Vector3f tangent = (pn.getNormalVector3fMap() - pn.getVector3fMap()).normalized();
-    float length = (pn.getVector3fMap() - pn.getNormalVector3fMap()).norm();
+  for (const LineSegment & pn : line_segments) {
+    if (pn.label == 0) continue;
+    const Eigen::Vector3f from = transform * pn.from;
+    const Eigen::Vector3f to = transform * pn.to;
+    Eigen::Vector3f tangent = (to - from).normalized();
+    float length = (from - to).norm();
 
     for (float distance = 0; distance < length; distance += 0.1f) {
-      Eigen::Vector3f p = pn.getVector3fMap() + tangent * distance;
+      Eigen::Vector3f p = from + tangent * distance;
 
       // NOTE: Close points are prioritized
       float squared_norm = (p - self_position).topRows(2).squaredNorm();
@@ -46,49 +46,23 @@ float abs_cos2(const Eigen::Vector3f & t, float deg)
   }
 }
 
-std::pair<CameraEkfCorrector::LineSegments, CameraEkfCorrector::LineSegments>
-CameraEkfCorrector::filt(const LineSegments & iffy_lines)
+bool CameraEkfCorrector::filt(const LineSegment & iffy_line, const Sophus::SE3f & pose)
 {
-  LineSegments good, bad;
+  const Eigen::Vector3f & p1 = iffy_line.from;
+  const Eigen::Vector3f & p2 = iffy_line.to;
+  const float length = (p1 - p2).norm();
+  const Eigen::Vector3f tangent = (p1 - p2).normalized();
 
-  // TODO: do not use pose_buffer but use synched_pose
-  if (pose_buffer_.empty()) {
-    return {good, bad};
+  float score = 0;
+  int count = 0;
+  for (float distance = 0; distance < length; distance += 0.1f) {
+    Eigen::Vector3f px = pose * (p2 + tangent * distance);
+    CostMapValue v3 = cost_map_.at(px.topRows(2));
+    float cos2 = abs_cos2(pose.so3() * tangent, v3.angle);
+    score += (cos2 * v3.intensity);
+    count++;
   }
 
-  auto latest_pose = pose_buffer_.back();
-  const Sophus::SE3f pose = common::pose_to_se3(latest_pose.pose.pose);
-
-  // pcl::PointCloud<pcl::PointXYZRGB> rgb_cloud;
-  for (const auto & line : iffy_lines) {
-    const Eigen::Vector3f p1 = line.getVector3fMap();
-    const Eigen::Vector3f p2 = line.getNormalVector3fMap();
-    const float length = (p1 - p2).norm();
-    const Eigen::Vector3f tangent = (p1 - p2).normalized();
-
-    float score = 0;
-    int count = 0;
-    for (float distance = 0; distance < length; distance += 0.1f) {
-      Eigen::Vector3f px = pose * (p2 + tangent * distance);
-      CostMapValue v3 = cost_map_.at(px.topRows(2));
-      float cos2 = abs_cos2(pose.so3() * tangent, v3.angle);
-      score += (cos2 * v3.intensity);
-      count++;
-
-      // pcl::PointXYZRGB rgb;
-      // rgb.getVector3fMap() = px;
-      // rgb.rgba = common::color_scale::blue_red(cos2 * v3[0] / 255.0f);
-      // rgb_cloud.push_back(rgb);
-    }
-
-    if (score / count > 0.5f) {
-      good.push_back(line);
-    } else {
-      bad.push_back(line);
-    }
-  }
-  // common::publish_cloud(*pub_scored_cloud_, rgb_cloud, get_clock()->now());
-
-  return {good, bad};
+  return score / count > 0.5f;
 }
 }  // namespace yabloc::ekf_corrector
\ No newline at end of file
@@ -24,6 +24,7 @@
 #include <vml_common/ground_plane.hpp>
 #include <vml_common/static_tf_subscriber.hpp>
 #include <vml_common/synchro_subscriber.hpp>
+#include <yabloc_common/line_segments_view.hpp>
 
 #include <geometry_msgs/msg/pose_stamped.hpp>
 #include <geometry_msgs/msg/pose_with_covariance_stamped.hpp>
@@ -89,7 +90,7 @@ protected:
   LineSegments extractNaerLineSegments(
     const Sophus::SE3f & pose, const LineSegments & line_segments);
 
-  cv::Mat makeCostMap(LineSegments & line_segments);
+  cv::Mat makeCostMap(const yabloc::common::LineSegmentsView & line_segments);
 
   pcl::PointCloud<pcl::PointXYZ> sampleUniformlyOnImage(
     const Sophus::SE3f & pose, const LineSegments & segments);
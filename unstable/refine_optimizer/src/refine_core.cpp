@@ -92,9 +92,15 @@ void RefineOptimizer::imageAndLsdCallback(const Image & image_msg, const PointCl
   }
   if (min_dt > 0.1) return;
 
-  LineSegments line_segments;
-  pcl::fromROSMsg(line_segments_msg, line_segments);
-  cv::Mat cost_image = makeCostMap(line_segments);
+  // Observed segments are read in place, as they are only drawn into the cost image
+  const yabloc::common::LineSegmentsView observed_segments(line_segments_msg);
+  if (!observed_segments.valid()) {
+    RCLCPP_WARN_STREAM_THROTTLE(
+      get_logger(), *get_clock(), 1000,
+      "Drop malformed line segments: " << observed_segments.error());
+    return;
+  }
+  cv::Mat cost_image = makeCostMap(observed_segments);
 
   Sophus::SE3f raw_pose = vml_common::pose2Se3(synched_pose.pose);
   auto line_segments = extractNaerLineSegments(raw_pose, ll2_cloud_);
@@ -235,15 +241,15 @@ RefineOptimizer::LineSegments RefineOptimizer::extractNaerLineSegments(
   return near_linestrings;
 }
 
-cv::Mat RefineOptimizer::makeCostMap(LineSegments & line_segments)
+cv::Mat RefineOptimizer::makeCostMap(const yabloc::common::LineSegmentsView & line_segments)
 {
   const cv::Size size(info_->width, info_->height);
   cv::Mat image = 255 * cv::Mat::ones(size, CV_8UC1);
 
   auto cvPoint = [](const Eigen::Vector3f & p) -> cv::Point2f { return cv::Point2f(p.x(), p.y()); };
-  for (const auto pn : line_segments) {
-    cv::Point2f from = cvPoint(pn.getVector3fMap());
-    cv::Point2f to = cvPoint(pn.getNormalVector3fMap());
+  for (const auto segment : line_segments) {
+    cv::Point2f from = cvPoint(segment.from);
+    cv::Point2f to = cvPoint(segment.to);
     cv::line(image, from, to, cv::Scalar::all(0), 1);
   }
   cv::Mat distance;
@@ -17,6 +17,7 @@
 #include <opencv4/opencv2/core.hpp>
 #include <rclcpp/rclcpp.hpp>
 #include <yabloc_common/ground_plane.hpp>
+#include <yabloc_common/line_segments_view.hpp>
 #include <yabloc_common/static_tf_subscriber.hpp>
 #include <yabloc_common/timer.hpp>
 
@@ -77,6 +78,7 @@ private:
   void draw_overlay_line_segments(
     cv::Mat & image, const Pose & pose, const LineSegments & line_segments);
 
-  void make_vis_marker(const LineSegments & ls, const Pose & pose, const rclcpp::Time & stamp);
+  void make_vis_marker(
+    const common::LineSegmentsView & ls, const Pose & pose, const rclcpp::Time & stamp);
 };
 }  // namespace yabloc::lanelet2_overlay
\ No newline at end of file
@@ -106,9 +106,13 @@ void Lanelet2Overlay::on_line_segments(const PointCloud2 & msg)
 
   std::vector<int> a;
 
-  LineSegments line_segments_cloud;
-  pcl::fromROSMsg(msg, line_segments_cloud);
-  make_vis_marker(line_segments_cloud, synched_pose.pose, stamp);
+  const common::LineSegmentsView line_segments(msg);
+  if (!line_segments.valid()) {
+    RCLCPP_WARN_STREAM_THROTTLE(
+      get_logger(), *get_clock(), 1000, "Drop malformed line segments: " << line_segments.error());
+    return;
+  }
+  make_vis_marker(line_segments, synched_pose.pose, stamp);
 }
 
 void Lanelet2Overlay::draw_overlay(
@@ -183,7 +187,7 @@ void Lanelet2Overlay::draw_overlay_line_segments(
 }
 
 void Lanelet2Overlay::make_vis_marker(
-  const LineSegments & ls, const Pose & pose, const rclcpp::Time & stamp)
+  const common::LineSegmentsView & ls, const Pose & pose, const rclcpp::Time & stamp)
 {
   Marker marker;
   marker.type = Marker::LINE_LIST;
@@ -196,14 +200,14 @@ void Lanelet2Overlay::make_vis_marker(
   marker.color.b = 0.0f;
   marker.color.a = 0.7f;
 
-  for (const auto pn : ls) {
+  for (const auto segment : ls) {
     geometry_msgs::msg::Point p1, p2;
-    p1.x = pn.x;
-    p1.y = pn.y;
-    p1.z = pn.z;
-    p2.x = pn.normal_x;
-    p2.y = pn.normal_y;
-    p2.z = pn.normal_z;
+    p1.x = segment.from.x();
+    p1.y = segment.from.y();
+    p1.z = segment.from.z();
+    p2.x = segment.to.x();
+    p2.y = segment.to.y();
+    p2.z = segment.to.z();
     marker.points.push_back(p1);
     marker.points.push_back(p2);
   }
@@ -0,0 +1,83 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <rclcpp/rclcpp.hpp>
+
+#include <diagnostic_msgs/msg/diagnostic_array.hpp>
+#include <latency_msgs/msg/frame_latency.hpp>
+#include <latency_msgs/msg/stage_stamp.hpp>
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace yabloc::latency_monitor
+{
+// Reconstruct the latency of each camera frame through the pipeline from the stage stamps.
+// Image stages refer to a frame by the camera stamp. The corrector outputs particles stamped at
+// their own time, so the stages after it are traced back to the frame through that stamp.
+class LatencyMonitor : public rclcpp::Node
+{
+public:
+  using StageStamp = latency_msgs::msg::StageStamp;
+  using FrameLatency = latency_msgs::msg::FrameLatency;
+  using DiagnosticArray = diagnostic_msgs::msg::DiagnosticArray;
+
+  explicit LatencyMonitor(const rclcpp::NodeOptions & options = rclcpp::NodeOptions());
+
+private:
+  struct StageRecord
+  {
+    std::string stage;
+    rclcpp::Time start;
+    rclcpp::Time end;
+    rclcpp::Duration processing;
+  };
+
+  // Latencies [ms] of the recent frames for the rolling percentiles
+  struct StageWindow
+  {
+    std::deque<float> age;
+    std::deque<float> processing;
+    std::deque<float> waiting;
+  };
+
+  const std::string final_stage_;
+  const size_t window_size_;
+  const double frame_timeout_;
+  const float queuing_threshold_;
+
+  rclcpp::Subscription<StageStamp>::SharedPtr sub_stage_stamp_;
+  rclcpp::Publisher<FrameLatency>::SharedPtr pub_frame_latency_;
+  rclcpp::Publisher<DiagnosticArray>::SharedPtr pub_diagnostics_;
+  rclcpp::TimerBase::SharedPtr timer_;
+
+  // Records of the frames in flight, keyed by the camera stamp [ns]
+  std::map<int64_t, std::vector<StageRecord>> frames_;
+  // Camera stamps keyed by the stamps which stages gave to their outputs [ns]
+  std::map<int64_t, int64_t> output_to_frame_;
+  std::map<std::string, StageWindow> windows_;
+  // Number of frames each stage has skipped so far
+  std::map<std::string, uint64_t> dropped_;
+
+  void on_stage_stamp(const StageStamp & msg);
+  void on_timer();
+
+  // Publish the breakdown of the frame and forget it
+  void finalize_frame(int64_t frame_stamp);
+  void publish_diagnostics();
+};
+}  // namespace yabloc::latency_monitor
@@ -0,0 +1,196 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "latency_monitor/latency_monitor.hpp"
+
+#include <yabloc_common/stage_stamp_publisher.hpp>
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+namespace yabloc::latency_monitor
+{
+namespace
+{
+float percentile(const std::deque<float> & values, float p)
+{
+  if (values.empty()) return 0;
+  std::vector<float> sorted(values.begin(), values.end());
+  const size_t n = std::min(static_cast<size_t>(p / 100.f * sorted.size()), sorted.size() - 1);
+  std::nth_element(sorted.begin(), sorted.begin() + n, sorted.end());
+  return sorted[n];
+}
+
+void push_with_limit(std::deque<float> & values, float value, size_t limit)
+{
+  values.push_back(value);
+  while (values.size() > limit) values.pop_front();
+}
+
+float to_ms(const rclcpp::Duration & duration) { return duration.seconds() * 1e3f; }
+}  // namespace
+
+LatencyMonitor::LatencyMonitor(const rclcpp::NodeOptions & options)
+: Node("latency_monitor", options),
+  final_stage_(declare_parameter<std::string>("final_stage", "predictor")),
+  window_size_(declare_parameter<int>("window_size", 100)),
+  frame_timeout_(declare_parameter<double>("frame_timeout", 2.0)),
+  queuing_threshold_(declare_parameter<float>("queuing_threshold", 50.0))
+{
+  using std::placeholders::_1;
+  using namespace std::literals::chrono_literals;
+
+  // Subscriber
+  auto on_stage_stamp = std::bind(&LatencyMonitor::on_stage_stamp, this, _1);
+  sub_stage_stamp_ = create_subscription<StageStamp>(
+    common::StageStampPublisher::STAGE_STAMP_TOPIC, 100, std::move(on_stage_stamp));
+
+  // Publisher
+  pub_frame_latency_ = create_publisher<FrameLatency>("frame_latency", 10);
+  pub_diagnostics_ = create_publisher<DiagnosticArray>("/diagnostics", 10);
+
+  // Timer
+  timer_ = create_wall_timer(1s, std::bind(&LatencyMonitor::on_timer, this));
+}
+
+void LatencyMonitor::on_stage_stamp(const StageStamp & msg)
+{
+  const int64_t input_stamp = rclcpp::Time(msg.input_stamp).nanoseconds();
+  const int64_t output_stamp = rclcpp::Time(msg.output_stamp).nanoseconds();
+  dropped_[msg.stage] = msg.dropped;
+
+  int64_t frame_stamp = input_stamp;
+  if (auto itr = output_to_frame_.find(input_stamp); itr != output_to_frame_.end()) {
+    frame_stamp = itr->second;
+  } else if (msg.stage == final_stage_) {
+    // Weights which do not come from a traced frame, e.g. from the GNSS corrector
+    return;
+  }
+  if (output_stamp != input_stamp) output_to_frame_[output_stamp] = frame_stamp;
+
+  frames_[frame_stamp].push_back({msg.stage, msg.start, msg.end, msg.processing});
+  if (msg.stage == final_stage_) finalize_frame(frame_stamp);
+}
+
+void LatencyMonitor::on_timer()
+{
+  // Frames which never reach the final stage, e.g. the corrector skipped weighting, are reported
+  // as they are
+  const rclcpp::Time now = this->now();
+  std::vector<int64_t> expired;
+  for (const auto & [frame_stamp, records] : frames_) {
+    if ((now - rclcpp::Time(frame_stamp, RCL_ROS_TIME)).seconds() > frame_timeout_)
+      expired.push_back(frame_stamp);
+  }
+  for (int64_t frame_stamp : expired) finalize_frame(frame_stamp);
+
+  publish_diagnostics();
+}
+
+void LatencyMonitor::finalize_frame(int64_t frame_stamp)
+{
+  auto itr = frames_.find(frame_stamp);
+  if (itr == frames_.end()) return;
+  std::vector<StageRecord> records = std::move(itr->second);
+  frames_.erase(itr);
+  for (auto it = output_to_frame_.begin(); it != output_to_frame_.end();) {
+    if (it->second == frame_stamp)
+      it = output_to_frame_.erase(it);
+    else
+      ++it;
+  }
+
+  std::sort(records.begin(), records.end(), [](const StageRecord & a, const StageRecord & b) {
+    return a.end < b.end;
+  });
+
+  const rclcpp::Time camera_stamp(frame_stamp, RCL_ROS_TIME);
+  FrameLatency msg;
+  msg.header.stamp = camera_stamp;
+  for (const StageRecord & record : records) {
+    // The upstream stage is the one which finished last before this stage started. Stages in
+    // parallel (lsd and graph_segment) are thus measured from their common upstream.
+    rclcpp::Time upstream_end = camera_stamp;
+    for (const StageRecord & other : records) {
+      if (other.end <= record.start && upstream_end < other.end) upstream_end = other.end;
+    }
+
+    const float age = to_ms(record.end - camera_stamp);
+    const float processing = to_ms(record.processing);
+    const float waiting = to_ms(record.start - upstream_end);
+
+    msg.stages.push_back(record.stage);
+    msg.age.push_back(age);
+    msg.processing.push_back(processing);
+    msg.waiting.push_back(waiting);
+
+    StageWindow & window = windows_[record.stage];
+    push_with_limit(window.age, age, window_size_);
+    push_with_limit(window.processing, processing, window_size_);
+    push_with_limit(window.waiting, waiting, window_size_);
+  }
+  pub_frame_latency_->publish(msg);
+}
+
+void LatencyMonitor::publish_diagnostics()
+{
+  if (windows_.empty()) return;
+
+  auto to_string = [](float value) -> std::string {
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(1) << value;
+    return ss.str();
+  };
+  auto key_value = [](const std::string & key, const std::string & value) {
+    diagnostic_msgs::msg::KeyValue kv;
+    kv.key = key;
+    kv.value = value;
+    return kv;
+  };
+
+  DiagnosticArray array;
+  array.header.stamp = now();
+  for (const auto & [stage, window] : windows_) {
+    diagnostic_msgs::msg::DiagnosticStatus status;
+    status.name = "yabloc_latency: " + stage;
+    status.hardware_id = "yabloc";
+
+    const float waiting_p50 = percentile(window.waiting, 50);
+    const float age_p50 = percentile(window.age, 50);
+    const float age_p99 = percentile(window.age, 99);
+    if (waiting_p50 > queuing_threshold_) {
+      status.level = diagnostic_msgs::msg::DiagnosticStatus::WARN;
+      status.message = "queuing " + to_string(waiting_p50) + "ms";
+    } else {
+      status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+      status.message = "age p50 " + to_string(age_p50) + "ms p99 " + to_string(age_p99) + "ms";
+    }
+
+    status.values.push_back(key_value("frames", std::to_string(window.age.size())));
+    status.values.push_back(key_value("age_p50[ms]", to_string(age_p50)));
+    status.values.push_back(key_value("age_p99[ms]", to_string(age_p99)));
+    status.values.push_back(
+      key_value("processing_p50[ms]", to_string(percentile(window.processing, 50))));
+    status.values.push_back(
+      key_value("processing_p99[ms]", to_string(percentile(window.processing, 99))));
+    status.values.push_back(key_value("waiting_p50[ms]", to_string(waiting_p50)));
+    status.values.push_back(
+      key_value("waiting_p99[ms]", to_string(percentile(window.waiting, 99))));
+    status.values.push_back(key_value("dropped_frames", std::to_string(dropped_[stage])));
+    array.status.push_back(status);
+  }
+  pub_diagnostics_->publish(array);
+}
+}  // namespace yabloc::latency_monitor
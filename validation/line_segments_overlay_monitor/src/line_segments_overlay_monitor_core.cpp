@@ -16,10 +16,10 @@
 
 #include <opencv4/opencv2/core/eigen.hpp>
 #include <yabloc_common/cv_decompress.hpp>
+#include <yabloc_common/line_segments_view.hpp>
 #include <yabloc_common/pub_sub.hpp>
 
 #include <cv_bridge/cv_bridge.h>
-#include <pcl_conversions/pcl_conversions.h>
 
 namespace yabloc::line_segments_overlay
 {
@@ -70,17 +70,20 @@ void LineSegmentsOverlay::on_line_segments(const PointCloud2::ConstSharedPtr & l
   auto image_ptr = iter->second;
   cv::Mat image = cv_bridge::toCvShare(image_ptr, "bgr8")->image;
 
-  LineSegments line_segments_cloud;
-  pcl::fromROSMsg(*line_segments_msg, line_segments_cloud);
+  const common::LineSegmentsView line_segments(*line_segments_msg);
+  if (!line_segments.valid()) {
+    RCLCPP_WARN_STREAM_THROTTLE(
+      get_logger(), *get_clock(), 1000, "Drop malformed line segments: " << line_segments.error());
+    return;
+  }
 
-  for (size_t index = 0; index < line_segments_cloud.size(); ++index) {
-    const LineSegment & pn = line_segments_cloud.at(index);
-    Eigen::Vector3f xy1 = pn.getVector3fMap();
-    Eigen::Vector3f xy2 = pn.getNormalVector3fMap();
+  for (size_t index = 0; index < line_segments.size(); ++index) {
+    Eigen::Vector3f xy1 = line_segments.from(index);
+    Eigen::Vector3f xy2 = line_segments.to(index);
 
-    cv::Scalar color(0, 255, 0);      // Green
-    if (pn.label == 0) {              // if unreliable
-      color = cv::Scalar(0, 0, 255);  // Red
+    cv::Scalar color(0, 255, 0);            // Green
+    if (line_segments.label(index) == 0) {  // if unreliable
+      color = cv::Scalar(0, 0, 255);        // Red
     }
 
     cv::line(image, cv::Point(xy1(0), xy1(1)), cv::Point(xy2(0), xy2(1)), color, 2);
@@ -0,0 +1,113 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <rclcpp/rclcpp.hpp>
+
+#include <geometry_msgs/msg/pose_stamped.hpp>
+#include <geometry_msgs/msg/pose_with_covariance_stamped.hpp>
+#include <geometry_msgs/msg/twist_with_covariance_stamped.hpp>
+#include <modularized_particle_filter_msgs/msg/particle_array.hpp>
+#include <rosgraph_msgs/msg/clock.hpp>
+#include <sensor_msgs/msg/camera_info.hpp>
+#include <sensor_msgs/msg/compressed_image.hpp>
+#include <sensor_msgs/msg/image.hpp>
+#include <sensor_msgs/msg/point_cloud2.hpp>
+#include <tf2_msgs/msg/tf_message.hpp>
+
+#include <tf2_ros/static_transform_broadcaster.h>
+
+#include <array>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace yabloc::replay_benchmark
+{
+// Replay a recorded bag through the localization nodes in this process as fast as possible.
+// Messages are handed over by intra-process communication without serialization, and every
+// message is processed through all the stages before the next one is injected, so no frame is
+// dropped. /clock is driven by the bag, so timers of the nodes follow the bag time.
+class ReplayBenchmark : public rclcpp::Node
+{
+public:
+  using Clock = rosgraph_msgs::msg::Clock;
+  using CameraInfo = sensor_msgs::msg::CameraInfo;
+  using CompressedImage = sensor_msgs::msg::CompressedImage;
+  using Image = sensor_msgs::msg::Image;
+  using PointCloud2 = sensor_msgs::msg::PointCloud2;
+  using PoseStamped = geometry_msgs::msg::PoseStamped;
+  using PoseCovStamped = geometry_msgs::msg::PoseWithCovarianceStamped;
+  using TwistCovStamped = geometry_msgs::msg::TwistWithCovarianceStamped;
+  using ParticleArray = modularized_particle_filter_msgs::msg::ParticleArray;
+  using SteadyTime = std::chrono::steady_clock::time_point;
+
+  enum Stage { UNDISTORT = 0, LSD, GRAPH_SEGMENT, SEGMENT_FILTER, CORRECTOR, STAGE_COUNT };
+
+  explicit ReplayBenchmark(const rclcpp::NodeOptions & options);
+
+  // Create the nodes under test, replay the whole bag and print the report
+  void run();
+
+private:
+  struct Frame
+  {
+    SteadyTime injected;
+    std::array<std::optional<SteadyTime>, STAGE_COUNT> arrivals;
+  };
+
+  const std::string bag_path_;
+  const std::string image_topic_;
+  const std::string info_topic_;
+  const std::string twist_topic_;
+  const std::string ll2_road_marking_topic_;
+  const std::string ll2_bounding_box_topic_;
+  const std::string reference_topic_;
+  const int max_frames_;
+  const std::string report_path_;
+
+  rclcpp::executors::SingleThreadedExecutor executor_;
+  std::vector<rclcpp::Node::SharedPtr> nodes_;
+
+  rclcpp::Publisher<Clock>::SharedPtr pub_clock_;
+  rclcpp::Publisher<CompressedImage>::SharedPtr pub_image_;
+  rclcpp::Publisher<CameraInfo>::SharedPtr pub_info_;
+  rclcpp::Publisher<TwistCovStamped>::SharedPtr pub_twist_;
+  rclcpp::Publisher<PointCloud2>::SharedPtr pub_ll2_road_marking_;
+  rclcpp::Publisher<PointCloud2>::SharedPtr pub_ll2_bounding_box_;
+  rclcpp::Publisher<PoseCovStamped>::SharedPtr pub_initialpose_;
+  std::unique_ptr<tf2_ros::StaticTransformBroadcaster> tf_broadcaster_;
+
+  std::vector<rclcpp::SubscriptionBase::SharedPtr> stage_subscriptions_;
+  rclcpp::Subscription<PoseStamped>::SharedPtr sub_pose_;
+
+  std::optional<Frame> current_frame_{std::nullopt};
+  std::vector<Frame> frames_;
+  std::vector<PoseStamped> estimated_poses_;
+  std::vector<PoseStamped> reference_poses_;
+  bool map_received_{false};
+
+  void create_nodes();
+  void create_stage_subscriptions();
+  void mark_arrival(Stage stage);
+
+  // Deserialize a bag message and hand it to the nodes. Return true if it is an image.
+  bool inject(const std::string & topic, const rclcpp::SerializedMessage & serialized);
+  void initialize_particles(const PoseStamped & reference);
+
+  std::string make_report(double wall_seconds, double bag_seconds) const;
+};
+}  // namespace yabloc::replay_benchmark
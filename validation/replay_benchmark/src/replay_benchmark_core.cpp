@@ -0,0 +1,375 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "replay_benchmark/replay_benchmark.hpp"
+
+#include <camera_particle_corrector/camera_particle_corrector.hpp>
+#include <graph_segment/graph_segment.hpp>
+#include <lsd/lsd.hpp>
+#include <modularized_particle_filter/prediction/predictor.hpp>
+#include <rosbag2_cpp/reader.hpp>
+#include <segment_filter/segment_filter.hpp>
+#include <undistort/undistort.hpp>
+#include <yabloc_common/pose_conversions.hpp>
+
+#include <nav_msgs/msg/odometry.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace yabloc::replay_benchmark
+{
+namespace
+{
+const char * STAGE_NAMES[] = {"undistort", "lsd", "graph_segment", "segment_filter", "corrector"};
+
+// Each stage starts when its input is ready. segment_filter waits for both lsd and graph_segment.
+const std::vector<std::vector<ReplayBenchmark::Stage>> STAGE_INPUTS = {
+  {},
+  {ReplayBenchmark::UNDISTORT},
+  {ReplayBenchmark::UNDISTORT},
+  {ReplayBenchmark::LSD, ReplayBenchmark::GRAPH_SEGMENT},
+  {ReplayBenchmark::SEGMENT_FILTER},
+};
+
+// Nearest-rank percentile
+double percentile(std::vector<double> values, double p)
+{
+  if (values.empty()) return std::nan("");
+  std::sort(values.begin(), values.end());
+  const size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * values.size()));
+  return values.at(std::clamp<size_t>(rank, 1, values.size()) - 1);
+}
+
+double to_milli_seconds(std::chrono::steady_clock::duration duration)
+{
+  return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+template <typename T>
+T deserialize(const rclcpp::SerializedMessage & serialized)
+{
+  T msg;
+  rclcpp::Serialization<T> serialization;
+  serialization.deserialize_message(&serialized, &msg);
+  return msg;
+}
+
+// The static tf broadcaster needs transient_local, which intra-process communication does not
+// support, so it is enabled per publisher and subscription of this node.
+template <typename OptionsT>
+OptionsT intra_process()
+{
+  OptionsT options;
+  options.use_intra_process_comm = rclcpp::IntraProcessSetting::Enable;
+  return options;
+}
+
+rclcpp::NodeOptions make_options(const std::vector<std::string> & remaps)
+{
+  std::vector<std::string> arguments{"--ros-args"};
+  for (const std::string & remap : remaps) {
+    arguments.push_back("-r");
+    arguments.push_back(remap);
+  }
+  // The clock subscription has to be spun by the same executor so that timers follow /clock
+  return rclcpp::NodeOptions()
+    .arguments(arguments)
+    .use_intra_process_comms(true)
+    .use_clock_thread(false)
+    .parameter_overrides({rclcpp::Parameter("use_sim_time", true)});
+}
+}  // namespace
+
+ReplayBenchmark::ReplayBenchmark(const rclcpp::NodeOptions & options)
+: Node("replay_benchmark", options),
+  bag_path_(declare_parameter<std::string>("bag_path", "")),
+  image_topic_(declare_parameter<std::string>(
+    "image_topic", "/sensing/camera/traffic_light/image_raw/compressed")),
+  info_topic_(
+    declare_parameter<std::string>("info_topic", "/sensing/camera/traffic_light/camera_info")),
+  twist_topic_(declare_parameter<std::string>(
+    "twist_topic", "/localization/twist_estimator/twist_with_covariance")),
+  ll2_road_marking_topic_(
+    declare_parameter<std::string>("ll2_road_marking_topic", "/localization/map/ll2_road_marking")),
+  ll2_bounding_box_topic_(
+    declare_parameter<std::string>("ll2_bounding_box_topic", "/localization/map/ll2_bounding_box")),
+  reference_topic_(
+    declare_parameter<std::string>("reference_topic", "/localization/kinematic_state")),
+  max_frames_(declare_parameter<int>("max_frames", -1)),
+  report_path_(declare_parameter<std::string>("report_path", ""))
+{
+  if (bag_path_.empty()) throw std::invalid_argument("bag_path must be given");
+
+  const auto pub_options = intra_process<rclcpp::PublisherOptions>();
+  pub_clock_ = create_publisher<Clock>("/clock", 10, pub_options);
+  pub_image_ = create_publisher<CompressedImage>("/replay/src_image", 10, pub_options);
+  pub_info_ = create_publisher<CameraInfo>("/replay/src_info", 10, pub_options);
+  pub_twist_ = create_publisher<TwistCovStamped>("/replay/twist_cov", 10, pub_options);
+  pub_ll2_road_marking_ =
+    create_publisher<PointCloud2>("/replay/ll2_road_marking", 10, pub_options);
+  pub_ll2_bounding_box_ =
+    create_publisher<PointCloud2>("/replay/ll2_bounding_box", 10, pub_options);
+  pub_initialpose_ = create_publisher<PoseCovStamped>("/replay/initialpose", 10, pub_options);
+  tf_broadcaster_ = std::make_unique<tf2_ros::StaticTransformBroadcaster>(*this);
+
+  auto on_pose = [this](const PoseStamped & msg) -> void { estimated_poses_.push_back(msg); };
+  sub_pose_ = create_subscription<PoseStamped>(
+    "/replay/pose", 10, std::move(on_pose), intra_process<rclcpp::SubscriptionOptions>());
+  create_stage_subscriptions();
+}
+
+void ReplayBenchmark::create_nodes()
+{
+  using modularized_particle_filter::CameraParticleCorrector;
+  using modularized_particle_filter::Predictor;
+
+  nodes_.push_back(std::make_shared<undistort::UndistortNode>(make_options({
+    "src_image:=/replay/src_image",
+    "src_info:=/replay/src_info",
+    "resized_image:=/replay/image",
+    "resized_info:=/replay/info",
+    "resized_gray_image:=/replay/gray_image",
+  })));
+  nodes_.push_back(std::make_shared<lsd::LineSegmentDetector>(make_options({
+    "src_image:=/replay/gray_image",
+    "camera_info:=/replay/info",
+    "line_segments_cloud:=/replay/line_segments_cloud",
+  })));
+  nodes_.push_back(std::make_shared<graph_segment::GraphSegment>(make_options({
+    "src_image:=/replay/image",
+    "camera_info:=/replay/info",
+    "twist_cov:=/replay/twist_cov",
+    "mask_image:=/replay/mask_image",
+  })));
+  nodes_.push_back(std::make_shared<segment_filter::SegmentFilter>(make_options({
+    "camera_info:=/replay/info",
+    "line_segments_cloud:=/replay/line_segments_cloud",
+    "mask_image:=/replay/mask_image",
+    "projected_line_segments_cloud:=/replay/projected_line_segments_cloud",
+  })));
+  nodes_.push_back(std::make_shared<CameraParticleCorrector>(make_options({
+    "line_segments_cloud:=/replay/projected_line_segments_cloud",
+    "ll2_road_marking:=/replay/ll2_road_marking",
+    "ll2_bounding_box:=/replay/ll2_bounding_box",
+    "pose:=/replay/pose",
+    "predicted_particles:=/replay/predicted_particles",
+    "weighted_particles:=/replay/weighted_particles",
+  })));
+  nodes_.push_back(std::make_shared<Predictor>(make_options({
+    "initialpose:=/replay/initialpose",
+    "twist_cov:=/replay/twist_cov",
+    "height:=/replay/height",
+    "pose:=/replay/pose",
+    "pose_with_covariance:=/replay/pose_with_covariance",
+    "predicted_particles:=/replay/predicted_particles",
+    "weighted_particles:=/replay/weighted_particles",
+  })));
+
+  for (const auto & node : nodes_) executor_.add_node(node);
+}
+
+void ReplayBenchmark::create_stage_subscriptions()
+{
+  auto subscribe = [this](auto type_tag, const std::string & topic, Stage stage) {
+    using MessageT = decltype(type_tag);
+    auto callback = [this, stage](const MessageT &) -> void { mark_arrival(stage); };
+    stage_subscriptions_.push_back(create_subscription<MessageT>(
+      topic, 10, callback, intra_process<rclcpp::SubscriptionOptions>()));
+  };
+  subscribe(Image{}, "/replay/image", UNDISTORT);
+  subscribe(PointCloud2{}, "/replay/line_segments_cloud", LSD);
+  subscribe(Image{}, "/replay/mask_image", GRAPH_SEGMENT);
+  subscribe(PointCloud2{}, "/replay/projected_line_segments_cloud", SEGMENT_FILTER);
+  subscribe(ParticleArray{}, "/replay/weighted_particles", CORRECTOR);
+}
+
+void ReplayBenchmark::mark_arrival(Stage stage)
+{
+  if (!current_frame_.has_value()) return;
+  auto & arrival = current_frame_->arrivals.at(stage);
+  if (!arrival.has_value()) arrival = std::chrono::steady_clock::now();
+}
+
+void ReplayBenchmark::initialize_particles(const PoseStamped & reference)
+{
+  PoseCovStamped initialpose;
+  initialpose.header = reference.header;
+  initialpose.pose.pose = reference.pose;
+  initialpose.pose.covariance.at(6 * 0 + 0) = 1.0;
+  initialpose.pose.covariance.at(6 * 1 + 1) = 1.0;
+  initialpose.pose.covariance.at(6 * 5 + 5) = 0.01;
+  pub_initialpose_->publish(initialpose);
+  RCLCPP_INFO_STREAM(get_logger(), "particles are initialized with the reference pose");
+}
+
+bool ReplayBenchmark::inject(
+  const std::string & topic, const rclcpp::SerializedMessage & serialized)
+{
+  if (topic == image_topic_) {
+    pub_image_->publish(deserialize<CompressedImage>(serialized));
+    return true;
+  }
+
+  if (topic == info_topic_) {
+    pub_info_->publish(deserialize<CameraInfo>(serialized));
+  } else if (topic == twist_topic_) {
+    pub_twist_->publish(deserialize<TwistCovStamped>(serialized));
+  } else if (topic == ll2_road_marking_topic_) {
+    pub_ll2_road_marking_->publish(deserialize<PointCloud2>(serialized));
+    map_received_ = true;
+  } else if (topic == ll2_bounding_box_topic_) {
+    pub_ll2_bounding_box_->publish(deserialize<PointCloud2>(serialized));
+  } else if (topic == "/tf_static") {
+    tf_broadcaster_->sendTransform(deserialize<tf2_msgs::msg::TFMessage>(serialized).transforms);
+  } else if (topic == reference_topic_) {
+    const auto odometry = deserialize<nav_msgs::msg::Odometry>(serialized);
+    PoseStamped pose;
+    pose.header = odometry.header;
+    pose.pose = odometry.pose.pose;
+    if (reference_poses_.empty()) initialize_particles(pose);
+    reference_poses_.push_back(pose);
+  }
+  return false;
+}
+
+void ReplayBenchmark::run()
+{
+  create_nodes();
+  executor_.add_node(shared_from_this());
+
+  rosbag2_cpp::Reader reader;
+  reader.open(bag_path_);
+
+  std::optional<rcutils_time_point_value_t> first_bag_time, last_bag_time;
+  const SteadyTime start = std::chrono::steady_clock::now();
+
+  while (reader.has_next() && rclcpp::ok()) {
+    auto bag_message = reader.read_next();
+    if (!first_bag_time) first_bag_time = bag_message->time_stamp;
+    last_bag_time = bag_message->time_stamp;
+
+    // Advance the time of all nodes to the recorded time of this message
+    Clock clock;
+    clock.clock = rclcpp::Time(bag_message->time_stamp);
+    pub_clock_->publish(clock);
+    executor_.spin_all(std::chrono::seconds(1));
+
+    const rclcpp::SerializedMessage serialized(*bag_message->serialized_data);
+    const bool is_image = inject(bag_message->topic_name, serialized);
+    if (is_image) current_frame_ = Frame{std::chrono::steady_clock::now(), {}};
+
+    // Process this message through all the stages before the next one
+    executor_.spin_all(std::chrono::seconds(1));
+
+    if (is_image) {
+      frames_.push_back(current_frame_.value());
+      current_frame_ = std::nullopt;
+      if (max_frames_ > 0 && static_cast<int>(frames_.size()) >= max_frames_) break;
+    }
+  }
+
+  const double wall_seconds = to_milli_seconds(std::chrono::steady_clock::now() - start) * 1e-3;
+  double bag_seconds = 0;
+  if (first_bag_time) bag_seconds = (last_bag_time.value() - first_bag_time.value()) * 1e-9;
+
+  if (!map_received_) {
+    RCLCPP_WARN_STREAM(
+      get_logger(), ll2_road_marking_topic_ << " is not in the bag. The corrector had no map.");
+  }
+
+  const std::string report = make_report(wall_seconds, bag_seconds);
+  std::cout << report << std::flush;
+  if (!report_path_.empty()) std::ofstream(report_path_) << report;
+}
+
+std::string ReplayBenchmark::make_report(double wall_seconds, double bag_seconds) const
+{
+  std::stringstream ss;
+  ss << std::fixed << std::setprecision(2);
+  ss << "--- replay benchmark ---" << std::endl;
+  ss << "bag: " << bag_path_ << std::endl;
+  ss << "frames: " << frames_.size() << std::endl;
+  ss << "wall time: " << wall_seconds << " s, bag time: " << bag_seconds << " s" << std::endl;
+  if (wall_seconds > 0) {
+    ss << "throughput: " << frames_.size() / wall_seconds << " fps" << std::endl;
+    ss << "real time factor: " << bag_seconds / wall_seconds << std::endl;
+  }
+
+  // Stage latency is measured from the latest arrival of its inputs to the arrival of its output.
+  // Total latency is measured from the injection of the image.
+  ss << std::endl;
+  ss << std::setw(16) << "stage [ms]" << std::setw(8) << "count" << std::setw(10) << "p50"
+     << std::setw(10) << "p90" << std::setw(10) << "p99" << std::setw(10) << "max"
+     << std::setw(12) << "total p50" << std::setw(12) << "total p99" << std::endl;
+  for (int stage = 0; stage < STAGE_COUNT; ++stage) {
+    std::vector<double> latencies, totals;
+    for (const Frame & frame : frames_) {
+      const auto & arrival = frame.arrivals.at(stage);
+      if (!arrival.has_value()) continue;
+
+      SteadyTime input_ready = frame.injected;
+      bool inputs_arrived = true;
+      for (Stage input : STAGE_INPUTS.at(stage)) {
+        if (!frame.arrivals.at(input).has_value()) {
+          inputs_arrived = false;
+          break;
+        }
+        input_ready = std::max(input_ready, frame.arrivals.at(input).value());
+      }
+      if (!inputs_arrived) continue;
+
+      latencies.push_back(to_milli_seconds(arrival.value() - input_ready));
+      totals.push_back(to_milli_seconds(arrival.value() - frame.injected));
+    }
+
+    ss << std::setw(16) << STAGE_NAMES[stage] << std::setw(8) << latencies.size() << std::setw(10)
+       << percentile(latencies, 50) << std::setw(10) << percentile(latencies, 90) << std::setw(10)
+       << percentile(latencies, 99) << std::setw(10) << percentile(latencies, 100)
+       << std::setw(12) << percentile(totals, 50) << std::setw(12) << percentile(totals, 99)
+       << std::endl;
+  }
+
+  // Absolute pose error against the reference, same as ape_monitor
+  std::vector<double> longitudinal, lateral;
+  for (const PoseStamped & estimated : estimated_poses_) {
+    const rclcpp::Time stamp = estimated.header.stamp;
+    auto itr = std::upper_bound(
+      reference_poses_.begin(), reference_poses_.end(), stamp,
+      [](const rclcpp::Time & t, const PoseStamped & ref) -> bool {
+        return t < rclcpp::Time(ref.header.stamp);
+      });
+    if (itr == reference_poses_.begin() || itr == reference_poses_.end()) continue;
+
+    const Eigen::Affine3f ref_affine = common::pose_to_affine(itr->pose);
+    const Eigen::Affine3f est_affine = common::pose_to_affine(estimated.pose);
+    const Eigen::Vector3f ape = (ref_affine.inverse() * est_affine).translation().cwiseAbs();
+    longitudinal.push_back(ape.x());
+    lateral.push_back(ape.y());
+  }
+
+  ss << std::endl;
+  ss << "APE [m] (" << longitudinal.size() << " poses)" << std::endl;
+  ss << "  longitudinal p50: " << percentile(longitudinal, 50)
+     << " p95: " << percentile(longitudinal, 95) << " max: " << percentile(longitudinal, 100)
+     << std::endl;
+  ss << "  lateral      p50: " << percentile(lateral, 50) << " p95: " << percentile(lateral, 95)
+     << " max: " << percentile(lateral, 100) << std::endl;
+  return ss.str();
+}
+}  // namespace yabloc::replay_benchmark
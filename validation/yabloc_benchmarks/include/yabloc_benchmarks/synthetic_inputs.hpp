@@ -0,0 +1,64 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <opencv4/opencv2/core.hpp>
+#include <rclcpp/node.hpp>
+#include <sophus/geometry.hpp>
+
+#include <modularized_particle_filter_msgs/msg/particle_array.hpp>
+#include <sensor_msgs/msg/point_cloud2.hpp>
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+namespace yabloc::benchmarks
+{
+// All inputs are generated from fixed seeds so that the results of different builds are
+// comparable.
+
+// A node shared by the benchmarks which need parameters or a logger. rclcpp must be initialized.
+rclcpp::Node * shared_node();
+
+// Road markings of a grid town of size x size [m]. A road runs every 100 m in both directions and
+// has solid boundaries and a dashed center line. Crosswalks are painted on every intersection.
+pcl::PointCloud<pcl::PointNormal> make_ll2_road_marking(float size = 400.f);
+
+// The pose of a vehicle on the left lane of the road y = 100, heading +x
+Sophus::SE3f make_vehicle_pose();
+
+// Line segments which the camera would observe at make_vehicle_pose(), in base_link.
+// Segments on the road markings have label 255 and some noisy segments have label 0.
+pcl::PointCloud<pcl::PointXYZLNormal> make_observed_line_segments();
+
+// Particles scattered around the pose with random weights
+modularized_particle_filter_msgs::msg::ParticleArray make_particles(
+  const Sophus::SE3f & pose, int number_of_particles);
+
+// The same line and orientation images as HierarchicalCostMap::build_map draws for the area whose
+// corner is `origin`
+void rasterize_road_marking(
+  const pcl::PointCloud<pcl::PointNormal> & cloud, const Eigen::Vector2f & origin, float range,
+  int image_size, cv::Mat & line_image, cv::Mat & orientation_image);
+
+// A road-shaped mask (trapezoid at the bottom) of an image
+cv::Mat make_road_mask(const cv::Size & size);
+
+// Line segments detected on an image, which is the output of lsd in pixel coordinates
+sensor_msgs::msg::PointCloud2 make_image_line_segments(const cv::Size & size, int count);
+
+// A segmented image like graph segmentation gives. The road is one large label and the rest is
+// covered with small irregular labels.
+cv::Mat make_segmented_image(const cv::Size & size);
+}  // namespace yabloc::benchmarks
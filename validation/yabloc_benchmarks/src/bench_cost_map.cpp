@@ -0,0 +1,145 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yabloc_benchmarks/synthetic_inputs.hpp"
+
+#include <camera_particle_corrector/camera_particle_corrector.hpp>
+#include <ll2_cost_map/direct_cost_map.hpp>
+#include <ll2_cost_map/hierarchical_cost_map.hpp>
+#include <yabloc_common/pose_conversions.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <climits>
+#include <memory>
+#include <random>
+
+namespace yabloc::benchmarks
+{
+namespace
+{
+constexpr float MAP_SIZE = 400.f;
+// Defaults of HierarchicalCostMap
+constexpr float MAX_RANGE = 40.f;
+constexpr int IMAGE_SIZE = 800;
+constexpr int NUMBER_OF_PARTICLES = 500;
+
+// HierarchicalCostMap declares parameters, so only one instance can be made on shared_node()
+HierarchicalCostMap & shared_cost_map()
+{
+  static std::unique_ptr<HierarchicalCostMap> cost_map;
+  if (!cost_map) {
+    cost_map = std::make_unique<HierarchicalCostMap>(shared_node());
+    cost_map->set_cloud(make_ll2_road_marking(MAP_SIZE));
+  }
+  return *cost_map;
+}
+
+void BM_CostMapBuild(benchmark::State & state)
+{
+  HierarchicalCostMap & cost_map = shared_cost_map();
+  const int areas_per_row = static_cast<int>(MAP_SIZE / MAX_RANGE);
+
+  // Visit the areas of the town in turn. erase_obsolete() keeps at most 11 maps, so every visit
+  // builds a map from scratch. The index lives across runs for the same reason.
+  static int index = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    cost_map.erase_obsolete();
+    const int x = index % areas_per_row;
+    const int y = (index / areas_per_row) % areas_per_row;
+    const Eigen::Vector2f position((x + 0.5f) * MAX_RANGE, (y + 0.5f) * MAX_RANGE);
+    index++;
+    state.ResumeTiming();
+
+    benchmark::DoNotOptimize(cost_map.at(position));
+  }
+}
+BENCHMARK(BM_CostMapBuild)->Unit(benchmark::kMillisecond);
+
+void BM_CostMapAt(benchmark::State & state)
+{
+  HierarchicalCostMap & cost_map = shared_cost_map();
+
+  // Positions around the vehicle as the particles are scored
+  std::mt19937 engine(0);
+  std::uniform_real_distribution<float> offset(-20.f, 20.f);
+  const Eigen::Vector2f center = make_vehicle_pose().translation().topRows(2);
+  std::vector<Eigen::Vector2f> positions(4096);
+  for (Eigen::Vector2f & p : positions) {
+    p = center + Eigen::Vector2f(offset(engine), offset(engine));
+  }
+
+  // Maps are built beforehand
+  for (const Eigen::Vector2f & p : positions) cost_map.at(p);
+
+  for (auto _ : state) {
+    for (const Eigen::Vector2f & p : positions) benchmark::DoNotOptimize(cost_map.at(p));
+  }
+  state.SetItemsProcessed(state.iterations() * positions.size());
+}
+BENCHMARK(BM_CostMapAt);
+
+void BM_DirectCostMap(benchmark::State & state)
+{
+  const Eigen::Vector2f center = make_vehicle_pose().translation().topRows(2);
+  const Eigen::Vector2f origin = (center / MAX_RANGE).array().floor() * MAX_RANGE;
+
+  cv::Mat line_image, orientation_image;
+  rasterize_road_marking(
+    make_ll2_road_marking(MAP_SIZE), origin, MAX_RANGE, IMAGE_SIZE, line_image,
+    orientation_image);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(direct_cost_map(orientation_image, line_image));
+  }
+  state.SetItemsProcessed(state.iterations() * IMAGE_SIZE * IMAGE_SIZE);
+}
+BENCHMARK(BM_DirectCostMap)->Unit(benchmark::kMillisecond);
+
+// Score all particles of a frame. range(0) selects the sample set, 0 for the fixed 0.1 m spacing,
+// which is the default of the corrector, and 1 for the adaptive spacing from 0.1 m to 0.5 m with
+// at most 4000 samples and merged collinear segments.
+void BM_ComputeLogit(benchmark::State & state)
+{
+  using modularized_particle_filter::compute_logit;
+  using modularized_particle_filter::ScoringSample;
+  using modularized_particle_filter::ScoringSamplePlanner;
+
+  HierarchicalCostMap & cost_map = shared_cost_map();
+
+  const ScoringSamplePlanner planner = state.range(0) == 0
+                                         ? ScoringSamplePlanner(0.001f, 0.1f, 0.1f, INT_MAX, false)
+                                         : ScoringSamplePlanner(0.001f, 0.1f, 0.5f, 4000, true);
+  const std::vector<ScoringSample> samples = planner.plan(make_observed_line_segments());
+
+  std::vector<Sophus::SE3f> transforms;
+  for (const auto & particle : make_particles(make_vehicle_pose(), NUMBER_OF_PARTICLES).particles)
+    transforms.push_back(common::pose_to_se3(particle.pose));
+
+  // Maps are built beforehand
+  for (const Sophus::SE3f & transform : transforms)
+    compute_logit(samples, 0, samples.size(), transform, cost_map);
+
+  for (auto _ : state) {
+    for (const Sophus::SE3f & transform : transforms) {
+      benchmark::DoNotOptimize(compute_logit(samples, 0, samples.size(), transform, cost_map));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * transforms.size() * samples.size());
+  state.counters["samples"] = samples.size();
+}
+BENCHMARK(BM_ComputeLogit)->ArgName("adaptive")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+}  // namespace
+}  // namespace yabloc::benchmarks
@@ -0,0 +1,92 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yabloc_benchmarks/synthetic_inputs.hpp"
+
+#include <graph_segment/label_statistics.hpp>
+#include <segment_filter/mask_filter.hpp>
+
+#include <benchmark/benchmark.h>
+
+namespace yabloc::benchmarks
+{
+namespace
+{
+const cv::Size IMAGE_SIZE(800, 600);
+// graph_segment works on the half-size image
+const cv::Size SEGMENTED_SIZE(400, 300);
+
+// range(0) is the number of line segments
+void BM_FiltByMaskRaster(benchmark::State & state)
+{
+  const cv::Mat mask = make_road_mask(IMAGE_SIZE);
+  const sensor_msgs::msg::PointCloud2 msg = make_image_line_segments(IMAGE_SIZE, state.range(0));
+  const common::LineSegmentsView edges(msg);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(segment_filter::filt_by_mask_raster(mask, edges));
+  }
+  state.SetItemsProcessed(state.iterations() * edges.size());
+}
+BENCHMARK(BM_FiltByMaskRaster)->Arg(100)->Arg(500);
+
+// range(0) is the number of line segments
+void BM_FiltByMaskDirect(benchmark::State & state)
+{
+  const cv::Mat mask = make_road_mask(IMAGE_SIZE);
+  const sensor_msgs::msg::PointCloud2 msg = make_image_line_segments(IMAGE_SIZE, state.range(0));
+  const common::LineSegmentsView edges(msg);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(segment_filter::filt_by_mask_direct(mask, edges));
+  }
+  state.SetItemsProcessed(state.iterations() * edges.size());
+}
+BENCHMARK(BM_FiltByMaskDirect)->Arg(100)->Arg(500);
+
+// range(0) is 1 if color histograms are computed too, as the similar area search needs
+void BM_ComputeLabelStatistics(benchmark::State & state)
+{
+  const cv::Mat segmented = make_segmented_image(SEGMENTED_SIZE);
+  cv::Mat bgr_image(SEGMENTED_SIZE, CV_8UC3);
+  cv::randu(bgr_image, cv::Scalar::all(0), cv::Scalar::all(255));
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+      graph_segment::compute_label_statistics(segmented, bgr_image, state.range(0) != 0));
+  }
+  state.SetItemsProcessed(state.iterations() * segmented.total());
+}
+BENCHMARK(BM_ComputeLabelStatistics)->Arg(0)->Arg(1);
+
+void BM_SearchMostRoadLikeClass(benchmark::State & state)
+{
+  const cv::Mat segmented = make_segmented_image(SEGMENTED_SIZE);
+  const graph_segment::LabelStatistics statistics =
+    graph_segment::compute_label_statistics(segmented, cv::Mat(), false);
+
+  // Same as the default target_candidate_box of graph_segment
+  const int W = 15;
+  const cv::Point2i target_px(SEGMENTED_SIZE.width * 0.5, SEGMENTED_SIZE.height * 0.85);
+  const cv::Rect target_box(target_px + cv::Point2i(-W, -W), target_px + cv::Point2i(W, W));
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+      graph_segment::search_most_road_like_class(segmented, statistics, target_box));
+  }
+  state.SetItemsProcessed(state.iterations() * target_box.area());
+}
+BENCHMARK(BM_SearchMostRoadLikeClass);
+}  // namespace
+}  // namespace yabloc::benchmarks
@@ -0,0 +1,51 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yabloc_benchmarks/synthetic_inputs.hpp"
+
+#include <yabloc_common/extract_line_segments.hpp>
+#include <yabloc_common/transform_line_segments.hpp>
+
+#include <benchmark/benchmark.h>
+
+namespace yabloc::benchmarks
+{
+namespace
+{
+void BM_TransformLineSegments(benchmark::State & state)
+{
+  const pcl::PointCloud<pcl::PointXYZLNormal> observed = make_observed_line_segments();
+  const Sophus::SE3f pose = make_vehicle_pose();
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(common::transform_line_segments(observed, pose));
+  }
+  state.SetItemsProcessed(state.iterations() * observed.size());
+}
+BENCHMARK(BM_TransformLineSegments);
+
+// range(0) is the size of the town [m]
+void BM_ExtractNearLineSegments(benchmark::State & state)
+{
+  const pcl::PointCloud<pcl::PointNormal> road_marking = make_ll2_road_marking(state.range(0));
+  const Sophus::SE3f pose = make_vehicle_pose();
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(common::extract_near_line_segments(road_marking, pose));
+  }
+  state.SetItemsProcessed(state.iterations() * road_marking.size());
+}
+BENCHMARK(BM_ExtractNearLineSegments)->Arg(400)->Arg(2000);
+}  // namespace
+}  // namespace yabloc::benchmarks
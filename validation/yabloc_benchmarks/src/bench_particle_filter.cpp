@@ -0,0 +1,122 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yabloc_benchmarks/synthetic_inputs.hpp"
+
+#include <gnss_particle_corrector/weight_manager.hpp>
+#include <gnss_particle_corrector/weight_table.hpp>
+#include <modularized_particle_filter/common/mean.hpp>
+#include <modularized_particle_filter/prediction/resampler.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+
+namespace yabloc::benchmarks
+{
+namespace
+{
+using modularized_particle_filter::RetroactiveResampler;
+using modularized_particle_filter::WeightManager;
+using modularized_particle_filter::WeightTable;
+using ParticleArray = modularized_particle_filter_msgs::msg::ParticleArray;
+
+// Defaults of the predictor
+constexpr int NUMBER_OF_PARTICLES = 500;
+constexpr int MAX_HISTORY_NUM = 100;
+
+void BM_Resample(benchmark::State & state)
+{
+  RetroactiveResampler resampler(NUMBER_OF_PARTICLES, MAX_HISTORY_NUM);
+  const ParticleArray predicted = make_particles(make_vehicle_pose(), NUMBER_OF_PARTICLES);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(resampler.resample(predicted));
+  }
+  state.SetItemsProcessed(state.iterations() * NUMBER_OF_PARTICLES);
+}
+BENCHMARK(BM_Resample);
+
+// range(0) is the number of resamplings between the weighted particles and the current ones
+void BM_AddWeightRetroactively(benchmark::State & state)
+{
+  RetroactiveResampler resampler(NUMBER_OF_PARTICLES, MAX_HISTORY_NUM);
+  const ParticleArray weighted = make_particles(make_vehicle_pose(), NUMBER_OF_PARTICLES);
+
+  ParticleArray predicted = weighted;
+  for (int i = 0; i < state.range(0); ++i) predicted = resampler.resample(predicted);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(resampler.add_weight_retroactively(predicted, weighted));
+  }
+  state.SetItemsProcessed(state.iterations() * NUMBER_OF_PARTICLES);
+}
+BENCHMARK(BM_AddWeightRetroactively)->Arg(0)->Arg(10)->Arg(50);
+
+void BM_MeanPose(benchmark::State & state)
+{
+  const ParticleArray particles = make_particles(make_vehicle_pose(), NUMBER_OF_PARTICLES);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(modularized_particle_filter::mean_pose(particles));
+  }
+  state.SetItemsProcessed(state.iterations() * NUMBER_OF_PARTICLES);
+}
+BENCHMARK(BM_MeanPose);
+
+// Parameters are declared only once on the shared node
+const WeightManager & gnss_weight_manager()
+{
+  static const WeightManager manager(shared_node());
+  return manager;
+}
+
+// A GNSS position which is off from the vehicle as much as not-fixed GNSS is
+Eigen::Vector3f make_gnss_position() { return make_vehicle_pose() * Eigen::Vector3f(3, -2, 0); }
+
+void BM_GnssWeightTable(benchmark::State & state)
+{
+  const WeightTable table(gnss_weight_manager(), false);
+  ParticleArray particles = make_particles(make_vehicle_pose(), NUMBER_OF_PARTICLES);
+  const Eigen::Vector3f gnss_position = make_gnss_position();
+  WeightTable::Offsets offsets;
+
+  for (auto _ : state) {
+    table.weight(particles, gnss_position, offsets);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * NUMBER_OF_PARTICLES);
+}
+BENCHMARK(BM_GnssWeightTable);
+
+// The exact pdf which WeightTable approximates, as the baseline
+void BM_GnssWeightExact(benchmark::State & state)
+{
+  const WeightManager & manager = gnss_weight_manager();
+  ParticleArray particles = make_particles(make_vehicle_pose(), NUMBER_OF_PARTICLES);
+  const Eigen::Vector3f gnss_position = make_gnss_position();
+
+  for (auto _ : state) {
+    for (auto & particle : particles.particles) {
+      const float dx = particle.pose.position.x - gnss_position.x();
+      const float dy = particle.pose.position.y - gnss_position.y();
+      particle.weight = manager.normal_pdf(std::hypot(dx, dy), false);
+    }
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * NUMBER_OF_PARTICLES);
+}
+BENCHMARK(BM_GnssWeightExact);
+}  // namespace
+}  // namespace yabloc::benchmarks
@@ -0,0 +1,278 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yabloc_benchmarks/synthetic_inputs.hpp"
+
+#include <opencv4/opencv2/imgproc.hpp>
+#include <yabloc_common/line_segments_view.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace yabloc::benchmarks
+{
+namespace
+{
+constexpr float ROAD_INTERVAL = 100.f;    // [m]
+constexpr float HALF_ROAD_WIDTH = 3.5f;  // [m]
+
+pcl::PointNormal make_segment(const Eigen::Vector3f & from, const Eigen::Vector3f & to)
+{
+  pcl::PointNormal pn;
+  pn.getVector3fMap() = from;
+  pn.getNormalVector3fMap() = to;
+  return pn;
+}
+
+// Add a road along `direction` whose center line passes through `center`
+void add_road(
+  const Eigen::Vector3f & center, const Eigen::Vector3f & direction, float length,
+  pcl::PointCloud<pcl::PointNormal> & cloud)
+{
+  const Eigen::Vector3f side = Eigen::Vector3f::UnitZ().cross(direction);
+
+  // Solid boundaries are split every 10 m like linestrings of lanelet2
+  for (float s = 0; s < length; s += 10.f) {
+    const float e = std::min(s + 10.f, length);
+    for (float offset : {-HALF_ROAD_WIDTH, HALF_ROAD_WIDTH}) {
+      cloud.push_back(make_segment(
+        center + s * direction + offset * side, center + e * direction + offset * side));
+    }
+  }
+
+  // Dashed center line, 3 m painted and 6 m blank
+  for (float s = 0; s + 3.f < length; s += 9.f) {
+    cloud.push_back(make_segment(center + s * direction, center + (s + 3.f) * direction));
+  }
+}
+
+// Add stripes of a crosswalk whose nearest edge is `distance` from the intersection
+void add_crosswalk(
+  const Eigen::Vector3f & intersection, const Eigen::Vector3f & direction, float distance,
+  pcl::PointCloud<pcl::PointNormal> & cloud)
+{
+  const Eigen::Vector3f side = Eigen::Vector3f::UnitZ().cross(direction);
+  const Eigen::Vector3f from = intersection + distance * direction;
+  const Eigen::Vector3f to = from + 3.f * direction;
+  for (float t = -HALF_ROAD_WIDTH + 0.5f; t + 0.45f < HALF_ROAD_WIDTH; t += 0.9f) {
+    cloud.push_back(make_segment(from + t * side, to + t * side));
+    cloud.push_back(make_segment(from + (t + 0.45f) * side, to + (t + 0.45f) * side));
+  }
+}
+
+Eigen::Vector3f perturb(const Eigen::Vector3f & v, std::mt19937 & engine)
+{
+  std::normal_distribution<float> noise(0.f, 0.02f);
+  return v + Eigen::Vector3f(noise(engine), noise(engine), 0.f);
+}
+}  // namespace
+
+rclcpp::Node * shared_node()
+{
+  static std::shared_ptr<rclcpp::Node> node = [] {
+    auto node = std::make_shared<rclcpp::Node>("yabloc_benchmarks");
+    // HierarchicalCostMap reports every map building
+    node->get_logger().set_level(rclcpp::Logger::Level::Warn);
+    return node;
+  }();
+  return node.get();
+}
+
+pcl::PointCloud<pcl::PointNormal> make_ll2_road_marking(float size)
+{
+  pcl::PointCloud<pcl::PointNormal> cloud;
+  for (float c = 0; c <= size; c += ROAD_INTERVAL) {
+    add_road(Eigen::Vector3f(0, c, 0), Eigen::Vector3f::UnitX(), size, cloud);
+    add_road(Eigen::Vector3f(c, 0, 0), Eigen::Vector3f::UnitY(), size, cloud);
+  }
+
+  for (float x = 0; x <= size; x += ROAD_INTERVAL) {
+    for (float y = 0; y <= size; y += ROAD_INTERVAL) {
+      const Eigen::Vector3f intersection(x, y, 0);
+      for (const Eigen::Vector3f & direction :
+           {Eigen::Vector3f::UnitX(), Eigen::Vector3f::UnitY(), -Eigen::Vector3f::UnitX(),
+            -Eigen::Vector3f::UnitY()}) {
+        add_crosswalk(intersection, direction, HALF_ROAD_WIDTH + 1.f, cloud);
+      }
+    }
+  }
+  return cloud;
+}
+
+Sophus::SE3f make_vehicle_pose()
+{
+  return Sophus::SE3f(Sophus::SO3f(), Eigen::Vector3f(150.f, ROAD_INTERVAL + 1.75f, 0.f));
+}
+
+pcl::PointCloud<pcl::PointXYZLNormal> make_observed_line_segments()
+{
+  std::mt19937 engine(0);
+  const Sophus::SE3f base_from_map = make_vehicle_pose().inverse();
+
+  // Visible range of the front camera in base_link
+  constexpr float NEAR = 3.f, FAR = 25.f, TAN_HALF_FOV = 0.7f;
+
+  pcl::PointCloud<pcl::PointXYZLNormal> observed;
+  auto push = [&](const Eigen::Vector3f & from, const Eigen::Vector3f & to, uint32_t label) {
+    pcl::PointXYZLNormal pn;
+    pn.getVector3fMap() = from;
+    pn.getNormalVector3fMap() = to;
+    pn.label = label;
+    observed.push_back(pn);
+  };
+
+  // Visible parts of the road markings, split into short pieces as lsd does
+  std::uniform_real_distribution<float> piece_length(1.f, 3.f);
+  for (const pcl::PointNormal & pn : make_ll2_road_marking()) {
+    Eigen::Vector3f from = base_from_map * pn.getVector3fMap();
+    Eigen::Vector3f to = base_from_map * pn.getNormalVector3fMap();
+    if (from.x() > to.x()) std::swap(from, to);
+    if (to.x() < NEAR || from.x() > FAR) continue;
+
+    const Eigen::Vector3f direction = (to - from).normalized();
+    if (direction.x() < 1e-3f) {
+      // Lateral stripes are rarely visible, so skip them for simplicity
+      continue;
+    }
+    auto at_x = [&](float x) -> Eigen::Vector3f {
+      return from + direction * ((x - from.x()) / direction.x());
+    };
+    if (from.x() < NEAR) from = at_x(NEAR);
+    if (to.x() > FAR) to = at_x(FAR);
+
+    for (float s = 0, length = (to - from).norm(); s < length;) {
+      const float e = std::min(s + piece_length(engine), length);
+      const Eigen::Vector3f a = from + s * direction, b = from + e * direction;
+      s = e;
+      if (std::abs(a.y()) > TAN_HALF_FOV * a.x()) continue;
+      push(perturb(a, engine), perturb(b, engine), 255);
+    }
+  }
+
+  // Segments on vehicles, shadows and so on
+  std::uniform_real_distribution<float> x_dist(NEAR, 20.f), y_dist(-6.f, 6.f);
+  std::uniform_real_distribution<float> angle_dist(-M_PI, M_PI), length_dist(0.3f, 1.5f);
+  for (int i = 0; i < 30; ++i) {
+    const Eigen::Vector3f from(x_dist(engine), y_dist(engine), 0.f);
+    const float angle = angle_dist(engine);
+    const Eigen::Vector3f to =
+      from + length_dist(engine) * Eigen::Vector3f(std::cos(angle), std::sin(angle), 0.f);
+    push(from, to, 0);
+  }
+  return observed;
+}
+
+modularized_particle_filter_msgs::msg::ParticleArray make_particles(
+  const Sophus::SE3f & pose, int number_of_particles)
+{
+  std::mt19937 engine(0);
+  std::normal_distribution<float> position_noise(0.f, 0.5f), yaw_noise(0.f, 0.05f);
+  std::uniform_real_distribution<float> weight_dist(0.5f, 1.5f);
+
+  modularized_particle_filter_msgs::msg::ParticleArray array;
+  array.header.frame_id = "map";
+  array.id = 0;
+  array.particles.resize(number_of_particles);
+  for (auto & particle : array.particles) {
+    const Eigen::Vector3f t =
+      pose.translation() + Eigen::Vector3f(position_noise(engine), position_noise(engine), 0.f);
+    const Eigen::Quaternionf q =
+      pose.unit_quaternion() * Eigen::AngleAxisf(yaw_noise(engine), Eigen::Vector3f::UnitZ());
+    particle.pose.position.x = t.x();
+    particle.pose.position.y = t.y();
+    particle.pose.position.z = t.z();
+    particle.pose.orientation.w = q.w();
+    particle.pose.orientation.x = q.x();
+    particle.pose.orientation.y = q.y();
+    particle.pose.orientation.z = q.z();
+    particle.weight = weight_dist(engine);
+  }
+  return array;
+}
+
+void rasterize_road_marking(
+  const pcl::PointCloud<pcl::PointNormal> & cloud, const Eigen::Vector2f & origin, float range,
+  int image_size, cv::Mat & line_image, cv::Mat & orientation_image)
+{
+  line_image = 255 * cv::Mat::ones(cv::Size(image_size, image_size), CV_8UC1);
+  orientation_image = cv::Mat::zeros(cv::Size(image_size, image_size), CV_8UC1);
+
+  auto to_cv_point = [&](const Eigen::Vector3f & p) -> cv::Point {
+    const Eigen::Vector2f relative = (p.topRows(2) - origin) / range * image_size;
+    return {static_cast<int>(relative.x()), static_cast<int>(relative.y())};
+  };
+
+  for (const pcl::PointNormal & pn : cloud) {
+    const cv::Point from = to_cv_point(pn.getVector3fMap());
+    const cv::Point to = to_cv_point(pn.getNormalVector3fMap());
+
+    float radian = std::atan2(from.y - to.y, from.x - to.x);
+    if (radian < 0) radian += M_PI;
+    const float degree = radian * 180 / M_PI;
+
+    cv::line(line_image, from, to, cv::Scalar::all(0), 1);
+    cv::line(orientation_image, from, to, cv::Scalar::all(degree), 1);
+  }
+}
+
+cv::Mat make_road_mask(const cv::Size & size)
+{
+  cv::Mat mask = cv::Mat::zeros(size, CV_8UC1);
+  const int W = size.width, H = size.height;
+  std::vector<cv::Point> road = {
+    {0, H - 1}, {W - 1, H - 1}, {W * 3 / 5, H * 11 / 20}, {W * 2 / 5, H * 11 / 20}};
+  cv::fillConvexPoly(mask, road, cv::Scalar::all(255));
+  return mask;
+}
+
+sensor_msgs::msg::PointCloud2 make_image_line_segments(const cv::Size & size, int count)
+{
+  std::mt19937 engine(0);
+  std::uniform_real_distribution<float> x_dist(0, size.width - 1), y_dist(0, size.height - 1);
+  std::uniform_real_distribution<float> angle_dist(-M_PI, M_PI), length_dist(5.f, 80.f);
+
+  std::vector<common::LineSegmentRecord> records;
+  records.reserve(count);
+  for (int i = 0; i < count; ++i) {
+    const float x = x_dist(engine), y = y_dist(engine);
+    const float angle = angle_dist(engine), length = length_dist(engine);
+    const float to_x = std::clamp(x + length * std::cos(angle), 0.f, size.width - 1.f);
+    const float to_y = std::clamp(y + length * std::sin(angle), 0.f, size.height - 1.f);
+    records.push_back({x, y, 0.f, to_x, to_y, 0.f, 0});
+  }
+  return common::to_line_segments_msg(records);
+}
+
+cv::Mat make_segmented_image(const cv::Size & size)
+{
+  // Cells of 16x12 pixels with wavy boundaries
+  constexpr int CELL_W = 16, CELL_H = 12;
+  const int cells_per_row = (size.width + 2 * CELL_W - 1) / CELL_W;
+
+  cv::Mat segmented(size, CV_32SC1);
+  for (int h = 0; h < size.height; h++) {
+    int * ptr = segmented.ptr<int>(h);
+    const int shift = static_cast<int>(4 * std::sin(h * 0.3f)) + CELL_W;
+    for (int w = 0; w < size.width; w++) {
+      ptr[w] = (h / CELL_H) * cells_per_row + (w + shift) / CELL_W;
+    }
+  }
+
+  // The road takes the label next to the largest one of the cells
+  const int road_label = ((size.height - 1) / CELL_H + 1) * cells_per_row;
+  segmented.setTo(cv::Scalar::all(road_label), make_road_mask(size));
+  return segmented;
+}
+}  // namespace yabloc::benchmarks
@@ -18,6 +18,8 @@
 #include <sensor_msgs/msg/compressed_image.hpp>
 #include <sensor_msgs/msg/image.hpp>
 
+#include <string>
+
 namespace yabloc::common
 {
 cv::Mat decompress_to_cv_mat(const sensor_msgs::msg::Image & img);
@@ -27,4 +29,25 @@ sensor_msgs::msg::Image::ConstSharedPtr decompress_to_ros_msg(
 
 cv::Mat decompress_to_cv_mat(const sensor_msgs::msg::CompressedImage & compressed_img);
 
+// Decode an image reduced by 1/scale, where scale is one of 1, 2, 4 or 8.
+// JPEG images are downscaled inside the decoder (IMREAD_REDUCED_COLOR_*), so the full resolution
+// image is never materialized. Bayer images are demosaiced at full resolution and then reduced,
+// because DCT-domain scaling would mix the color filter array.
+cv::Mat decompress_to_cv_mat(const sensor_msgs::msg::CompressedImage & compressed_img, int scale);
+
+// Same as above, and also fill luminance with the gray image of the same size. For Bayer images
+// with scale >= 2, both come from a single 2x2 binning pass instead of a full demosaic.
+cv::Mat decompress_to_cv_mat(
+  const sensor_msgs::msg::CompressedImage & compressed_img, int scale, cv::Mat & luminance);
+
+// Demosaic a raw Bayer image by 2x2 binning, which halves the resolution. Each cell of one R,
+// two G and one B becomes one BGR pixel. If luminance is given, it is filled with the luma of
+// the same cells.
+cv::Mat debayer_by_binning(
+  const cv::Mat & raw_image, const std::string & encoding, cv::Mat * luminance = nullptr);
+
+// Return the largest scale in {1, 2, 4, 8} such that the reduced width is still no smaller than
+// dst_width. If dst_width is not positive, 1 is returned.
+int reduced_decode_scale(int src_width, int dst_width);
+
 }  // namespace yabloc::common
\ No newline at end of file
@@ -0,0 +1,49 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <array>
+#include <cstdint>
+
+namespace yabloc::common
+{
+// Log-linear histogram of durations [ns] in the manner of HdrHistogram.
+// A value is bucketed by its power of 2 and by SUB_BUCKETS linear steps in it, so any value from
+// 1 ns to hours is recorded in a fixed memory with a relative error below 1 / SUB_BUCKETS.
+class LatencyHistogram
+{
+public:
+  void add(int64_t value);
+  void reset();
+
+  uint64_t count() const { return count_; }
+  int64_t max() const { return max_; }
+
+  // The value at the percentile p (0-100). It returns 0 if nothing has been added.
+  int64_t percentile(double p) const;
+
+private:
+  static constexpr int SUB_BUCKET_BITS = 5;
+  static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+  static constexpr int BUCKET_COUNT = (64 - SUB_BUCKET_BITS) * SUB_BUCKETS;
+
+  std::array<uint32_t, BUCKET_COUNT> counts_{};
+  uint64_t count_{0};
+  int64_t max_{0};
+
+  static int bucket_index(uint64_t value);
+  // The middle of the range of values which fall into the bucket
+  static int64_t bucket_value(int index);
+};
+}  // namespace yabloc::common
@@ -0,0 +1,93 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <rclcpp/rclcpp.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace yabloc::common
+{
+// Subscription for a stage which may fall behind its input. When a message is delivered, the
+// messages which queued up behind it are taken at once and only the newest one is passed to the
+// callback, so that the stage never spends time on a stale frame. The skipped frames are counted.
+// With latest_only = false, it behaves as an ordinary subscription.
+// Intra-process messages can not be taken, so under intra-process communication the queue depth
+// is reduced to 1 instead. Then stale frames are overwritten in the queue without being counted.
+template <typename Msg>
+class LatestOnlySubscription
+{
+public:
+  using SharedPtr = std::shared_ptr<LatestOnlySubscription>;
+  using UserCallback = std::function<void(const Msg &)>;
+
+  LatestOnlySubscription(
+    rclcpp::Node * node, const std::string & topic, const rclcpp::QoS & qos,
+    UserCallback callback, bool latest_only)
+  : latest_only_(latest_only),
+    user_callback_(std::move(callback)),
+    logger_(node->get_logger()),
+    clock_(node->get_clock())
+  {
+    auto on_message = [this](std::unique_ptr<Msg> msg) -> void {
+      this->on_message(std::move(msg));
+    };
+
+    rclcpp::QoS actual_qos = qos;
+    if (latest_only_ && node->get_node_options().use_intra_process_comms()) {
+      actual_qos.keep_last(1);
+      RCLCPP_WARN_STREAM(
+        logger_, "Stale frames on " << topic << " are overwritten uncounted under intra-process");
+    }
+    subscription_ = node->create_subscription<Msg>(topic, actual_qos, std::move(on_message));
+  }
+
+  // Number of frames skipped since the start
+  uint64_t dropped_count() const { return dropped_count_; }
+
+private:
+  const bool latest_only_;
+  UserCallback user_callback_;
+  rclcpp::Logger logger_;
+  rclcpp::Clock::SharedPtr clock_;
+  typename rclcpp::Subscription<Msg>::SharedPtr subscription_;
+  uint64_t dropped_count_{0};
+
+  void on_message(std::unique_ptr<Msg> msg)
+  {
+    if (latest_only_) {
+      // NOTE: take() returns false for messages delivered by intra-process communication, which
+      // are skipped by the depth of the queue instead.
+      auto newer = std::make_unique<Msg>();
+      rclcpp::MessageInfo info;
+      uint64_t skipped = 0;
+      while (subscription_->take(*newer, info)) {
+        std::swap(msg, newer);
+        ++skipped;
+      }
+      if (skipped > 0) {
+        dropped_count_ += skipped;
+        RCLCPP_WARN_STREAM_THROTTLE(
+          logger_, *clock_, 5000,
+          "skipped " << skipped << " stale frames on " << subscription_->get_topic_name()
+                     << " (total " << dropped_count_ << ")");
+      }
+    }
+    user_callback_(*msg);
+  }
+};
+}  // namespace yabloc::common
@@ -0,0 +1,121 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <Eigen/Core>
+
+#include <sensor_msgs/msg/point_cloud2.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace yabloc::common
+{
+// A line segment is stored as a point whose xyz is one end and normal_xyz is the other end.
+// This is the compact wire layout which publish_line_segments() writes.
+struct LineSegmentRecord
+{
+  float x, y, z;
+  float normal_x, normal_y, normal_z;
+  std::uint32_t label;
+};
+
+// Read-only view over the data of PointCloud2 which holds line segments.
+// The field layout is validated once at construction, and then the segments are read in place
+// without converting the message into pcl::PointCloud. Any layout which has FLOAT32 x, y, z,
+// normal_x, normal_y and normal_z (and optionally UINT32 label) is accepted, e.g. the one of
+// pcl::PointNormal, pcl::PointXYZLNormal or LineSegmentRecord.
+// A message with any other layout gives an invalid view, which is empty and tells the reason
+// through error(), so that a malformed message can be dropped without stopping the node.
+// The message must outlive the view.
+class LineSegmentsView
+{
+public:
+  struct Segment
+  {
+    Eigen::Vector3f from;
+    Eigen::Vector3f to;
+    std::uint32_t label;
+  };
+
+  class Iterator
+  {
+  public:
+    Iterator(const LineSegmentsView & view, size_t index) : view_(view), index_(index) {}
+    Segment operator*() const { return view_[index_]; }
+    Iterator & operator++()
+    {
+      ++index_;
+      return *this;
+    }
+    bool operator!=(const Iterator & other) const { return index_ != other.index_; }
+
+  private:
+    const LineSegmentsView & view_;
+    size_t index_;
+  };
+
+  explicit LineSegmentsView(const sensor_msgs::msg::PointCloud2 & msg);
+
+  // Return false if the message does not hold line segments
+  bool valid() const { return error_.empty(); }
+  const std::string & error() const { return error_; }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  bool has_label() const { return has_label_; }
+
+  Eigen::Vector3f from(size_t index) const { return read_vector(index, from_offsets_); }
+  Eigen::Vector3f to(size_t index) const { return read_vector(index, to_offsets_); }
+  // Return 0 if the message has no label field
+  std::uint32_t label(size_t index) const
+  {
+    if (!has_label_) return 0;
+    std::uint32_t value;
+    std::memcpy(&value, data_ + index * point_step_ + label_offset_, sizeof(value));
+    return value;
+  }
+
+  Segment operator[](size_t index) const { return {from(index), to(index), label(index)}; }
+  Iterator begin() const { return Iterator(*this, 0); }
+  Iterator end() const { return Iterator(*this, size_); }
+
+private:
+  const std::uint8_t * data_;
+  size_t size_{0};
+  size_t point_step_;
+  std::string error_;
+  std::uint32_t from_offsets_[3];
+  std::uint32_t to_offsets_[3];
+  std::uint32_t label_offset_{0};
+  bool has_label_{false};
+
+  // Fill the field offsets and return an error message, which is empty on success
+  std::string parse_layout(const sensor_msgs::msg::PointCloud2 & msg);
+
+  Eigen::Vector3f read_vector(size_t index, const std::uint32_t (&offsets)[3]) const
+  {
+    // memcpy keeps it safe for unaligned data and compiles to plain loads
+    const std::uint8_t * point = data_ + index * point_step_;
+    Eigen::Vector3f v;
+    for (int i = 0; i < 3; ++i) std::memcpy(&v[i], point + offsets[i], sizeof(float));
+    return v;
+  }
+};
+
+// Serialize records into PointCloud2 with a single memcpy
+sensor_msgs::msg::PointCloud2 to_line_segments_msg(const std::vector<LineSegmentRecord> & records);
+}  // namespace yabloc::common
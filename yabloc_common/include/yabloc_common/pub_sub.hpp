@@ -13,6 +13,8 @@
 // limitations under the License.
 
 #pragma once
+#include "yabloc_common/line_segments_view.hpp"
+
 #include <opencv4/opencv2/core.hpp>
 #include <rclcpp/rclcpp.hpp>
 
@@ -32,4 +34,9 @@ template <typename PointT>
 void publish_cloud(
   rclcpp::Publisher<sensor_msgs::msg::PointCloud2> & publisher,
   const pcl::PointCloud<PointT> & cloud, const rclcpp::Time & stamp);
+
+void publish_line_segments(
+  rclcpp::Publisher<sensor_msgs::msg::PointCloud2> & publisher,
+  const std::vector<LineSegmentRecord> & segments, const rclcpp::Time & stamp,
+  const std::string & frame_id = "map");
 }  // namespace yabloc::common
\ No newline at end of file
@@ -0,0 +1,64 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <rclcpp/rclcpp.hpp>
+
+#include <latency_msgs/msg/stage_stamp.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace yabloc::common
+{
+// Publish when a stage processed a frame to STAGE_STAMP_TOPIC, from which latency_monitor
+// reconstructs the end-to-end latency of each frame.
+class StageStampPublisher
+{
+public:
+  using StageStamp = latency_msgs::msg::StageStamp;
+  static constexpr const char * STAGE_STAMP_TOPIC = "/localization/yabloc/stage_stamp";
+
+  // Beginning of a stage on the node clock and on the steady clock
+  struct Start
+  {
+    rclcpp::Time stamp;
+    std::chrono::steady_clock::time_point steady;
+  };
+
+  StageStampPublisher(rclcpp::Node * node, const std::string & stage);
+
+  // `start` should be taken by start() at the beginning of the stage. The end is the time of call.
+  void publish(const rclcpp::Time & input_stamp, const Start & start) const;
+  void publish(
+    const rclcpp::Time & input_stamp, const rclcpp::Time & output_stamp,
+    const Start & start) const;
+
+  Start start() const { return {clock_->now(), std::chrono::steady_clock::now()}; }
+
+  // The count is sent along with every stamp, e.g. LatestOnlySubscription::dropped_count()
+  void set_drop_counter(std::function<uint64_t()> drop_counter)
+  {
+    drop_counter_ = std::move(drop_counter);
+  }
+
+private:
+  const std::string stage_;
+  rclcpp::Clock::SharedPtr clock_;
+  rclcpp::Publisher<StageStamp>::SharedPtr publisher_;
+  std::function<uint64_t()> drop_counter_{nullptr};
+};
+}  // namespace yabloc::common
@@ -15,46 +15,121 @@
 #pragma once
 #include <rclcpp/rclcpp.hpp>
 
-#include <message_filters/subscriber.h>
-#include <message_filters/sync_policies/approximate_time.h>
-#include <message_filters/time_synchronizer.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
 
 namespace yabloc::common
 {
+// Join two topics by their header stamps. Each topic is buffered in a small stamp-indexed queue
+// and a pair is passed to the callback as soon as both of its messages have arrived. Assuming
+// that each topic arrives in stamp order, entries which can never be matched any more are
+// discarded early: those older than the stamp just received on the other topic, and those older
+// than a matched pair. The discarded entries are counted.
 template <typename Msg1, typename Msg2>
 class SynchroSubscriber
 {
 public:
   using SharedPtr = std::shared_ptr<SynchroSubscriber>;
-  using Sub1 = message_filters::Subscriber<Msg1>;
-  using Sub2 = message_filters::Subscriber<Msg2>;
-  using SyncPolicy = message_filters::sync_policies::ApproximateTime<Msg1, Msg2>;
   using UserCallback = std::function<void(const Msg1 &, const Msg2 &)>;
 
-  SynchroSubscriber(rclcpp::Node * n, const std::string & topic1, const std::string & topic2)
+  // Two stamps are regarded as the same frame if they are closer than `tolerance`
+  SynchroSubscriber(
+    rclcpp::Node * n, const std::string & topic1, const std::string & topic2,
+    const rclcpp::Duration & tolerance = rclcpp::Duration::from_seconds(0.01),
+    size_t queue_size = 8)
+  : tolerance_(tolerance.nanoseconds()), queue_size_(queue_size)
   {
-    using std::placeholders::_1;
-    using std::placeholders::_2;
-    using Synchronizer = message_filters::Synchronizer<SyncPolicy>;
-
-    sub1_ = std::make_shared<Sub1>(n, topic1);
-    sub2_ = std::make_shared<Sub2>(n, topic2);
-    syncronizer_ = std::make_shared<Synchronizer>(SyncPolicy(80), *sub1_, *sub2_);
-    syncronizer_->registerCallback(std::bind(&SynchroSubscriber::raw_callback, this, _1, _2));
+    auto on_msg1 = [this](typename Msg1::ConstSharedPtr msg) -> void {
+      auto join = [this](const Msg1 & msg1, const Msg2 & msg2) { raw_callback(msg1, msg2); };
+      on_message<Msg1, Msg2>(msg, queue1_, queue2_, latest_stamp1_, latest_stamp2_, join);
+    };
+    auto on_msg2 = [this](typename Msg2::ConstSharedPtr msg) -> void {
+      auto join = [this](const Msg2 & msg2, const Msg1 & msg1) { raw_callback(msg1, msg2); };
+      on_message<Msg2, Msg1>(msg, queue2_, queue1_, latest_stamp2_, latest_stamp1_, join);
+    };
+    sub1_ = n->create_subscription<Msg1>(topic1, 10, std::move(on_msg1));
+    sub2_ = n->create_subscription<Msg2>(topic2, 10, std::move(on_msg2));
   }
 
   void set_callback(const UserCallback & callback) { user_callback_ = callback; }
 
+  // Number of messages discarded without being matched since the start
+  uint64_t dropped_count() const { return dropped_count_; }
+
 private:
-  std::shared_ptr<Sub1> sub1_;
-  std::shared_ptr<Sub2> sub2_;
-  std::shared_ptr<message_filters::Synchronizer<SyncPolicy>> syncronizer_;
+  template <typename Msg>
+  using Queue = std::map<int64_t, std::shared_ptr<const Msg>>;
+
+  const int64_t tolerance_;
+  const size_t queue_size_;
+
+  typename rclcpp::Subscription<Msg1>::SharedPtr sub1_;
+  typename rclcpp::Subscription<Msg2>::SharedPtr sub2_;
+  Queue<Msg1> queue1_;
+  Queue<Msg2> queue2_;
+  int64_t latest_stamp1_{INT64_MIN};
+  int64_t latest_stamp2_{INT64_MIN};
+  uint64_t dropped_count_{0};
   std::optional<UserCallback> user_callback_{std::nullopt};
 
-  void raw_callback(const typename Msg1::ConstPtr & msg1, const typename Msg2::ConstPtr & msg2)
+  template <typename Msg>
+  void discard_until(Queue<Msg> & queue, typename Queue<Msg>::iterator last)
+  {
+    dropped_count_ += std::distance(queue.begin(), last);
+    queue.erase(queue.begin(), last);
+  }
+
+  template <typename Own, typename Other, typename Join>
+  void on_message(
+    const std::shared_ptr<const Own> & msg, Queue<Own> & own_queue, Queue<Other> & other_queue,
+    int64_t & latest_own_stamp, const int64_t latest_other_stamp, const Join & join)
+  {
+    const int64_t stamp = rclcpp::Time(msg->header.stamp).nanoseconds();
+    latest_own_stamp = std::max(latest_own_stamp, stamp);
+
+    // This topic will never deliver a stamp older than this one any more, so the entries of the
+    // other topic before it can never be matched
+    discard_until(other_queue, other_queue.lower_bound(stamp - tolerance_));
+
+    // Pick the nearest stamp within the tolerance
+    auto matched = other_queue.end();
+    for (auto itr = other_queue.begin(); itr != other_queue.end(); ++itr) {
+      if (itr->first > stamp + tolerance_) break;
+      const bool is_nearer = matched == other_queue.end() ||
+                             std::abs(itr->first - stamp) < std::abs(matched->first - stamp);
+      if (is_nearer) matched = itr;
+    }
+
+    if (matched != other_queue.end()) {
+      const auto other_msg = matched->second;
+      discard_until(other_queue, matched);
+      other_queue.erase(other_queue.begin());
+      discard_until(own_queue, own_queue.lower_bound(stamp));
+      join(*msg, *other_msg);
+      return;
+    }
+
+    // The other topic has already passed this stamp
+    if (latest_other_stamp > stamp + tolerance_) {
+      ++dropped_count_;
+      return;
+    }
+
+    own_queue.emplace(stamp, msg);
+    if (own_queue.size() > queue_size_) discard_until(own_queue, std::next(own_queue.begin()));
+  }
+
+  void raw_callback(const Msg1 & msg1, const Msg2 & msg2)
   {
-    if (user_callback_.has_value()) user_callback_.value()(*msg1, *msg2);
+    if (user_callback_.has_value()) user_callback_.value()(msg1, msg2);
   }
 };
 
-}  // namespace yabloc::common
\ No newline at end of file
+}  // namespace yabloc::common
@@ -0,0 +1,63 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace yabloc::common
+{
+// Fixed number of worker threads which are started once and run the submitted tasks.
+// The threads are not OpenCV workers, so cv::parallel_for_ inside a task is still parallelized.
+class ThreadPool
+{
+public:
+  explicit ThreadPool(size_t thread_count);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool & operator=(const ThreadPool &) = delete;
+
+  // An exception thrown by the task is rethrown by std::future::get()
+  template <typename Task>
+  std::future<std::invoke_result_t<Task>> submit(Task && task)
+  {
+    using Result = std::invoke_result_t<Task>;
+    auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<Task>(task));
+    std::future<Result> future = packaged->get_future();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      tasks_.emplace([packaged]() { (*packaged)(); });
+    }
+    condition_.notify_one();
+    return future;
+  }
+
+private:
+  std::vector<std::thread> threads_;
+  std::queue<std::function<void()>> tasks_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  bool stopped_{false};
+
+  void loop();
+};
+}  // namespace yabloc::common
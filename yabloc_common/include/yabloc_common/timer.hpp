@@ -22,17 +22,17 @@ class Timer
 public:
   Timer() { reset(); }
 
-  void reset() { start = std::chrono::system_clock::now(); }
+  void reset() { start = std::chrono::steady_clock::now(); }
 
   long milli_seconds() const
   {
-    auto dur = std::chrono::system_clock::now() - start;
+    auto dur = std::chrono::steady_clock::now() - start;
     return std::chrono::duration_cast<std::chrono::milliseconds>(dur).count();
   }
 
   long micro_seconds() const
   {
-    auto dur = std::chrono::system_clock::now() - start;
+    auto dur = std::chrono::steady_clock::now() - start;
     return std::chrono::duration_cast<std::chrono::microseconds>(dur).count();
   }
 
@@ -43,7 +43,7 @@ public:
   }
 
 private:
-  std::chrono::time_point<std::chrono::system_clock> start;
+  std::chrono::time_point<std::chrono::steady_clock> start;
 };
 
 }  // namespace yabloc::common
\ No newline at end of file
@@ -0,0 +1,82 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include "yabloc_common/trace_config.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace yabloc::common::trace
+{
+// Nanoseconds on steady_clock
+inline int64_t now_ns()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch())
+    .count();
+}
+
+struct Event
+{
+  uint32_t span_id;
+  // Sequential id of the thread which recorded the event, not the one of OS
+  uint32_t thread_id;
+  int64_t start_ns;
+  int64_t duration_ns;
+};
+
+// Return the id of the span name. The same name always gives the same id in a process.
+uint32_t register_span(const std::string & name);
+std::string span_name(uint32_t span_id);
+
+// Push an event into the ring buffer of the calling thread without any lock.
+// If the buffer is full, the event is dropped and counted.
+void record(uint32_t span_id, int64_t start_ns, int64_t duration_ns);
+
+// Move the events of all threads into `events`, and return the number of events dropped since
+// the last call
+size_t drain(std::vector<Event> & events);
+
+class ScopedSpan
+{
+public:
+  explicit ScopedSpan(uint32_t span_id) : span_id_(span_id), start_ns_(now_ns()) {}
+  ~ScopedSpan() { record(span_id_, start_ns_, now_ns() - start_ns_); }
+
+  ScopedSpan(const ScopedSpan &) = delete;
+  ScopedSpan & operator=(const ScopedSpan &) = delete;
+
+private:
+  const uint32_t span_id_;
+  const int64_t start_ns_;
+};
+}  // namespace yabloc::common::trace
+
+// YABLOC_TRACE_SCOPE("node/stage") measures the rest of the enclosing scope.
+// The name is registered only once at the first pass. Without YABLOC_TRACING, it is expanded to
+// nothing.
+#ifdef YABLOC_TRACING
+#define YABLOC_TRACE_CONCAT_IMPL(a, b) a##b
+#define YABLOC_TRACE_CONCAT(a, b) YABLOC_TRACE_CONCAT_IMPL(a, b)
+#define YABLOC_TRACE_SCOPE(name)                                                   \
+  static const uint32_t YABLOC_TRACE_CONCAT(yabloc_trace_id_, __LINE__) =          \
+    ::yabloc::common::trace::register_span(name);                                  \
+  const ::yabloc::common::trace::ScopedSpan YABLOC_TRACE_CONCAT(                   \
+    yabloc_trace_span_, __LINE__)(YABLOC_TRACE_CONCAT(yabloc_trace_id_, __LINE__))
+#else
+#define YABLOC_TRACE_SCOPE(name) static_cast<void>(0)
+#endif
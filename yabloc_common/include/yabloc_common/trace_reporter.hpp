@@ -0,0 +1,67 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include "yabloc_common/latency_histogram.hpp"
+#include "yabloc_common/trace.hpp"
+
+#include <rclcpp/node.hpp>
+
+#include <diagnostic_msgs/msg/diagnostic_array.hpp>
+
+#include <fstream>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace yabloc::common
+{
+// Report the spans recorded by YABLOC_TRACE_SCOPE in this process.
+// Every `trace_report_period` [s], p50/p99/max of each span in the period are published to
+// /diagnostics. If `trace_file` is not empty, all events are also written into it in the Chrome
+// trace event format, which chrome://tracing and Perfetto can open.
+// Spans are collected process-wide, so only the first reporter in a process works even if several
+// nodes are composed. Without YABLOC_TRACING it does nothing.
+class TraceReporter
+{
+public:
+  using DiagnosticArray = diagnostic_msgs::msg::DiagnosticArray;
+
+  explicit TraceReporter(rclcpp::Node * node);
+  ~TraceReporter();
+
+  TraceReporter(const TraceReporter &) = delete;
+  TraceReporter & operator=(const TraceReporter &) = delete;
+
+private:
+  rclcpp::Node * node_;
+  bool active_{false};
+  rclcpp::Publisher<DiagnosticArray>::SharedPtr pub_diagnostics_;
+  rclcpp::TimerBase::SharedPtr timer_;
+
+  std::vector<trace::Event> events_;
+  std::map<uint32_t, LatencyHistogram> histograms_;
+  std::unordered_map<uint32_t, std::string> names_;
+  size_t dropped_{0};
+
+  std::ofstream trace_file_;
+  bool first_trace_event_{true};
+
+  void on_timer();
+  void collect();
+  void write_trace_events();
+  const std::string & name_of(uint32_t span_id);
+};
+}  // namespace yabloc::common
@@ -20,10 +20,37 @@
 #include <cv_bridge/cv_bridge.h>
 
 #include <iostream>
+#include <stdexcept>
 
 namespace yabloc::common
 {
-cv::Mat decompress_image(const sensor_msgs::msg::CompressedImage & compressed_img)
+int reduced_color_flag(int scale)
+{
+  switch (scale) {
+    case 1:
+      return cv::IMREAD_COLOR;
+    case 2:
+      return cv::IMREAD_REDUCED_COLOR_2;
+    case 4:
+      return cv::IMREAD_REDUCED_COLOR_4;
+    case 8:
+      return cv::IMREAD_REDUCED_COLOR_8;
+    default:
+      throw std::invalid_argument("decode scale must be 1, 2, 4 or 8");
+  }
+}
+
+void reduce_image(cv::Mat & image, int scale)
+{
+  if (scale <= 1) return;
+  // Round up in the same way as libjpeg does for its reduced output size
+  const cv::Size reduced_size((image.cols + scale - 1) / scale, (image.rows + scale - 1) / scale);
+  cv::resize(image, image, reduced_size, 0, 0, cv::INTER_AREA);
+}
+
+cv::Mat decompress_image(
+  const sensor_msgs::msg::CompressedImage & compressed_img, int scale = 1,
+  cv::Mat * luminance = nullptr)
 {
   cv::Mat raw_image;
 
@@ -31,14 +58,24 @@ cv::Mat decompress_image(const sensor_msgs::msg::CompressedImage & compressed_im
   const std::string encoding = format.substr(0, format.find(";"));
 
   constexpr int DECODE_GRAY = 0;
-  constexpr int DECODE_RGB = 1;
 
   bool encoding_is_bayer = encoding.find("bayer") != std::string::npos;
   if (!encoding_is_bayer) {
-    return cv::imdecode(cv::Mat(compressed_img.data), DECODE_RGB);
+    cv::Mat image = cv::imdecode(cv::Mat(compressed_img.data), reduced_color_flag(scale));
+    if (luminance) cv::cvtColor(image, *luminance, cv::COLOR_BGR2GRAY);
+    return image;
   }
 
   raw_image = cv::imdecode(cv::Mat(compressed_img.data), DECODE_GRAY);
+
+  // Binning already halves the resolution, so a full resolution demosaic is never needed
+  if (scale >= 2) {
+    cv::Mat image = debayer_by_binning(raw_image, encoding, luminance);
+    reduce_image(image, scale / 2);
+    if (luminance) reduce_image(*luminance, scale / 2);
+    return image;
+  }
+
   if (encoding == "bayer_rggb8")
     cv::cvtColor(raw_image, raw_image, cv::COLOR_BayerBG2BGR);
   else if (encoding == "bayer_bggr8")
@@ -52,14 +89,75 @@ cv::Mat decompress_image(const sensor_msgs::msg::CompressedImage & compressed_im
     std::cerr << "Please implement additional decoding in " << __FUNCTION__ << std::endl;
     exit(EXIT_FAILURE);
   }
+
+  if (luminance) cv::cvtColor(raw_image, *luminance, cv::COLOR_BGR2GRAY);
   return raw_image;
 }
 
+cv::Mat debayer_by_binning(
+  const cv::Mat & raw_image, const std::string & encoding, cv::Mat * luminance)
+{
+  // Position of R and B in a 2x2 cell as (x, y). The other two are G.
+  cv::Point r, b;
+  if (encoding == "bayer_rggb8")
+    r = {0, 0}, b = {1, 1};
+  else if (encoding == "bayer_bggr8")
+    r = {1, 1}, b = {0, 0};
+  else if (encoding == "bayer_grbg8")
+    r = {1, 0}, b = {0, 1};
+  else if (encoding == "bayer_gbrg8")
+    r = {0, 1}, b = {1, 0};
+  else
+    throw std::invalid_argument(encoding + " is not supported for binning");
+  const cv::Point g1(b.x, r.y), g2(r.x, b.y);
+
+  const cv::Size size(raw_image.cols / 2, raw_image.rows / 2);
+  cv::Mat bgr_image(size, CV_8UC3);
+  if (luminance) luminance->create(size, CV_8UC1);
+
+  cv::parallel_for_(cv::Range(0, size.height), [&](const cv::Range & range) {
+    for (int y = range.start; y < range.end; ++y) {
+      const uchar * rows[2] = {raw_image.ptr<uchar>(2 * y), raw_image.ptr<uchar>(2 * y + 1)};
+      cv::Vec3b * dst = bgr_image.ptr<cv::Vec3b>(y);
+      uchar * lum = luminance ? luminance->ptr<uchar>(y) : nullptr;
+      for (int x = 0; x < size.width; ++x) {
+        const int R = rows[r.y][2 * x + r.x];
+        const int B = rows[b.y][2 * x + b.x];
+        const int G = (rows[g1.y][2 * x + g1.x] + rows[g2.y][2 * x + g2.x] + 1) >> 1;
+        dst[x] = cv::Vec3b(B, G, R);
+        // BT.601 luma in 8bit fixed point, which matches COLOR_BGR2GRAY
+        if (lum) lum[x] = static_cast<uchar>((77 * R + 150 * G + 29 * B + 128) >> 8);
+      }
+    }
+  });
+  return bgr_image;
+}
+
 cv::Mat decompress_to_cv_mat(const sensor_msgs::msg::CompressedImage & compressed_img)
 {
   return decompress_image(compressed_img);
 }
 
+cv::Mat decompress_to_cv_mat(const sensor_msgs::msg::CompressedImage & compressed_img, int scale)
+{
+  return decompress_image(compressed_img, scale);
+}
+
+cv::Mat decompress_to_cv_mat(
+  const sensor_msgs::msg::CompressedImage & compressed_img, int scale, cv::Mat & luminance)
+{
+  return decompress_image(compressed_img, scale, &luminance);
+}
+
+int reduced_decode_scale(int src_width, int dst_width)
+{
+  if (dst_width <= 0) return 1;
+  for (int scale : {8, 4, 2}) {
+    if (src_width / scale >= dst_width) return scale;
+  }
+  return 1;
+}
+
 cv::Mat decompress_to_cv_mat(const sensor_msgs::msg::Image & img)
 {
   return cv_bridge::toCvCopy(std::make_shared<sensor_msgs::msg::Image>(img), img.encoding)->image;
@@ -73,4 +171,4 @@ sensor_msgs::msg::Image::ConstSharedPtr decompress_to_ros_msg(
   cv_image.encoding = encoding;
   return cv_image.toImageMsg();
 }
-}  // namespace yabloc::common
\ No newline at end of file
+}  // namespace yabloc::common
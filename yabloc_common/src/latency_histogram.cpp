@@ -0,0 +1,70 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yabloc_common/latency_histogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace yabloc::common
+{
+int LatencyHistogram::bucket_index(uint64_t value)
+{
+  if (value < SUB_BUCKETS) return static_cast<int>(value);
+
+  // The top SUB_BUCKET_BITS + 1 bits of the value decide the bucket
+  const int msb = 63 - __builtin_clzll(value);
+  const int shift = msb - SUB_BUCKET_BITS;
+  return (shift + 1) * SUB_BUCKETS + static_cast<int>((value >> shift) - SUB_BUCKETS);
+}
+
+int64_t LatencyHistogram::bucket_value(int index)
+{
+  if (index < SUB_BUCKETS) return index;
+
+  const int shift = index / SUB_BUCKETS - 1;
+  const int64_t lower = static_cast<int64_t>(SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+  return lower + ((int64_t{1} << shift) >> 1);
+}
+
+void LatencyHistogram::add(int64_t value)
+{
+  value = std::max<int64_t>(value, 0);
+  counts_[bucket_index(value)]++;
+  count_++;
+  max_ = std::max(max_, value);
+}
+
+void LatencyHistogram::reset()
+{
+  counts_.fill(0);
+  count_ = 0;
+  max_ = 0;
+}
+
+int64_t LatencyHistogram::percentile(double p) const
+{
+  if (count_ == 0) return 0;
+
+  const uint64_t rank = std::clamp<uint64_t>(std::ceil(p / 100.0 * count_), 1, count_);
+  if (rank == count_) return max_;
+
+  uint64_t accumulated = 0;
+  for (int i = 0; i < BUCKET_COUNT; ++i) {
+    accumulated += counts_[i];
+    if (accumulated >= rank) return std::min(bucket_value(i), max_);
+  }
+  return max_;
+}
+}  // namespace yabloc::common
@@ -0,0 +1,117 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yabloc_common/line_segments_view.hpp"
+
+#include <sensor_msgs/msg/point_field.hpp>
+
+#include <cstddef>
+#include <optional>
+#include <string>
+
+namespace yabloc::common
+{
+using PointField = sensor_msgs::msg::PointField;
+
+namespace
+{
+// Return the offset of the field, or nullopt if it is missing or malformed.
+// error is filled only in the latter case.
+std::optional<std::uint32_t> find_field(
+  const sensor_msgs::msg::PointCloud2 & msg, const std::string & name, std::uint8_t datatype,
+  std::string & error)
+{
+  for (const PointField & field : msg.fields) {
+    if (field.name != name) continue;
+    if (field.datatype != datatype || field.count != 1) {
+      error = "field '" + name + "' has unexpected type";
+      return std::nullopt;
+    }
+    if (field.offset + 4 > msg.point_step) {
+      error = "field '" + name + "' is out of point_step";
+      return std::nullopt;
+    }
+    return field.offset;
+  }
+  return std::nullopt;
+}
+}  // namespace
+
+LineSegmentsView::LineSegmentsView(const sensor_msgs::msg::PointCloud2 & msg)
+: data_(msg.data.data()), point_step_(msg.point_step)
+{
+  error_ = parse_layout(msg);
+  if (valid()) size_ = static_cast<size_t>(msg.width) * msg.height;
+}
+
+std::string LineSegmentsView::parse_layout(const sensor_msgs::msg::PointCloud2 & msg)
+{
+  if (msg.is_bigendian) return "big endian cloud is not supported";
+  const size_t size = static_cast<size_t>(msg.width) * msg.height;
+  if (msg.data.size() < size * point_step_) return "cloud data is truncated";
+
+  std::string error;
+  const char * from_names[3] = {"x", "y", "z"};
+  const char * to_names[3] = {"normal_x", "normal_y", "normal_z"};
+  for (int i = 0; i < 3; ++i) {
+    auto from = find_field(msg, from_names[i], PointField::FLOAT32, error);
+    auto to = find_field(msg, to_names[i], PointField::FLOAT32, error);
+    if (!error.empty()) return error;
+    if (!from.has_value() || !to.has_value()) {
+      return "cloud does not have the fields of line segments";
+    }
+    from_offsets_[i] = from.value();
+    to_offsets_[i] = to.value();
+  }
+
+  // The label is optional, but a malformed one is still an error
+  auto label = find_field(msg, "label", PointField::UINT32, error);
+  if (!error.empty()) return error;
+  if (label.has_value()) {
+    label_offset_ = label.value();
+    has_label_ = true;
+  }
+  return {};
+}
+
+sensor_msgs::msg::PointCloud2 to_line_segments_msg(const std::vector<LineSegmentRecord> & records)
+{
+  sensor_msgs::msg::PointCloud2 msg;
+  auto add_field = [&msg](const std::string & name, size_t offset, std::uint8_t datatype) {
+    PointField field;
+    field.name = name;
+    field.offset = offset;
+    field.datatype = datatype;
+    field.count = 1;
+    msg.fields.push_back(field);
+  };
+  add_field("x", offsetof(LineSegmentRecord, x), PointField::FLOAT32);
+  add_field("y", offsetof(LineSegmentRecord, y), PointField::FLOAT32);
+  add_field("z", offsetof(LineSegmentRecord, z), PointField::FLOAT32);
+  add_field("normal_x", offsetof(LineSegmentRecord, normal_x), PointField::FLOAT32);
+  add_field("normal_y", offsetof(LineSegmentRecord, normal_y), PointField::FLOAT32);
+  add_field("normal_z", offsetof(LineSegmentRecord, normal_z), PointField::FLOAT32);
+  add_field("label", offsetof(LineSegmentRecord, label), PointField::UINT32);
+
+  msg.height = 1;
+  msg.width = records.size();
+  msg.is_bigendian = false;
+  msg.is_dense = true;
+  msg.point_step = sizeof(LineSegmentRecord);
+  msg.row_step = msg.point_step * msg.width;
+  msg.data.resize(msg.row_step);
+  if (!records.empty()) std::memcpy(msg.data.data(), records.data(), msg.row_step);
+  return msg;
+}
+}  // namespace yabloc::common
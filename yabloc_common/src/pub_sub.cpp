@@ -52,6 +52,17 @@ void publish_cloud(
   publisher.publish(cloud_msg);
 }
 
+void publish_line_segments(
+  rclcpp::Publisher<sensor_msgs::msg::PointCloud2> & publisher,
+  const std::vector<LineSegmentRecord> & segments, const rclcpp::Time & stamp,
+  const std::string & frame_id)
+{
+  sensor_msgs::msg::PointCloud2 cloud_msg = to_line_segments_msg(segments);
+  cloud_msg.header.stamp = stamp;
+  cloud_msg.header.frame_id = frame_id;
+  publisher.publish(cloud_msg);
+}
+
 template void publish_cloud<pcl::PointXYZ>(
   rclcpp::Publisher<sensor_msgs::msg::PointCloud2> &, const pcl::PointCloud<pcl::PointXYZ> &,
   const rclcpp::Time &);
@@ -0,0 +1,45 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yabloc_common/stage_stamp_publisher.hpp"
+
+namespace yabloc::common
+{
+StageStampPublisher::StageStampPublisher(rclcpp::Node * node, const std::string & stage)
+: stage_(stage), clock_(node->get_clock())
+{
+  publisher_ = node->create_publisher<StageStamp>(STAGE_STAMP_TOPIC, 100);
+}
+
+void StageStampPublisher::publish(
+  const rclcpp::Time & input_stamp, const Start & start) const
+{
+  publish(input_stamp, input_stamp, start);
+}
+
+void StageStampPublisher::publish(
+  const rclcpp::Time & input_stamp, const rclcpp::Time & output_stamp,
+  const Start & start) const
+{
+  StageStamp msg;
+  msg.stage = stage_;
+  msg.input_stamp = input_stamp;
+  msg.output_stamp = output_stamp;
+  msg.start = start.stamp;
+  msg.end = clock_->now();
+  msg.processing = rclcpp::Duration(std::chrono::steady_clock::now() - start.steady);
+  if (drop_counter_) msg.dropped = drop_counter_();
+  publisher_->publish(msg);
+}
+}  // namespace yabloc::common
@@ -0,0 +1,122 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yabloc_common/trace.hpp"
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace yabloc::common::trace
+{
+namespace
+{
+// Single-producer single-consumer ring buffer. The owner thread pushes and drain() pops.
+class EventRing
+{
+public:
+  explicit EventRing(uint32_t thread_id) : thread_id_(thread_id) {}
+
+  void push(uint32_t span_id, int64_t start_ns, int64_t duration_ns)
+  {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) >= CAPACITY) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    events_[head & (CAPACITY - 1)] = {span_id, thread_id_, start_ns, duration_ns};
+    head_.store(head + 1, std::memory_order_release);
+  }
+
+  size_t pop_all(std::vector<Event> & events)
+  {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    const size_t head = head_.load(std::memory_order_acquire);
+    for (size_t i = tail; i != head; ++i) events.push_back(events_[i & (CAPACITY - 1)]);
+    tail_.store(head, std::memory_order_release);
+    return dropped_.exchange(0, std::memory_order_relaxed);
+  }
+
+private:
+  // It must be a power of 2
+  static constexpr size_t CAPACITY = 4096;
+
+  const uint32_t thread_id_;
+  std::array<Event, CAPACITY> events_;
+  // head_ and tail_ are written by different threads, so they are kept on separate cache lines
+  alignas(64) std::atomic<size_t> head_{0};
+  alignas(64) std::atomic<size_t> tail_{0};
+  std::atomic<size_t> dropped_{0};
+};
+
+struct Registry
+{
+  // It guards registrations and drain(), never record()
+  std::mutex mutex;
+  std::vector<std::shared_ptr<EventRing>> rings;
+  std::vector<std::string> names;
+  std::unordered_map<std::string, uint32_t> ids;
+};
+
+Registry & registry()
+{
+  // Intentionally leaked so that threads which exit after main() can still touch it
+  static Registry * registry = new Registry;
+  return *registry;
+}
+
+EventRing & local_ring()
+{
+  thread_local std::shared_ptr<EventRing> ring = [] {
+    Registry & r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.rings.push_back(std::make_shared<EventRing>(r.rings.size()));
+    return r.rings.back();
+  }();
+  return *ring;
+}
+}  // namespace
+
+uint32_t register_span(const std::string & name)
+{
+  Registry & r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  auto [itr, inserted] = r.ids.emplace(name, r.names.size());
+  if (inserted) r.names.push_back(name);
+  return itr->second;
+}
+
+std::string span_name(uint32_t span_id)
+{
+  Registry & r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  return span_id < r.names.size() ? r.names[span_id] : "unknown";
+}
+
+void record(uint32_t span_id, int64_t start_ns, int64_t duration_ns)
+{
+  local_ring().push(span_id, start_ns, duration_ns);
+}
+
+size_t drain(std::vector<Event> & events)
+{
+  Registry & r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  size_t dropped = 0;
+  for (const auto & ring : r.rings) dropped += ring->pop_all(events);
+  return dropped;
+}
+}  // namespace yabloc::common::trace
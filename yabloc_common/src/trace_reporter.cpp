@@ -0,0 +1,147 @@
+// Copyright 2023 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "yabloc_common/trace_reporter.hpp"
+
+#include <unistd.h>
+
+#include <atomic>
+#include <iomanip>
+#include <sstream>
+
+namespace yabloc::common
+{
+namespace
+{
+std::atomic<bool> reporter_exists{false};
+
+std::string to_ms_string(int64_t ns)
+{
+  std::stringstream ss;
+  ss << std::fixed << std::setprecision(3) << ns * 1e-6;
+  return ss.str();
+}
+
+diagnostic_msgs::msg::KeyValue key_value(const std::string & key, const std::string & value)
+{
+  diagnostic_msgs::msg::KeyValue kv;
+  kv.key = key;
+  kv.value = value;
+  return kv;
+}
+}  // namespace
+
+TraceReporter::TraceReporter(rclcpp::Node * node) : node_(node)
+{
+#ifdef YABLOC_TRACING
+  const double period = node->declare_parameter<double>("trace_report_period", 1.0);
+  const std::string trace_file = node->declare_parameter<std::string>("trace_file", "");
+
+  if (reporter_exists.exchange(true)) return;
+  active_ = true;
+
+  if (!trace_file.empty()) {
+    trace_file_.open(trace_file);
+    if (trace_file_)
+      trace_file_ << "[\n";
+    else
+      RCLCPP_WARN_STREAM(node->get_logger(), "failed to open trace file " << trace_file);
+  }
+
+  pub_diagnostics_ = node->create_publisher<DiagnosticArray>("/diagnostics", 10);
+  timer_ = node->create_wall_timer(
+    std::chrono::duration<double>(period), std::bind(&TraceReporter::on_timer, this));
+#endif
+}
+
+TraceReporter::~TraceReporter()
+{
+  if (!active_) return;
+  collect();
+  if (trace_file_) trace_file_ << "\n]\n";
+  reporter_exists = false;
+}
+
+void TraceReporter::collect()
+{
+  events_.clear();
+  dropped_ += trace::drain(events_);
+  for (const trace::Event & event : events_) histograms_[event.span_id].add(event.duration_ns);
+  if (trace_file_) write_trace_events();
+}
+
+void TraceReporter::on_timer()
+{
+  collect();
+
+  DiagnosticArray array;
+  array.header.stamp = node_->now();
+  for (auto & [span_id, histogram] : histograms_) {
+    if (histogram.count() == 0) continue;
+
+    const std::string p50 = to_ms_string(histogram.percentile(50));
+    const std::string p99 = to_ms_string(histogram.percentile(99));
+    const std::string max = to_ms_string(histogram.max());
+
+    diagnostic_msgs::msg::DiagnosticStatus status;
+    status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+    status.name = "yabloc_trace: " + name_of(span_id);
+    status.hardware_id = "yabloc";
+    status.message = "p50 " + p50 + "ms p99 " + p99 + "ms max " + max + "ms";
+    status.values.push_back(key_value("count", std::to_string(histogram.count())));
+    status.values.push_back(key_value("p50[ms]", p50));
+    status.values.push_back(key_value("p99[ms]", p99));
+    status.values.push_back(key_value("max[ms]", max));
+    array.status.push_back(status);
+
+    // Statistics are of each period
+    histogram.reset();
+  }
+
+  if (dropped_ > 0) {
+    // Ring buffers overflowed because spans are recorded faster than this period can drain
+    diagnostic_msgs::msg::DiagnosticStatus status;
+    status.level = diagnostic_msgs::msg::DiagnosticStatus::WARN;
+    status.name = "yabloc_trace: dropped";
+    status.hardware_id = "yabloc";
+    status.message = std::to_string(dropped_) + " events are dropped";
+    array.status.push_back(status);
+    dropped_ = 0;
+  }
+
+  if (!array.status.empty()) pub_diagnostics_->publish(array);
+}
+
+void TraceReporter::write_trace_events()
+{
+  static const int pid = getpid();
+  trace_file_ << std::fixed << std::setprecision(3);
+  for (const trace::Event & event : events_) {
+    if (!first_trace_event_) trace_file_ << ",\n";
+    first_trace_event_ = false;
+    // Complete events ("ph": "X") in microseconds
+    trace_file_ << R"({"name":")" << name_of(event.span_id) << R"(","ph":"X","ts":)"
+                << event.start_ns * 1e-3 << R"(,"dur":)" << event.duration_ns * 1e-3
+                << R"(,"pid":)" << pid << R"(,"tid":)" << event.thread_id << "}";
+  }
+  trace_file_.flush();
+}
+
+const std::string & TraceReporter::name_of(uint32_t span_id)
+{
+  auto itr = names_.find(span_id);
+  if (itr == names_.end()) itr = names_.emplace(span_id, trace::span_name(span_id)).first;
+  return itr->second;
+}
+}  // namespace yabloc::common